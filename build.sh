@@ -1,5 +1,5 @@
 mkdir -p build
 cd build/
 cmake -S ../ -B ./
-make && make Shaders && ./MoonLight
+make && make Meshes && ./MoonLight
 cd ../
\ No newline at end of file
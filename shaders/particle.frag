@@ -0,0 +1,46 @@
+#version 450
+
+layout (location = 0) in vec3 fragColor;
+layout (location = 1) in vec3 fragPosWorld;
+layout (location = 2) in vec3 fragNormalWorld;
+
+layout (location = 0) out vec4 outColor;
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+struct DirectionalLight 
+{
+  vec4 position;  // ignore w
+  vec4 color;     // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  DirectionalLight directionLight;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+void main() {  
+  vec3 surfaceNormal = normalize(fragNormalWorld);
+  vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+  vec3 diffuseLight = vec3(0.0);
+
+  for (int i = 0; i < ubo.numLights; i++) {
+    PointLight light = ubo.pointLights[i];
+    vec3 directionToLight = light.position.xyz - fragPosWorld;
+    float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
+    float cosAngIncidence = max(dot(surfaceNormal, normalize(directionToLight)), 0);
+    diffuseLight += light.color.xyz * light.color.w * attenuation * cosAngIncidence;
+  }
+
+  vec3 sunLightColor = ubo.directionLight.color.xyz * ubo.directionLight.color.w;
+  vec3 sunLight = sunLightColor * max(dot(surfaceNormal, normalize(ubo.directionLight.position.xyz)), 0);
+
+  outColor = vec4((diffuseLight + ambientLight + sunLight) * fragColor, 1.0);
+}
@@ -0,0 +1,52 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 octahedralNormal;
+layout(location = 3) in vec2 uv;
+layout(location = 4) in uint layerIndex;
+
+// per instance attributes
+layout(location = 5) in vec4 instancePositionScale; // w is scale
+layout(location = 6) in vec4 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+struct DirectionalLight 
+{
+  vec4 position;  // ignore w
+  vec4 color;     // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  DirectionalLight directionToLight;
+  vec4 ambientLightColor; // w is intensity
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+// normals come octahedral encoded, see Model::PackedVertex
+vec3 decodeNormal(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
+void main() {
+  // particles are uniformly scaled and never rotated, so the normal needs no matrix
+  vec3 positionWorld = position * instancePositionScale.w + instancePositionScale.xyz;
+  gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
+  fragNormalWorld = decodeNormal(octahedralNormal);
+  fragPosWorld = positionWorld;
+  fragColor = color * instanceColor.rgb;
+}
@@ -1,10 +1,12 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
 layout (location = 2) in vec3 fragNormalWorld;
 layout (location = 3) in vec2 fragUv;
 layout(location = 4) flat in int fragLayerIndex;
+layout(location = 5) flat in uint fragTextureIndex;
 
 layout (location = 0) out vec4 outColor;
 
@@ -28,11 +30,8 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout (set = 1, binding = 1) uniform sampler2DArray diffuseMap;
-
-layout(push_constant) uniform Push {
-  vec3 color;
-} push;
+// every texture in the TextureTable, instances of one draw can pick different ones
+layout (set = 2, binding = 0) uniform sampler2DArray textures[];
 
 void main() {  
   vec3 sunLightColor = ubo.directionLight.color.xyz * ubo.directionLight.color.w;
@@ -73,6 +72,6 @@ void main() {
   blinnTerm = pow(blinnTerm, 512.0); // higher values -> sharper highlight
   specularLight += sunLightColor * blinnTerm;
 
-  vec3 color = texture(diffuseMap, vec3(fragUv, fragLayerIndex)).xyz;
+  vec3 color = texture(textures[nonuniformEXT(fragTextureIndex)], vec3(fragUv, fragLayerIndex)).xyz;
   outColor = vec4(((diffuseLight + ambientLight + sunLight) * fragColor * color) + (specularLight * fragColor), 1.0);
 }
@@ -2,15 +2,16 @@
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+layout(location = 2) in vec2 octahedralNormal;
 layout(location = 3) in vec2 uv;
-layout(location = 4) in int layerIndex;
+layout(location = 4) in uint layerIndex;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUv;
 layout(location = 4) flat out int fragLayerIndex;
+layout(location = 5) flat out uint fragTextureIndex;
 
 struct PointLight {
   vec4 position; // ignore w
@@ -32,21 +33,49 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(set = 1, binding = 0) uniform GameObjectBufferData {
+struct ObjectInstance {
+  vec4 color;
+  uint textureIndex;    // slot in the texture table
+  uint meshIndex;       // only read by the culling passes
+  uint transformIndex;  // the entity index of the game object
+};
+// GameObjectBufferData
+struct ObjectTransform {
   mat4 modelMatrix;
   mat4 normalMatrix;
-} gameObject;
+};
 
-layout(push_constant) uniform Push {
-  vec3 color;
-} push;
+// every object with a model, whether it is visible or not
+layout(std430, set = 1, binding = 0) readonly buffer ObjectInstances {
+  ObjectInstance instances[];
+};
+// the objects that survived culling, every draw starts at its own first instance so gl_InstanceIndex
+// indexes the whole frame's list
+layout(std430, set = 1, binding = 1) readonly buffer VisibleObjects {
+  uint visibleObjects[];
+};
+// every game object, indexed by entity index
+layout(std430, set = 1, binding = 2) readonly buffer ObjectTransforms {
+  ObjectTransform transforms[];
+};
+
+// normals come octahedral encoded, see Model::PackedVertex
+vec3 decodeNormal(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
 
 void main() {
-  vec4 positionWorld = gameObject.modelMatrix * vec4(position, 1.0);
+  ObjectInstance instance = instances[visibleObjects[gl_InstanceIndex]];
+  ObjectTransform transform = transforms[instance.transformIndex];
+  vec4 positionWorld = transform.modelMatrix * vec4(position, 1.0);
   gl_Position = ubo.projection * ubo.view * positionWorld;
-  fragNormalWorld = normalize(mat3(gameObject.normalMatrix) * normal);
+  fragNormalWorld = normalize(mat3(transform.normalMatrix) * decodeNormal(octahedralNormal));
   fragPosWorld = positionWorld.xyz;
-  fragColor = color * push.color;
+  fragColor = color * instance.color.rgb;
   fragUv = uv;
-  fragLayerIndex = layerIndex;
+  fragLayerIndex = int(layerIndex);
+  fragTextureIndex = instance.textureIndex;
 }
@@ -1,5 +1,14 @@
 #include "gravity_app.hpp"
 
+#include "../libs/imgui/imgui.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <utility>
 
 void GravityApp::start()
 {
@@ -10,17 +19,25 @@ void GravityApp::start()
     simpleRenderSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
     pointLightSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
     gridSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+    particleRenderSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+    galaxyCompute.createPipeline();
+    galaxyModel = assets.getPlaceholderModel();
+    assets.loadModel("assets/models/sphere.obj", [this](std::shared_ptr<mnlt::Model> model) { galaxyModel = model; });
 
     loadPhysicsObjects();
 }
 void GravityApp::renderSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo)
 {
     simpleRenderSystem.renderGameObjects(frameInfo);
+    particleRenderSystem.renderParticles(frameInfo, *galaxyModel, galaxyCompute.getInstanceBuffer(), galaxyCompute.getParticleCount());
     pointLightSystem.renderLights(frameInfo, ubo);
     if(camera.enableGrid)
         gridSystem.render(frameInfo);
     ui.newFrame();
     ui.runExample(frameInfo);
+    gravitySystem.createGravityUI();
+    createGalaxyUI();
+    createRenderUI();
     ui.render(commandBuffer);
 }
 void GravityApp::update(mnlt::Time time)
@@ -28,132 +45,446 @@ void GravityApp::update(mnlt::Time time)
     camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), 0.1f, 1000.f);
     camera.move(window.getGLFWwindow(), time.getPureDeltaTime());
     
-    gravitySystem.update(&gameObjectManager.gameObjects, time, 100);
+    if (requestedGalaxyBodies >= 0)
+    {
+        spawnGalaxy(requestedGalaxyBodies);
+        requestedGalaxyBodies = -1;
+    }
+
+    int steps = fixedTimestep.advance(time);
+    double stepTime = fixedTimestep.getStepTime(time);
+    gravitySystem.update(gameObjectManager.registry, stepTime, steps);
+    galaxySteps = steps;
+    galaxyStepTime = stepTime;
 }
+void GravityApp::computeSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo)
+{
+    simpleRenderSystem.cullGameObjects(frameInfo);
+
+    if (galaxyCompute.getParticleCount() == 0) return;
+    if (galaxySteps <= 0 && !galaxyNeedsInstances) return;
+
+    GravityComputePushConstants push{};
+    push.deltaTime = static_cast<float>(galaxyStepTime / gravitySystem.substeps);
+    push.strength = gravitySystem.strengthGravity;
+    push.minDistanceSquared = GravityPhysicsSystem::MIN_DISTANCE_SQUARED;
+    push.particleScale = galaxyBodyScale;
+    push.particleCount = galaxyCompute.getParticleCount();
+
+    // a zero length step leaves the bodies where they are but still writes their instances
+    int dispatches = galaxySteps * gravitySystem.substeps;
+    if (dispatches <= 0)
+    {
+        push.deltaTime = 0.f;
+        dispatches = 1;
+    }
 
-void GravityPhysicsSystem::update(mnlt::GameObject::Map* physicsObjs, mnlt::Time time, int substeps) 
+    // type 0 is the central mass, type 1 the disk
+    galaxyCompute.beginDispatches(commandBuffer, {}, {{1.f, 0.8f, 0.3f, 1.f}, {0.6f, 0.7f, 1.f, 1.f}});
+    for (int i = 0; i < dispatches; i++)
+        galaxyCompute.dispatch(commandBuffer, &push);
+    galaxyCompute.endDispatches(commandBuffer);
+    galaxyNeedsInstances = false;
+}
+void GravityApp::spawnGalaxy(int count)
 {
-    for(int i=0; i<substeps; i++)
-        stepSimulation(physicsObjs, time.getDeltaTime() / substeps);
+    mnlt::ParticleStore galaxy;
+    if (count > 0)
+    {
+        const float centralMass = 1.989e24f;
+        const float diskMass = 0.1f * centralMass;
+        const float innerRadius = 5.f;
+        const float outerRadius = 60.f;
+        const float bodyMass = diskMass / count;
+
+        std::default_random_engine eng{std::random_device{}()};
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        galaxy.reserve(count + 1);
+        galaxy.addParticle({0.f, 0.f, 0.f}, centralMass, 0);
+        for (int i = 0; i < count; i++)
+        {
+            // uniform over the disk area, on a circular orbit around everything inside its radius
+            float radiusSquared = innerRadius * innerRadius + unit(eng) * (outerRadius * outerRadius - innerRadius * innerRadius);
+            float radius = glm::sqrt(radiusSquared);
+            float angle = unit(eng) * glm::two_pi<float>();
+            float height = (unit(eng) - 0.5f) * 0.02f * radius;
+            float enclosedMass = centralMass + diskMass * (radiusSquared - innerRadius * innerRadius) / (outerRadius * outerRadius - innerRadius * innerRadius);
+            float speed = glm::sqrt(gravitySystem.strengthGravity * enclosedMass / radius);
+
+            uint32_t body = galaxy.addParticle({radius * glm::cos(angle), height, radius * glm::sin(angle)}, bodyMass, 1);
+            galaxy.setVelocity(body, speed * glm::vec3{-glm::sin(angle), 0.f, glm::cos(angle)});
+        }
+    }
+    galaxyCompute.upload(galaxy);
+    galaxyNeedsInstances = true;
 }
-glm::vec3 GravityPhysicsSystem::computeForce(mnlt::GameObject& fromObj, mnlt::GameObject& toObj) const {
-    auto offset = fromObj.transform.translation - toObj.transform.translation;
-    float distanceSquared = glm::dot(offset, offset);
+void GravityApp::createGalaxyUI()
+{
+    ImGui::Begin("GPU Galaxy");
+    ImGui::DragInt("Bodies", &galaxyBodyCount, 64.f, 256, 1 << 18);
+    ImGui::DragFloat("Body Scale", &galaxyBodyScale, 0.01f, 0.01f, 2.f);
+    if (ImGui::Button("Spawn"))
+        requestedGalaxyBodies = galaxyBodyCount;
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        requestedGalaxyBodies = 0;
+    ImGui::Text("%u bodies, %d dispatches per frame", galaxyCompute.getParticleCount(), galaxySteps * gravitySystem.substeps);
+    ImGui::End();
+}
+void GravityApp::createRenderUI()
+{
+    ImGui::Begin("Rendering");
+    // only gpu culling has anything to compare
+    if (ImGui::Button("Check gpu culling") && !simpleRenderSystem.requestCullingCheck())
+        cullingCheckUnavailable = true;
+    const auto& check = simpleRenderSystem.getCullingCheck();
+    if (cullingCheckUnavailable)
+        ImGui::Text("Culling runs on the cpu on this device");
+    else if (check.finished)
+        ImGui::Text("Kept %u objects on the gpu, %u on the cpu%s", check.gpuVisibleCount, check.cpuVisibleCount,
+            check.gpuVisibleCount == check.cpuVisibleCount ? "" : ", MISMATCH");
+    ImGui::End();
+}
+
+void GravityPhysicsSystem::update(mnlt::Registry& registry, double stepTime, int steps) 
+{
+    if (steps <= 0) return;
 
-    // clown town - just going to return 0 if objects are too close together...
-    if (glm::abs(distanceSquared) < 0.1f) 
+    auto stepStart = std::chrono::high_resolution_clock::now();
+    // velocity verlet keeps the last step's accelerations as the start of the next one, which only
+    // holds while nothing but the integrator moved the bodies
+    if (gatherBodies(registry))
+        integrator->reset();
+    auto computeBodyAccelerations = [this](const mnlt::ParticleStore& state, std::vector<glm::vec3>& result)
     {
-        return {0.0f, 0.0f, 0.0f};
+        computeAccelerations(solver, state, result);
+    };
+    float deltaTime = static_cast<float>(stepTime / substeps);
+    for (int i = 0; i < steps * substeps; i++)
+        integrator->step(bodies, deltaTime, computeBodyAccelerations);
+    stepMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - stepStart).count();
+
+    if (showDiagnostics)
+        updateDiagnostics();
+    scatterBodies(registry);
+}
+bool GravityPhysicsSystem::gatherBodies(mnlt::Registry& registry)
+{
+    gatheredBodies.clear();
+    gatheredBodies.reserve(registry.pool<mnlt::RigidBodyComponent>().size());
+    registry.each<mnlt::RigidBodyComponent, mnlt::TransformComponent>(
+        [&](mnlt::Entity entity, mnlt::RigidBodyComponent& rigidBody, mnlt::TransformComponent& transform)
+    {
+        uint32_t i = gatheredBodies.addParticle(transform.translation, rigidBody.mass, 0);
+        gatheredBodies.setVelocity(i, rigidBody.velocity);
+    });
+
+    // bodies still holds exactly what the last update scattered
+    bool changed = gatheredBodies.positionX != bodies.positionX || gatheredBodies.positionY != bodies.positionY
+        || gatheredBodies.positionZ != bodies.positionZ || gatheredBodies.velocityX != bodies.velocityX
+        || gatheredBodies.velocityY != bodies.velocityY || gatheredBodies.velocityZ != bodies.velocityZ
+        || gatheredBodies.mass != bodies.mass;
+    std::swap(bodies, gatheredBodies);
+    return changed;
+}
+void GravityPhysicsSystem::scatterBodies(mnlt::Registry& registry) const
+{
+    // no components are added or removed during the update, so the query visits the bodies in the same order as the gather
+    size_t i = 0;
+    registry.each<mnlt::RigidBodyComponent, mnlt::TransformComponent>(
+        [&](mnlt::Entity entity, mnlt::RigidBodyComponent& rigidBody, mnlt::TransformComponent& transform)
+    {
+        transform.translation = bodies.getPosition(i);
+        rigidBody.velocity = bodies.getVelocity(i);
+        i++;
+    });
+}
+void GravityPhysicsSystem::setIntegrator(mnlt::IntegratorType type)
+{
+    integratorType = type;
+    integrator = mnlt::Integrator::create(type);
+}
+void GravityPhysicsSystem::computeAccelerations(GravitySolver method, const mnlt::ParticleStore& state, std::vector<glm::vec3>& result)
+{
+    if (method == GravitySolver::DirectSum)
+    {
+        directSumPairs(state, result);
+        return;
     }
 
-    float force = strengthGravity * toObj.rigidBody.mass * fromObj.rigidBody.mass / distanceSquared;
-    return force * offset / glm::sqrt(distanceSquared);
+    const auto& kernels = mnlt::getForceKernels(simdLevel);
+    size_t count = state.size();
+    result.resize(count);
+    tree.build(state.positionX.data(), state.positionY.data(), state.positionZ.data(), state.mass.data(), count);
+
+    // the tree is read only from here on, so every body can walk it in parallel
+    jobSystem.parallelFor(count, 64, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            result[i] = tree.acceleration(state.getPosition(i), theta, strengthGravity, MIN_DISTANCE_SQUARED, kernels);
+        }
+    });
 }
-void GravityPhysicsSystem::stepSimulation(mnlt::GameObject::Map* physicsObjs, float deltaTime) 
+void GravityPhysicsSystem::directSumPairs(const mnlt::ParticleStore& state, std::vector<glm::vec3>& result)
 {
-    // Loops through all pairs of objects and applies attractive force between them
-    for (auto iterA = physicsObjs->begin(); iterA != physicsObjs->end(); ++iterA) 
+    const auto& kernels = mnlt::getForceKernels(simdLevel);
+    size_t count = state.size();
+    result.resize(count);
+    if (count == 0) return;
+
+    // rows get shorter towards the end, so chunks are cut at equal pair counts instead of equal rows
+    size_t chunkCount = std::min<size_t>(jobSystem.getWorkerCount() + 1, std::max<size_t>(count / 64, 1));
+    size_t pairsPerChunk = (count * (count - 1) / 2 + chunkCount - 1) / chunkCount;
+    pairChunkStart.assign(1, 0);
+    size_t pairs = 0;
+    for (size_t i = 0; i < count && pairChunkStart.size() < chunkCount; i++)
+    {
+        pairs += count - 1 - i;
+        if (pairs >= pairsPerChunk * pairChunkStart.size())
+            pairChunkStart.push_back(i + 1);
+    }
+    pairChunkStart.push_back(count);
+    chunkCount = pairChunkStart.size() - 1;
+    pairAccelerations.resize(chunkCount * 3 * count);
+
+    jobSystem.parallelFor(chunkCount, 1, [&](size_t firstChunk, size_t lastChunk)
     {
-        auto& objA = *iterA;
-        for (auto iterB = iterA; iterB != physicsObjs->end(); ++iterB) 
+        for (size_t chunk = firstChunk; chunk < lastChunk; chunk++)
         {
-            if (iterA == iterB) continue;
-            auto& objB = *iterB;
-    
-            auto force = computeForce(objA.second, objB.second);
-            objA.second.rigidBody.velocity += deltaTime * -force / objA.second.rigidBody.mass;
+            float* accelerationX = pairAccelerations.data() + chunk * 3 * count;
+            float* accelerationY = accelerationX + count;
+            float* accelerationZ = accelerationY + count;
+            std::fill(accelerationX, accelerationX + 3 * count, 0.f);
+
+            for (size_t i = pairChunkStart[chunk]; i < pairChunkStart[chunk + 1]; i++)
+            {
+                size_t next = i + 1;
+                glm::vec3 pull = kernels.gravityPairs(
+                    state.positionX.data() + next,
+                    state.positionY.data() + next,
+                    state.positionZ.data() + next,
+                    state.mass.data() + next,
+                    count - next,
+                    state.getPosition(i),
+                    state.mass[i],
+                    strengthGravity,
+                    MIN_DISTANCE_SQUARED,
+                    accelerationX + next,
+                    accelerationY + next,
+                    accelerationZ + next);
+                accelerationX[i] += pull.x;
+                accelerationY[i] += pull.y;
+                accelerationZ[i] += pull.z;
+            }
+        }
+    });
+    jobSystem.parallelFor(count, 1024, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            glm::vec3 acceleration{0.f};
+            for (size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                const float* slice = pairAccelerations.data() + chunk * 3 * count;
+                acceleration += glm::vec3{slice[i], slice[count + i], slice[2 * count + i]};
+            }
+            result[i] = acceleration;
+        }
+    });
+}
+double GravityPhysicsSystem::totalEnergy() const
+{
+    size_t count = bodies.size();
+    std::vector<double> rowEnergy(count);
+    jobSystem.parallelFor(count, 64, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            glm::dvec3 velocity{bodies.getVelocity(i)};
+            double energy = 0.5 * bodies.mass[i] * glm::dot(velocity, velocity);
+            for (size_t j = i + 1; j < count; j++)
+            {
+                glm::dvec3 offset = glm::dvec3{bodies.getPosition(j)} - glm::dvec3{bodies.getPosition(i)};
+                double distanceSquared = glm::dot(offset, offset);
+                if (distanceSquared < MIN_DISTANCE_SQUARED) continue;
+                energy -= strengthGravity * static_cast<double>(bodies.mass[i]) * bodies.mass[j] / std::sqrt(distanceSquared);
+            }
+            rowEnergy[i] = energy;
+        }
+    });
+    double energy = 0.0;
+    for (double row : rowEnergy)
+    {
+        energy += row;
+    }
+    return energy;
+}
+void GravityPhysicsSystem::updateDiagnostics()
+{
+    // rms of the force error relative to the rms force, per body ratios blow up for bodies in balance
+    computeAccelerations(solver, bodies, accelerations);
+    computeAccelerations(GravitySolver::DirectSum, bodies, referenceAccelerations);
+    double errorSquared = 0.0;
+    double referenceSquared = 0.0;
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        glm::dvec3 error = glm::dvec3{accelerations[i]} - glm::dvec3{referenceAccelerations[i]};
+        errorSquared += glm::dot(error, error);
+        referenceSquared += glm::dot(glm::dvec3{referenceAccelerations[i]}, glm::dvec3{referenceAccelerations[i]});
+    }
+    forceError = referenceSquared > 0.0 ? static_cast<float>(std::sqrt(errorSquared / referenceSquared)) : 0.f;
+
+    double energy = totalEnergy();
+    if (initialEnergy == 0.0)
+        initialEnergy = energy;
+    energyDrift = initialEnergy != 0.0 ? std::abs((energy - initialEnergy) / initialEnergy) : 0.0;
+}
+void GravityPhysicsSystem::createGravityUI()
+{
+    ImGui::Begin("Gravity");
+    if (ImGui::BeginCombo("Force Kernel", mnlt::simdLevelName(simdLevel)))
+    {
+        for (auto level : mnlt::supportedSimdLevels())
+        {
+            if (ImGui::Selectable(mnlt::simdLevelName(level), level == simdLevel))
+                simdLevel = level;
         }
+        ImGui::EndCombo();
     }
-    // update each objects position based on its final velocity
-    for (auto& obj : *physicsObjs) 
+    int solverIndex = static_cast<int>(solver);
+    if (ImGui::Combo("Solver", &solverIndex, "Direct Sum\0Barnes-Hut\0"))
+    {
+        solver = static_cast<GravitySolver>(solverIndex);
+        integrator->reset();
+        initialEnergy = 0.0;
+    }
+    if (solver == GravitySolver::BarnesHut)
+    {
+        if (ImGui::SliderFloat("Theta", &theta, 0.f, 1.5f))
+            integrator->reset();
+        ImGui::Text("Octree nodes: %zu", tree.getNodeCount());
+    }
+    if (ImGui::BeginCombo("Integrator", mnlt::Integrator::getName(integratorType)))
+    {
+        for (auto type : {mnlt::IntegratorType::SemiImplicitEuler, mnlt::IntegratorType::VelocityVerlet, mnlt::IntegratorType::RungeKutta4})
+        {
+            if (ImGui::Selectable(mnlt::Integrator::getName(type), type == integratorType))
+            {
+                setIntegrator(type);
+                initialEnergy = 0.0;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SliderInt("Substeps", &substeps, 1, 100);
+    ImGui::Text("Force evaluations per step: %d", substeps * integrator->getEvaluationsPerStep());
+    ImGui::Text("Update: %.3f ms (%zu bodies, %u workers)", stepMilliseconds, bodies.size(), jobSystem.getWorkerCount() + 1);
+
+    if (ImGui::Checkbox("Diagnostics", &showDiagnostics))
+        initialEnergy = 0.0;
+    if (showDiagnostics)
     {
-        obj.second.transform.translation += deltaTime * obj.second.rigidBody.velocity;
+        ImGui::Text("Force error vs direct sum: %.3e", forceError);
+        ImGui::Text("Energy drift: %.3e", energyDrift);
+        if (ImGui::Button("Reset Energy"))
+            initialEnergy = 0.0;
     }
+    ImGui::End();
 }
 
 
 void GravityApp::loadPhysicsObjects()
 {
     // Create the Sun
-    auto& sun = gameObjectManager.createGameObject();
-    sun.name = "Sun";
-    sun.transform.scale = glm::vec3{1.f}; // Increase the size for better visualization
-    sun.transform.translation = {0.0f, 0.0f, 0.0f};
-    sun.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    sun.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/sun.jpg"});
-    sun.rigidBody.velocity = {.0f, .0f, .0f};
-    sun.rigidBody.mass = 1.989e24f; // Sun's mass is significantly higher
+    auto sun = gameObjectManager.createGameObject();
+    sun.add<mnlt::RigidBodyComponent>();
+    sun.name() = "Sun";
+    sun.transform().scale = glm::vec3{1.f}; // Increase the size for better visualization
+    sun.transform().translation = {0.0f, 0.0f, 0.0f};
+    streamGameObject(sun, "assets/models/sphere.obj", {"assets/textures/sun.jpg"});
+    sun.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, .0f};
+    sun.get<mnlt::RigidBodyComponent>().mass = 1.989e24f; // Sun's mass is significantly higher
     // Create Planets
     // Mercury
-    auto& mercury = gameObjectManager.createGameObject();
-    mercury.name = "Mercury";
-    mercury.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    mercury.transform.translation = {57.9e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    mercury.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    mercury.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/mercury.jpg"});
-    mercury.rigidBody.mass = 3.285e16f; // Adjust mass relative to Earth
-    mercury.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (mercury.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto mercury = gameObjectManager.createGameObject();
+    mercury.add<mnlt::RigidBodyComponent>();
+    mercury.name() = "Mercury";
+    mercury.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    mercury.transform().translation = {57.9e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(mercury, "assets/models/sphere.obj", {"assets/textures/mercury.jpg"});
+    mercury.get<mnlt::RigidBodyComponent>().mass = 3.285e16f; // Adjust mass relative to Earth
+    mercury.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (mercury.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // Venus
-    auto& venus = gameObjectManager.createGameObject();
-    venus.name = "Venus";
-    venus.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    venus.transform.translation = {108.2e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    venus.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    venus.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/venus.jpg"});
-    venus.rigidBody.mass = 4.867e17f; // Adjust mass relative to Earth
-    venus.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (venus.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto venus = gameObjectManager.createGameObject();
+    venus.add<mnlt::RigidBodyComponent>();
+    venus.name() = "Venus";
+    venus.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    venus.transform().translation = {108.2e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(venus, "assets/models/sphere.obj", {"assets/textures/venus.jpg"});
+    venus.get<mnlt::RigidBodyComponent>().mass = 4.867e17f; // Adjust mass relative to Earth
+    venus.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (venus.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // Earth
-    auto& earth = gameObjectManager.createGameObject();
-    earth.name = "Earth";
-    earth.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    earth.transform.translation = {149.6e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    earth.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    earth.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/earth.jpg"});
-    earth.rigidBody.mass = 5.972e17f; // Mass of Earth
-    earth.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (earth.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto earth = gameObjectManager.createGameObject();
+    earth.add<mnlt::RigidBodyComponent>();
+    earth.name() = "Earth";
+    earth.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    earth.transform().translation = {149.6e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(earth, "assets/models/sphere.obj", {"assets/textures/earth.jpg"});
+    earth.get<mnlt::RigidBodyComponent>().mass = 5.972e17f; // Mass of Earth
+    earth.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (earth.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
+    // The Moon, carried along by the Earth instead of simulated
+    auto moon = gameObjectManager.createGameObject();
+    moon.name() = "Moon";
+    moon.transform().scale = glm::vec3{0.27f};
+    moon.transform().translation = {2.0f, 0.0f, 0.0f}; // Position relative to the earth
+    moon.color() = {0.7f, 0.7f, 0.7f};
+    streamGameObject(moon, "assets/models/sphere.obj");
+    gameObjectManager.setParent(moon, earth);
     // Mars
-    auto& mars = gameObjectManager.createGameObject();
-    mars.name = "Mars";
-    mars.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    mars.transform.translation = {227.9e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    mars.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    mars.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/mars.jpg"});
-    mars.rigidBody.mass = 6.39e16f; // Adjust mass relative to Earth
-    mars.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (mars.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto mars = gameObjectManager.createGameObject();
+    mars.add<mnlt::RigidBodyComponent>();
+    mars.name() = "Mars";
+    mars.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    mars.transform().translation = {227.9e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(mars, "assets/models/sphere.obj", {"assets/textures/mars.jpg"});
+    mars.get<mnlt::RigidBodyComponent>().mass = 6.39e16f; // Adjust mass relative to Earth
+    mars.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (mars.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // jupitar
-    auto& jupitar = gameObjectManager.createGameObject();
-    jupitar.name = "Jupitar";
-    jupitar.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    jupitar.transform.translation = {778.6e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    jupitar.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    jupitar.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/jupitar.jpg"});
-    jupitar.rigidBody.mass = 1.898e20f; // Adjust mass relative to Earth
-    jupitar.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (jupitar.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto jupitar = gameObjectManager.createGameObject();
+    jupitar.add<mnlt::RigidBodyComponent>();
+    jupitar.name() = "Jupitar";
+    jupitar.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    jupitar.transform().translation = {778.6e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(jupitar, "assets/models/sphere.obj", {"assets/textures/jupitar.jpg"});
+    jupitar.get<mnlt::RigidBodyComponent>().mass = 1.898e20f; // Adjust mass relative to Earth
+    jupitar.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (jupitar.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // Saturn
-    auto& saturn = gameObjectManager.createGameObject();
-    saturn.name = "Saturn";
-    saturn.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    saturn.transform.translation = {1433.5e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    saturn.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    saturn.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/saturn.jpg"});
-    saturn.rigidBody.mass = 5.683e19f; // Adjust mass relative to Earth
-    saturn.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (saturn.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto saturn = gameObjectManager.createGameObject();
+    saturn.add<mnlt::RigidBodyComponent>();
+    saturn.name() = "Saturn";
+    saturn.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    saturn.transform().translation = {1433.5e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(saturn, "assets/models/sphere.obj", {"assets/textures/saturn.jpg"});
+    saturn.get<mnlt::RigidBodyComponent>().mass = 5.683e19f; // Adjust mass relative to Earth
+    saturn.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (saturn.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // Uranus
-    auto& uranus = gameObjectManager.createGameObject();
-    uranus.name = "Uranus";
-    uranus.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    uranus.transform.translation = {2872.5e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    uranus.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    uranus.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/missing.png"});
-    uranus.rigidBody.mass = 8.681e18f; // Adjust mass relative to Earth
-    uranus.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (uranus.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity
+    auto uranus = gameObjectManager.createGameObject();
+    uranus.add<mnlt::RigidBodyComponent>();
+    uranus.name() = "Uranus";
+    uranus.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    uranus.transform().translation = {2872.5e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(uranus, "assets/models/sphere.obj", {"assets/textures/missing.png"});
+    uranus.get<mnlt::RigidBodyComponent>().mass = 8.681e18f; // Adjust mass relative to Earth
+    uranus.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (uranus.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity
     // Neptune
-    auto& Neptune = gameObjectManager.createGameObject();
-    Neptune.name = "Neptune";
-    Neptune.transform.scale = glm::vec3{1.0f}; // Adjust scale
-    Neptune.transform.translation = {4495.1e-1f, 0.0f, 0.0f}; // Position relative to the sun
-    Neptune.model = mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj");
-    Neptune.diffuseMap = mnlt::Texture::createTextureFromFile(device, {"assets/textures/neptune.jpg"});
-    Neptune.rigidBody.mass = 1.024e19f; // Adjust mass relative to Earth
-    Neptune.rigidBody.velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.rigidBody.mass / (Neptune.transform.translation.x - sun.transform.translation.x)))}; // Adjust initial velocity 
+    auto Neptune = gameObjectManager.createGameObject();
+    Neptune.add<mnlt::RigidBodyComponent>();
+    Neptune.name() = "Neptune";
+    Neptune.transform().scale = glm::vec3{1.0f}; // Adjust scale
+    Neptune.transform().translation = {4495.1e-1f, 0.0f, 0.0f}; // Position relative to the sun
+    streamGameObject(Neptune, "assets/models/sphere.obj", {"assets/textures/neptune.jpg"});
+    Neptune.get<mnlt::RigidBodyComponent>().mass = 1.024e19f; // Adjust mass relative to Earth
+    Neptune.get<mnlt::RigidBodyComponent>().velocity = {.0f, .0f, (glm::sqrt(gravitySystem.strengthGravity * sun.get<mnlt::RigidBodyComponent>().mass / (Neptune.transform().translation.x - sun.transform().translation.x)))}; // Adjust initial velocity 
 }
@@ -1,21 +1,84 @@
 #pragma once
 
 #include "mnlt/app.hpp"
+#include "mnlt/compute_systems/particle_compute_system.hpp"
+#include "mnlt/physics/barnes_hut.hpp"
+#include "mnlt/physics/force_kernels.hpp"
+#include "mnlt/physics/integrator.hpp"
+#include "mnlt/physics/particle_store.hpp"
 #include "mnlt/render_systems/3d_grid_system.hpp"
+#include "mnlt/render_systems/particle_render_system.hpp"
 #include "mnlt/render_systems/point_light_system.hpp"
 #include "mnlt/render_systems/simple_render_system.hpp"
 #include "mnlt/ui.hpp"
 
+enum class GravitySolver
+{
+    DirectSum, // exact O(n^2) sum, the reference the approximations are measured against
+    BarnesHut,
+};
+// push constants of shaders/gravity.comp
+struct GravityComputePushConstants
+{
+    float deltaTime;
+    float strength;
+    float minDistanceSquared;
+    float particleScale;
+    uint32_t particleCount;
+};
 class GravityPhysicsSystem
 {
     public:
-        GravityPhysicsSystem(float strength) : strengthGravity{strength} {}
+        GravityPhysicsSystem(mnlt::JobSystem& jobSystem, float strength) : strengthGravity{strength}, jobSystem{jobSystem} {}
         const float strengthGravity;
-        void update(mnlt::GameObject::Map* physicsObjs, mnlt::Time time, int substeps);
-        glm::vec3 computeForce(mnlt::GameObject& fromObj, mnlt::GameObject& toObj) const;
+        // runs steps fixed steps of stepTime each, every one split into substeps integrator steps
+        void update(mnlt::Registry& registry, double stepTime, int steps);
+        void createGravityUI();
+
+        mnlt::SimdLevel simdLevel = mnlt::bestSimdLevel();
+        GravitySolver solver = GravitySolver::DirectSum;
+        // opening angle, nodes smaller than theta times their distance are treated as one mass
+        float theta = 0.5f;
+        int substeps = 4;
+        void setIntegrator(mnlt::IntegratorType type);
+
+        // bodies closer than this don't pull on each other
+        static constexpr float MIN_DISTANCE_SQUARED = 0.1f;
         
     private:
-        void stepSimulation(mnlt::GameObject::Map* physicsObjs, float deltaTime);
+        // returns whether the bodies differ from what the last update scattered, added, removed or edited
+        bool gatherBodies(mnlt::Registry& registry);
+        void scatterBodies(mnlt::Registry& registry) const;
+        void computeAccelerations(GravitySolver method, const mnlt::ParticleStore& state, std::vector<glm::vec3>& result);
+        // direct sum that visits every pair once and applies the force to both bodies
+        void directSumPairs(const mnlt::ParticleStore& state, std::vector<glm::vec3>& result);
+        // kinetic plus potential energy of the bodies, in double since the terms nearly cancel
+        double totalEnergy() const;
+        void updateDiagnostics();
+
+        mnlt::JobSystem& jobSystem;
+
+        // bodies are copied into structure-of-arrays form once per update so every substep
+        // runs the force kernel over contiguous arrays instead of walking the map
+        mnlt::ParticleStore bodies;
+        mnlt::ParticleStore gatheredBodies;
+        std::vector<glm::vec3> accelerations;
+        mnlt::BarnesHutTree tree;
+        mnlt::IntegratorType integratorType = mnlt::IntegratorType::VelocityVerlet;
+        std::unique_ptr<mnlt::Integrator> integrator = mnlt::Integrator::create(integratorType);
+
+        // every pair chunk accumulates into its own slice, x, y and z arrays of the body count each,
+        // and the slices are summed in chunk order so the result doesn't depend on thread timing
+        std::vector<float> pairAccelerations;
+        std::vector<size_t> pairChunkStart;
+        float stepMilliseconds = 0.f;
+
+        // compares the active solver against the direct sum every update, costs a full O(n^2) pass
+        bool showDiagnostics = false;
+        std::vector<glm::vec3> referenceAccelerations;
+        float forceError = 0.f;
+        double initialEnergy = 0.0;
+        double energyDrift = 0.0;
 };
 class GravityApp : public mnlt::App 
 {
@@ -23,14 +86,35 @@ class GravityApp : public mnlt::App
         void start() override;
         void renderSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
         void update(mnlt::Time time) override;
+        void computeSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
 
     private:
         void loadPhysicsObjects();
+        // replaces the gpu galaxy with count bodies orbiting a sun mass, 0 removes it
+        void spawnGalaxy(int count);
+        void createGalaxyUI();
+        void createRenderUI();
+
+        GravityPhysicsSystem gravitySystem{jobSystem, 6.674e-18f};
+        mnlt::FixedTimestep fixedTimestep{};
 
-        GravityPhysicsSystem gravitySystem{6.674e-18f};
+        // a disk of bodies that is stepped by shaders/gravity.comp and drawn straight from the
+        // instances it writes, separate from the game objects so it can scale to many more bodies
+        mnlt::ParticleComputeSystem galaxyCompute{device, *globalPool, "shaders/gravity.comp.spv", sizeof(GravityComputePushConstants)};
+        mnlt::ParticleRenderSystem particleRenderSystem{device};
+        std::shared_ptr<mnlt::Model> galaxyModel;
+        int galaxyBodyCount = 4096;
+        // spawning replaces buffers, so the ui only requests it and update() does it between frames
+        int requestedGalaxyBodies = -1;
+        float galaxyBodyScale = 0.1f;
+        int galaxySteps = 0;
+        double galaxyStepTime = 0.0;
+        // nothing has written the instances of a freshly spawned galaxy yet
+        bool galaxyNeedsInstances = false;
+        bool cullingCheckUnavailable = false;
 
 
-        mnlt::SimpleRenderSystem simpleRenderSystem{device};
+        mnlt::SimpleRenderSystem simpleRenderSystem{device, textureTable};
         mnlt::PointLightSystem pointLightSystem{device};
         mnlt::GridSystem gridSystem{device};
         mnlt::UI ui{window, device};
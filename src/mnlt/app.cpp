@@ -32,6 +32,7 @@ namespace mnlt
                                     .setMaxSets(1000)
                                     .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000)
                                     .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000)
+                                    .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000)
                                     .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
         for (int i = 0; i < framePools.size(); i++) {
             framePools[i] = framePoolBuilder.build();
@@ -87,12 +88,19 @@ namespace mnlt
             {
                 int frameIndex = renderer.getFrameIndex();
                 framePools[frameIndex]->resetPool();
-                FrameInfo frameInfo{frameIndex, time, commandBuffer, camera, globalDescriptorSets[frameIndex], *framePools[frameIndex], gameObjectManager.gameObjects};
+                FrameInfo frameInfo{frameIndex, time, commandBuffer, camera, globalDescriptorSets[frameIndex], *framePools[frameIndex], gameObjectManager.registry, gameObjectManager, renderer.getSwapChainExtent()};
 
+                // swaps streamed assets in before anything looks at the game objects this frame
+                assets.update();
+                textureTable.update();
                 update(time);
                 // final step of update is updating the game objects buffer data
                 // The render functions MUST not change a game objects transform data
                 gameObjectManager.updateBuffer(frameIndex);
+                // everything uploaded up to here is readable from this frame on
+                device.uploads().submit(commandBuffer);
+
+                computeSystems(commandBuffer, frameInfo);
         
                 renderer.beginSwapChainRenderPass(commandBuffer);
                 renderSystems(commandBuffer, frameInfo);
@@ -112,4 +120,21 @@ namespace mnlt
 
         vkDeviceWaitIdle(device.device());
     }
+
+    void App::streamGameObject(GameObject gameObject, const std::string &modelPath, const std::vector<std::string> &texturePaths)
+    {
+        // looked up by entity, the object may be gone by the time its assets are ready
+        auto entity = gameObject.getEntity();
+        gameObjectManager.setModel(gameObject, assets.getPlaceholderModel());
+        assets.loadModel(modelPath, [this, entity](std::shared_ptr<Model> model)
+        {
+            if (auto *component = gameObjectManager.registry.tryGet<ModelComponent>(entity)) component->model = model;
+        });
+
+        if (texturePaths.empty()) return;
+        assets.loadTexture(texturePaths, [this, entity](std::shared_ptr<Texture> texture)
+        {
+            if (auto *component = gameObjectManager.registry.tryGet<ModelComponent>(entity)) component->diffuseMap = texture;
+        });
+    }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "asset_streamer.hpp"
 #include "camera.hpp"
 #include "frame_info.hpp"
 #include "window.hpp"
@@ -7,6 +8,8 @@
 #include "game_object.hpp"
 #include "renderer.hpp"
 #include "descriptors.hpp"
+#include "job_system.hpp"
+#include "texture_table.hpp"
 
 
 namespace mnlt
@@ -28,10 +31,21 @@ namespace mnlt
             virtual void start() = 0;
             virtual void renderSystems(VkCommandBuffer commandBuffer, FrameInfo frameInfo) = 0;
             virtual void update(Time time) = 0;
+            // records compute dispatches into the frame's command buffer ahead of the render pass,
+            // so anything they write is ready for renderSystems() without a separate submit
+            virtual void computeSystems(VkCommandBuffer commandBuffer, FrameInfo frameInfo) {}
 
+            // gives the game object the placeholder model right away and swaps in its streamed model
+            // and texture as they become ready, so loading never holds up start()
+            void streamGameObject(GameObject gameObject, const std::string &modelPath, const std::vector<std::string> &texturePaths = {});
+
+            // declared first so it outlives everything that may still have jobs in flight
+            JobSystem jobSystem{};
             Window window{WIDTH, HEIGHT, "MoonLight"};
             Device device{window};
             Renderer renderer{window, device};
+            TextureTable textureTable{device};
+            AssetStreamer assets{device, textureTable};
             Camera camera{};
             std::unique_ptr<DescriptorSetLayout> globalSetLayout;
 
@@ -39,6 +53,6 @@ namespace mnlt
             std::unique_ptr<DescriptorPool> globalPool;
             GlobalUbo ubo;
             std::vector<std::unique_ptr<DescriptorPool>> framePools;
-            GameObjectManager gameObjectManager{device};
+            GameObjectManager gameObjectManager{device, jobSystem};
     };
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "asset_cache.hpp"
+
+#include "swap_chain.hpp"
+#include "utils.hpp"
+
+// std
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#define ENGINE_DIR "../"
+
+namespace mnlt
+{
+    AssetCache::AssetCache(Device &device, TextureTable *textureTable, JobSystem *jobSystem, VkDeviceSize budget)
+        : device{device}, textureTable{textureTable}, jobSystem{jobSystem}, budget{budget} {}
+
+    std::shared_ptr<Model> AssetCache::getModel(const std::string &filepath)
+    {
+        uint64_t key = fileKey({filepath});
+        return get(models, key, [&]() { return std::shared_ptr<Model>{Model::createModelFromFile(device, filepath, jobSystem)}; });
+    }
+
+    std::shared_ptr<Texture> AssetCache::getTexture(const std::vector<std::string> &filepaths)
+    {
+        uint64_t key = fileKey(filepaths);
+        return get(textures, key, [&]() { return std::shared_ptr<Texture>{Texture::createTextureFromFile(device, filepaths)}; });
+    }
+
+    void AssetCache::update()
+    {
+        std::vector<std::shared_ptr<void>> released;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            frame++;
+            if (memorySize > budget)
+            {
+                evict(budget);
+            }
+            while (!retired.empty() && retired.front().first + SwapChain::MAX_FRAMES_IN_FLIGHT < frame)
+            {
+                released.push_back(std::move(retired.front().second));
+                retired.pop_front();
+            }
+        }
+        // destroyed here, outside the lock
+    }
+
+    void AssetCache::trim()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        evict(0);
+    }
+
+    void AssetCache::setBudget(VkDeviceSize newBudget)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        budget = newBudget;
+    }
+
+    VkDeviceSize AssetCache::getBudget()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return budget;
+    }
+
+    AssetCacheStats AssetCache::getStats()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        AssetCacheStats stats{};
+        stats.modelCount = static_cast<uint32_t>(models.size());
+        stats.textureCount = static_cast<uint32_t>(textures.size());
+        stats.memorySize = memorySize;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        return stats;
+    }
+
+    template <typename T, typename Load>
+    std::shared_ptr<T> AssetCache::get(Entries<T> &entries, uint64_t key, Load &&load)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            hits++;
+            it->second.lastUse = ++useCounter;
+            auto asset = it->second.asset;
+            lock.unlock();
+            // waits when another thread is still loading it
+            return asset.get();
+        }
+
+        misses++;
+        std::promise<std::shared_ptr<T>> promise;
+        Entry<T> &entry = entries[key];
+        entry.asset = promise.get_future().share();
+        entry.lastUse = ++useCounter;
+        lock.unlock();
+
+        std::shared_ptr<T> asset;
+        try
+        {
+            asset = load();
+        }
+        catch (...)
+        {
+            // forget the failure so a later request tries again, waiting requests still see the error
+            lock.lock();
+            entries.erase(key);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        // entries that are still loading are never evicted, so the reference is still valid
+        lock.lock();
+        entry.loaded = true;
+        entry.memorySize = asset->getMemorySize();
+        memorySize += entry.memorySize;
+        promise.set_value(asset);
+        if (memorySize > budget)
+        {
+            evict(budget);
+        }
+        return asset;
+    }
+
+    template <typename T>
+    void AssetCache::collectUnused(Entries<T> &entries, bool isModel, std::vector<EvictionCandidate> &candidates)
+    {
+        for (auto &kv : entries)
+        {
+            if (!kv.second.loaded) continue;
+
+            // the cache's own copy is the only one left, besides the texture table's
+            long references = 1;
+            if constexpr (std::is_same_v<T, Texture>)
+            {
+                if (textureTable && textureTable->isRegistered(kv.second.asset.get().get())) references++;
+            }
+            if (kv.second.asset.get().use_count() == references)
+            {
+                candidates.push_back({kv.second.lastUse, isModel, kv.first});
+            }
+        }
+    }
+
+    template <typename T>
+    void AssetCache::retire(Entries<T> &entries, uint64_t key)
+    {
+        auto it = entries.find(key);
+        if constexpr (std::is_same_v<T, Texture>)
+        {
+            if (textureTable) textureTable->release(it->second.asset.get().get());
+        }
+        memorySize -= it->second.memorySize;
+        retired.emplace_back(frame, it->second.asset.get());
+        entries.erase(it);
+        evictions++;
+    }
+
+    void AssetCache::evict(VkDeviceSize target)
+    {
+        std::vector<EvictionCandidate> candidates;
+        collectUnused(models, true, candidates);
+        collectUnused(textures, false, candidates);
+        std::sort(candidates.begin(), candidates.end(),
+            [](const EvictionCandidate &a, const EvictionCandidate &b) { return a.lastUse < b.lastUse; });
+
+        for (auto &candidate : candidates)
+        {
+            if (memorySize <= target) break;
+            if (candidate.isModel)
+            {
+                retire(models, candidate.key);
+            }
+            else
+            {
+                retire(textures, candidate.key);
+            }
+        }
+    }
+
+    uint64_t AssetCache::fileKey(const std::vector<std::string> &filepaths)
+    {
+        // starts from the empty hash and folds in every file's path, size and modification time
+        uint64_t hash = fnv1a(nullptr, 0);
+        for (auto &filepath : filepaths)
+        {
+            std::error_code error;
+            std::string path = std::filesystem::weakly_canonical(ENGINE_DIR + filepath, error).string();
+            if (error)
+            {
+                path = ENGINE_DIR + filepath;
+            }
+
+            uint64_t size = std::filesystem::file_size(path, error);
+            if (error)
+            {
+                throw std::runtime_error("failed to open file: " + path);
+            }
+            int64_t modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+            if (error)
+            {
+                throw std::runtime_error("failed to open file: " + path);
+            }
+
+            hash = fnv1a(path.data(), path.size() + 1, hash);
+            hash = fnv1a(&size, sizeof(size), hash);
+            hash = fnv1a(&modified, sizeof(modified), hash);
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "device.hpp"
+#include "job_system.hpp"
+#include "model.hpp"
+#include "texture.hpp"
+#include "texture_table.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mnlt
+{
+    struct AssetCacheStats
+    {
+        uint32_t modelCount = 0;
+        uint32_t textureCount = 0;
+        // device memory of every cached asset, shared or not
+        VkDeviceSize memorySize = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    // Hands out shared models and textures keyed by their files, so every object that uses sphere.obj
+    // draws the same vertex buffer and the file is only parsed and uploaded once.
+    //
+    // A file is keyed by its canonical path, size and modification time, so different spellings of a
+    // path share an asset and a file changed on disk is loaded again, without reading the file.
+    //
+    // Cached assets stay loaded while nothing else holds them, until the cached memory goes over the
+    // budget. Then the least recently requested unused assets are evicted, and released a few frames
+    // later so draws still in flight can finish with them. A texture the TextureTable holds counts as
+    // unused when the table's reference is the only other one, and gives its slot back on eviction.
+    //
+    // Thread safe, concurrent requests for the same content wait on a single load.
+    class AssetCache
+    {
+        public:
+            static constexpr VkDeviceSize DEFAULT_BUDGET = 512ull * 1024 * 1024;
+
+            // jobSystem splits up the import of large obj files
+            AssetCache(Device &device, TextureTable *textureTable = nullptr, JobSystem *jobSystem = nullptr, VkDeviceSize budget = DEFAULT_BUDGET);
+
+            AssetCache(const AssetCache &) = delete;
+            AssetCache &operator=(const AssetCache &) = delete;
+
+            // load on a miss, rethrows the error of a failed load
+            std::shared_ptr<Model> getModel(const std::string &filepath);
+            std::shared_ptr<Texture> getTexture(const std::vector<std::string> &filepaths);
+
+            // evicts down to the budget and releases assets evicted long enough ago, once per frame on the main thread
+            void update();
+            // evicts every asset nothing else holds
+            void trim();
+
+            void setBudget(VkDeviceSize newBudget);
+            VkDeviceSize getBudget();
+            AssetCacheStats getStats();
+
+        private:
+            template <typename T>
+            struct Entry
+            {
+                std::shared_future<std::shared_ptr<T>> asset;
+                bool loaded = false;
+                VkDeviceSize memorySize = 0;
+                // order of the last request, for evicting the least recently used first
+                uint64_t lastUse = 0;
+            };
+
+            template <typename T>
+            using Entries = std::unordered_map<uint64_t, Entry<T>>;
+
+            struct EvictionCandidate
+            {
+                uint64_t lastUse;
+                bool isModel;
+                uint64_t key;
+            };
+
+            template <typename T, typename Load>
+            std::shared_ptr<T> get(Entries<T> &entries, uint64_t key, Load &&load);
+            template <typename T>
+            void collectUnused(Entries<T> &entries, bool isModel, std::vector<EvictionCandidate> &candidates);
+            template <typename T>
+            void retire(Entries<T> &entries, uint64_t key);
+
+            uint64_t fileKey(const std::vector<std::string> &filepaths);
+            // expects the mutex to be held
+            void evict(VkDeviceSize target);
+
+            Device &device;
+            TextureTable *textureTable;
+            JobSystem *jobSystem;
+
+            std::mutex mutex;
+            Entries<Model> models;
+            Entries<Texture> textures;
+            // evicted assets and the frame they were evicted in
+            std::deque<std::pair<uint64_t, std::shared_ptr<void>>> retired;
+
+            VkDeviceSize budget;
+            VkDeviceSize memorySize = 0;
+            uint64_t frame = 0;
+            uint64_t useCounter = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+    };
+}
@@ -0,0 +1,92 @@
+#include "asset_streamer.hpp"
+
+// std
+#include <exception>
+#include <iostream>
+
+namespace mnlt
+{
+    AssetStreamer::AssetStreamer(Device &device, TextureTable &textureTable, uint32_t loaderCount)
+        : device{device}, cache{device, &textureTable, &importers}, loaders{loaderCount}
+    {
+        placeholderModel = cache.getModel("assets/models/cube.obj");
+    }
+
+    AssetStreamer::~AssetStreamer()
+    {
+        loaders.wait(loadsInFlight);
+    }
+
+    AssetHandle<Model> AssetStreamer::loadModel(const std::string &filepath, std::function<void(std::shared_ptr<Model>)> onReady)
+    {
+        return load<Model>([this, filepath]() { return cache.getModel(filepath); }, std::move(onReady));
+    }
+
+    AssetHandle<Texture> AssetStreamer::loadTexture(const std::vector<std::string> &filepaths, std::function<void(std::shared_ptr<Texture>)> onReady)
+    {
+        return load<Texture>([this, filepaths]() { return cache.getTexture(filepaths); }, std::move(onReady));
+    }
+
+    void AssetStreamer::update()
+    {
+        cache.update();
+
+        // onReady callbacks may start new loads, which land in the emptied list
+        std::vector<std::function<bool()>> polls;
+        polls.swap(pending);
+        for (auto &poll : polls)
+        {
+            if (!poll())
+            {
+                pending.push_back(std::move(poll));
+            }
+        }
+    }
+
+    template <typename T>
+    AssetHandle<T> AssetStreamer::load(std::function<std::shared_ptr<T>()> create, std::function<void(std::shared_ptr<T>)> onReady)
+    {
+        AssetHandle<T> handle;
+        handle.state = std::make_shared<typename AssetHandle<T>::State>();
+        handle.state->onReady = std::move(onReady);
+
+        auto state = handle.state;
+        loaders.submit([state, create = std::move(create)]()
+        {
+            try
+            {
+                state->asset = create();
+            }
+            catch (const std::exception &e)
+            {
+                state->error = e.what();
+            }
+            state->loaded.store(true, std::memory_order_release);
+        }, loadsInFlight);
+
+        pending.push_back([this, state]()
+        {
+            if (!state->loaded.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (!state->asset)
+            {
+                std::cerr << "failed to stream asset: " << state->error << std::endl;
+                return true;
+            }
+            if (!device.uploads().isComplete(state->asset->getUploadTicket()))
+            {
+                return false;
+            }
+
+            state->ready = true;
+            if (state->onReady)
+            {
+                state->onReady(state->asset);
+            }
+            return true;
+        });
+        return handle;
+    }
+}
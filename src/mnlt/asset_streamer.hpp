@@ -0,0 +1,97 @@
+#pragma once
+
+#include "asset_cache.hpp"
+#include "device.hpp"
+#include "job_system.hpp"
+#include "model.hpp"
+#include "texture.hpp"
+#include "texture_table.hpp"
+
+// std
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mnlt
+{
+    // refers to an asset that is loading in the background, only ever read on the main thread
+    template <typename T>
+    class AssetHandle
+    {
+        public:
+            AssetHandle() = default;
+
+            // true once the asset is loaded and its upload has reached the gpu
+            bool isReady() const { return state && state->ready; }
+            // the asset once it is ready, null before
+            std::shared_ptr<T> get() const { return isReady() ? state->asset : nullptr; }
+
+        private:
+            struct State
+            {
+                std::shared_ptr<T> asset;
+                std::string error;
+                // set by the loader thread once asset or error is written
+                std::atomic<bool> loaded{false};
+                bool ready = false;
+                std::function<void(std::shared_ptr<T>)> onReady;
+            };
+
+            std::shared_ptr<State> state;
+
+            friend class AssetStreamer;
+    };
+
+    // Loads models and textures on a small pool of loader threads, so parsing and decoding never
+    // block the render loop. Loads go through an AssetCache, so repeated requests share one asset.
+    // Uploads go through the device's UploadManager, and an asset is handed over in update() once
+    // its upload is complete, so using it never makes a frame wait either.
+    //
+    // The loaders are a pool of their own rather than the app's JobSystem, whose waiting threads run
+    // pending jobs themselves and would pick up a long decode in the middle of a physics step. Large
+    // obj files are split over a second pool shared by all loaders, for the same reason.
+    class AssetStreamer
+    {
+        public:
+            static constexpr uint32_t LOADER_THREADS = 2;
+
+            // evicted textures give their slot in the texture table back
+            AssetStreamer(Device &device, TextureTable &textureTable, uint32_t loaderCount = LOADER_THREADS);
+            ~AssetStreamer();
+
+            AssetStreamer(const AssetStreamer &) = delete;
+            AssetStreamer &operator=(const AssetStreamer &) = delete;
+
+            // onReady runs on the main thread from update() once the asset is ready, failed loads are
+            // reported and never become ready
+            AssetHandle<Model> loadModel(const std::string &filepath, std::function<void(std::shared_ptr<Model>)> onReady = {});
+            AssetHandle<Texture> loadTexture(const std::vector<std::string> &filepaths, std::function<void(std::shared_ptr<Texture>)> onReady = {});
+
+            // hands over finished assets, called once per frame on the main thread
+            void update();
+
+            // drawn in place of models that are still loading
+            std::shared_ptr<Model> getPlaceholderModel() const { return placeholderModel; }
+            // for synchronous loads that share the streamed assets
+            AssetCache &getCache() { return cache; }
+            uint32_t getPendingCount() const { return static_cast<uint32_t>(pending.size()); }
+
+        private:
+            template <typename T>
+            AssetHandle<T> load(std::function<std::shared_ptr<T>()> create, std::function<void(std::shared_ptr<T>)> onReady);
+
+            Device &device;
+            // declared before the cache and the loaders, which use it
+            JobSystem importers;
+            AssetCache cache;
+            std::shared_ptr<Model> placeholderModel;
+
+            // polled by update(), each returns true once its asset is handed over or has failed
+            std::vector<std::function<bool()>> pending;
+            JobCounter loadsInFlight{0};
+            JobSystem loaders;
+    };
+}
@@ -43,18 +43,20 @@ namespace mnlt {
         memoryPropertyFlags{memoryPropertyFlags} {
     alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
     bufferSize = alignmentSize * instanceCount;
-    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     Buffer::~Buffer() {
     unmap();
     vkDestroyBuffer(device.device(), buffer, nullptr);
-    vkFreeMemory(device.device(), memory, nullptr);
+    device.allocator().free(allocation);
     }
 
     /**
     * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
     *
+    * @note Host visible memory stays mapped by the allocator, this only points into that mapping
+    *
     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
     * buffer range.
     * @param offset (Optional) Byte offset from beginning
@@ -62,20 +64,21 @@ namespace mnlt {
     * @return VkResult of the buffer mapping call
     */
     VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset) {
-    assert(buffer && memory && "Called map on buffer before create");
-    return vkMapMemory(device.device(), memory, offset, size, 0, &mapped);
+    assert(buffer && allocation.memory && "Called map on buffer before create");
+    if (!allocation.mapped) {
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+    mapped = static_cast<char *>(allocation.mapped) + offset;
+    return VK_SUCCESS;
     }
 
     /**
     * Unmap a mapped memory range
     *
-    * @note Does not return a result as vkUnmapMemory can't fail
+    * @note The allocator keeps the memory mapped, so this only forgets the pointer
     */
     void Buffer::unmap() {
-    if (mapped) {
-        vkUnmapMemory(device.device(), memory);
-        mapped = nullptr;
-    }
+    mapped = nullptr;
     }
 
     /**
@@ -111,12 +114,7 @@ namespace mnlt {
     * @return VkResult of the flush call
     */
     VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-    VkMappedMemoryRange mappedRange = {};
-    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    return vkFlushMappedMemoryRanges(device.device(), 1, &mappedRange);
+    return device.allocator().flush(allocation, size, offset);
     }
 
     /**
@@ -131,12 +129,7 @@ namespace mnlt {
     * @return VkResult of the invalidate call
     */
     VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-    VkMappedMemoryRange mappedRange = {};
-    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    return vkInvalidateMappedMemoryRanges(device.device(), 1, &mappedRange);
+    return device.allocator().invalidate(allocation, size, offset);
     }
 
     /**
@@ -147,7 +140,7 @@ namespace mnlt {
     *
     * @return VkDescriptorBufferInfo of specified offset and range
     */
-    VkDescriptorBufferInfo Buffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) {
+    VkDescriptorBufferInfo Buffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) const {
     return VkDescriptorBufferInfo{
         buffer,
         offset,
@@ -181,6 +174,26 @@ namespace mnlt {
         return flush(alignmentSize, index * alignmentSize);
     }
 
+    /**
+    * Flush several ranges of instances with one call, see flushIndex
+    *
+    * @note The allocator widens every range to whole nonCoherentAtomSize blocks, so unlike flushIndex
+    * this works for instances packed closer than an atom, at the cost of flushing their neighbours too
+    *
+    * @param ranges The instance ranges to flush
+    *
+    */
+    VkResult Buffer::flushIndexRanges(const std::vector<IndexRange> &ranges)
+    {
+        std::vector<std::pair<VkDeviceSize, VkDeviceSize>> byteRanges;
+        byteRanges.reserve(ranges.size());
+        for (const auto &range : ranges)
+        {
+            byteRanges.push_back({range.count * alignmentSize, range.first * alignmentSize});
+        }
+        return device.allocator().flush(allocation, byteRanges);
+    }
+
     /**
     * Create a buffer info descriptor
     *
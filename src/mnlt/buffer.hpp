@@ -2,11 +2,21 @@
 
 #include "device.hpp"
 
+// std
+#include <vector>
+
 namespace mnlt {
 
     class Buffer 
     {
         public:
+            // count instances starting at first
+            struct IndexRange
+            {
+                uint32_t first;
+                uint32_t count;
+            };
+
             Buffer(
                 Device& device,
                 VkDeviceSize instanceSize,
@@ -25,11 +35,12 @@ namespace mnlt {
 
             void writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
             VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
-            VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+            VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
             VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 
             void writeToIndex(void* data, int index);
             VkResult flushIndex(int index);
+            VkResult flushIndexRanges(const std::vector<IndexRange> &ranges);
             VkDescriptorBufferInfo descriptorInfoForIndex(int index);
             VkResult invalidateIndex(int index);
 
@@ -48,7 +59,7 @@ namespace mnlt {
             Device& device;
             void* mapped = nullptr;
             VkBuffer buffer = VK_NULL_HANDLE;
-            VkDeviceMemory memory = VK_NULL_HANDLE;
+            Allocation allocation{};
 
             VkDeviceSize bufferSize;
             uint32_t instanceCount;
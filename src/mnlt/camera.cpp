@@ -34,6 +34,15 @@ namespace mnlt
         this->far = far;
     }
 
+    float Camera::getPixelsPerUnit(float distance, float viewportHeight) const
+    {
+        // the projection scales view space y into normalized device coordinates, which span 2
+        float pixelsPerUnit = glm::abs(projectionMatrix[1][1]) * 0.5f * viewportHeight;
+        // an orthographic projection has no perspective divide, closer than near is clipped anyway
+        if (projectionMatrix[2][3] == 0.f) return pixelsPerUnit;
+        return pixelsPerUnit / glm::max(distance, near);
+    }
+
     void Camera::setViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) 
     {
         const glm::vec3 w{glm::normalize(direction)};
@@ -104,6 +104,8 @@ namespace mnlt
             const glm::mat4& getView() const { return viewMatrix; }
             const glm::mat4& getInverseView() const { return inverseViewMatrix; }
             const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
+            // how many pixels of a viewportHeight tall viewport one unit covers at distance from the camera
+            float getPixelsPerUnit(float distance, float viewportHeight) const;
 
             float getNear() {return near;}
             float getFar() {return far;}
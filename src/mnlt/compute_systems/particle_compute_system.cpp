@@ -0,0 +1,294 @@
+#include "particle_compute_system.hpp"
+
+#include "../render_systems/particle_render_system.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace mnlt
+{
+    ParticleComputeSystem::ParticleComputeSystem(Device& device, DescriptorPool& pool, const std::string& compFilePath, uint32_t pushConstantSize)
+        : device{device}, pool{pool}, compFilePath{compFilePath}, pushConstantSize{pushConstantSize}
+    {
+        // the per type tables have a fixed size so they never need reallocating while frames are in flight
+        typeParameterBuffer = std::make_unique<Buffer>
+        (
+            device,
+            sizeof(float),
+            MAX_TYPES * MAX_TYPES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        typeColorBuffer = std::make_unique<Buffer>
+        (
+            device,
+            sizeof(glm::vec4),
+            MAX_TYPES,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+    }
+    ParticleComputeSystem::~ParticleComputeSystem()
+    {
+        if (!descriptorSets.empty())
+        {
+            pool.freeDescriptors(descriptorSets);
+        }
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+    }
+
+    void ParticleComputeSystem::createDescriptorSetLayout()
+    {
+        setLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+    }
+
+    void ParticleComputeSystem::createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = pushConstantSize;
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void ParticleComputeSystem::createPipeline()
+    {
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        pipeline = std::make_unique<ComputePipeline>(device, compFilePath, pipelineLayout);
+    }
+
+    void ParticleComputeSystem::writeDescriptorSets()
+    {
+        auto instanceInfo = instanceBuffer->descriptorInfo();
+        auto typeParameterInfo = typeParameterBuffer->descriptorInfo();
+        auto typeColorInfo = typeColorBuffer->descriptorInfo();
+
+        descriptorSets.resize(2);
+        for (uint32_t k = 0; k < 2; k++)
+        {
+            auto sourceInfo = stateBuffers[k]->descriptorInfo();
+            auto targetInfo = stateBuffers[1 - k]->descriptorInfo();
+            bool success = DescriptorWriter(*setLayout, pool)
+                .writeBuffer(0, &sourceInfo)
+                .writeBuffer(1, &targetInfo)
+                .writeBuffer(2, &instanceInfo)
+                .writeBuffer(3, &typeParameterInfo)
+                .writeBuffer(4, &typeColorInfo)
+                .build(descriptorSets[k]);
+            if (!success)
+            {
+                throw std::runtime_error("failed to allocate particle compute descriptor set!");
+            }
+        }
+    }
+
+    void ParticleComputeSystem::upload(const ParticleStore& particles)
+    {
+        // the old buffers may still be read by frames in flight
+        vkDeviceWaitIdle(device.device());
+
+        if (!descriptorSets.empty())
+        {
+            pool.freeDescriptors(descriptorSets);
+            descriptorSets.clear();
+        }
+        stateBuffers[0].reset();
+        stateBuffers[1].reset();
+        instanceBuffer.reset();
+
+        particleCount = static_cast<uint32_t>(particles.size());
+        source = 0;
+        if (particleCount == 0) return;
+
+        std::vector<GpuParticle> state(particleCount);
+        for (uint32_t i = 0; i < particleCount; i++)
+        {
+            state[i].positionMass = glm::vec4(particles.getPosition(i), particles.mass[i]);
+            state[i].velocityType = glm::vec4(particles.getVelocity(i), static_cast<float>(particles.typeId[i]));
+        }
+
+        Buffer stagingBuffer
+        {
+            device,
+            sizeof(GpuParticle),
+            particleCount,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(state.data());
+
+        for (auto& stateBuffer : stateBuffers)
+        {
+            stateBuffer = std::make_unique<Buffer>
+            (
+                device,
+                sizeof(GpuParticle),
+                particleCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+        }
+        device.copyBuffer(stagingBuffer.getBuffer(), stateBuffers[0]->getBuffer(), sizeof(GpuParticle) * particleCount);
+
+        // written by the shader, then read as per instance vertex data
+        instanceBuffer = std::make_unique<Buffer>
+        (
+            device,
+            sizeof(ParticleInstance),
+            particleCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+
+        writeDescriptorSets();
+    }
+
+    void ParticleComputeSystem::download(ParticleStore& particles)
+    {
+        assert(particles.size() == particleCount && "particle store and gpu state differ in size");
+        if (particleCount == 0) return;
+
+        vkDeviceWaitIdle(device.device());
+
+        Buffer stagingBuffer
+        {
+            device,
+            sizeof(GpuParticle),
+            particleCount,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        device.copyBuffer(stateBuffers[source]->getBuffer(), stagingBuffer.getBuffer(), sizeof(GpuParticle) * particleCount);
+        stagingBuffer.map();
+
+        auto* state = static_cast<const GpuParticle*>(stagingBuffer.getMappedMemory());
+        for (uint32_t i = 0; i < particleCount; i++)
+        {
+            particles.setPosition(i, glm::vec3(state[i].positionMass));
+            particles.setVelocity(i, glm::vec3(state[i].velocityType));
+        }
+    }
+
+    void ParticleComputeSystem::beginDispatches(VkCommandBuffer commandBuffer, const std::vector<float>& typeParameters, const std::vector<glm::vec4>& typeColors)
+    {
+        if (typeParameters.size() > MAX_TYPES * MAX_TYPES || typeColors.size() > MAX_TYPES)
+        {
+            throw std::runtime_error("too many particle types for the compute shader!");
+        }
+
+        // last frame's dispatches and vertex reads must finish before the tables and state are rewritten
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier
+        (
+            commandBuffer,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+
+        // the tables are tiny, so they go inline in the command buffer instead of through a staging buffer
+        if (!typeParameters.empty())
+        {
+            vkCmdUpdateBuffer(commandBuffer, typeParameterBuffer->getBuffer(), 0, sizeof(float) * typeParameters.size(), typeParameters.data());
+        }
+        if (!typeColors.empty())
+        {
+            vkCmdUpdateBuffer(commandBuffer, typeColorBuffer->getBuffer(), 0, sizeof(glm::vec4) * typeColors.size(), typeColors.data());
+        }
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier
+        (
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    void ParticleComputeSystem::dispatch(VkCommandBuffer commandBuffer, const void* pushConstants)
+    {
+        if (particleCount == 0) return;
+
+        pipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets
+        (
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &descriptorSets[source],
+            0,
+            nullptr
+        );
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+        ComputePipeline::dispatch(commandBuffer, particleCount, GROUP_SIZE);
+
+        // the next dispatch reads what this one wrote and overwrites what this one read
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier
+        (
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+        source = 1 - source;
+    }
+
+    void ParticleComputeSystem::endDispatches(VkCommandBuffer commandBuffer)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier
+        (
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
+#include "../device.hpp"
+#include "../pipeline.hpp"
+#include "../physics/particle_store.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mnlt
+{
+    // std430 layout of one particle in the state buffers
+    struct GpuParticle
+    {
+        glm::vec4 positionMass{};  // w is mass
+        glm::vec4 velocityType{};  // w is the type id
+    };
+
+    // Runs a particle simulation step as a compute shader over storage buffer state that stays on the gpu.
+    // State ping-pongs between two buffers so every invocation reads the start of the step, and each
+    // dispatch also writes a ParticleInstance per particle for ParticleRenderSystem to draw directly.
+    //
+    // Every shader sees the same descriptor set:
+    //   binding 0 source state, binding 1 target state, binding 2 instances,
+    //   binding 3 per type parameters (floats), binding 4 per type colors (vec4)
+    // and its own push constant block of pushConstantSize bytes.
+    //
+    // Dispatches are recorded into the frame's graphics command buffer before the render pass,
+    // which orders them against last frame's draw and this frame's draw with plain pipeline barriers.
+    // Running them on a compute-only queue instead would need a semaphore per frame and queue family
+    // ownership transfers of the state and instance buffers, for overlap the step doesn't have yet.
+    class ParticleComputeSystem
+    {
+        public:
+            static constexpr uint32_t GROUP_SIZE = 256;
+            static constexpr uint32_t MAX_TYPES = 16;
+
+            ParticleComputeSystem(Device &device, DescriptorPool &pool, const std::string &compFilePath, uint32_t pushConstantSize);
+            ~ParticleComputeSystem();
+
+            ParticleComputeSystem(const ParticleComputeSystem &) = delete;
+            ParticleComputeSystem &operator=(const ParticleComputeSystem &) = delete;
+
+            void createPipeline();
+            // replaces the gpu state with the store, waits for the device so buffers in flight can be freed
+            void upload(const ParticleStore &particles);
+            // copies the current gpu state back into the store, for handing the simulation back to the cpu
+            void download(ParticleStore &particles);
+
+            // updates the per type tables and orders this frame's dispatches after last frame's reads
+            void beginDispatches(VkCommandBuffer commandBuffer, const std::vector<float> &typeParameters, const std::vector<glm::vec4> &typeColors);
+            // one simulation step, the target state becomes the source of the next dispatch
+            void dispatch(VkCommandBuffer commandBuffer, const void *pushConstants);
+            // makes the instances written by the last dispatch visible to vertex input
+            void endDispatches(VkCommandBuffer commandBuffer);
+
+            VkBuffer getInstanceBuffer() const { return instanceBuffer ? instanceBuffer->getBuffer() : VK_NULL_HANDLE; }
+            uint32_t getParticleCount() const { return particleCount; }
+
+        private:
+            void createDescriptorSetLayout();
+            void createPipelineLayout();
+            void writeDescriptorSets();
+
+            Device &device;
+            DescriptorPool &pool;
+            std::string compFilePath;
+            uint32_t pushConstantSize;
+
+            std::unique_ptr<DescriptorSetLayout> setLayout;
+            VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+            std::unique_ptr<ComputePipeline> pipeline;
+
+            std::unique_ptr<Buffer> stateBuffers[2];
+            std::unique_ptr<Buffer> instanceBuffer;
+            std::unique_ptr<Buffer> typeParameterBuffer;
+            std::unique_ptr<Buffer> typeColorBuffer;
+            // set k reads stateBuffers[k] and writes stateBuffers[1 - k]
+            std::vector<VkDescriptorSet> descriptorSets;
+            uint32_t particleCount = 0;
+            uint32_t source = 0;
+    };
+}
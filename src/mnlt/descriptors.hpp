@@ -18,14 +18,20 @@ namespace mnlt
                     Builder(Device &device) : device{device} {}
 
                     Builder &addBinding(uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags stageFlags, uint32_t count = 1);
+                    // descriptor indexing flags, a binding that is updated after bind also makes the layout require an update after bind pool
+                    Builder &setBindingFlags(uint32_t binding, VkDescriptorBindingFlags flags);
                     std::unique_ptr<DescriptorSetLayout> build() const;
 
                 private:
                     Device &device;
                     std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+                    std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
             };
 
-            DescriptorSetLayout(Device &device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            DescriptorSetLayout(
+                Device &device,
+                std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+                const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
             ~DescriptorSetLayout();
             DescriptorSetLayout(const DescriptorSetLayout &) = delete;
             DescriptorSetLayout &operator=(const DescriptorSetLayout &) = delete;
@@ -87,6 +93,8 @@ namespace mnlt
 
             DescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
             DescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+            // writes one element of an arrayed binding
+            DescriptorWriter &writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo *imageInfo);
 
             bool build(VkDescriptorSet &set);
             void overwrite(VkDescriptorSet &set);
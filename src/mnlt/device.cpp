@@ -53,11 +53,15 @@ Device::Device(Window &window) : window{window} {
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  allocator_ = std::make_unique<MemoryAllocator>(device_, physicalDevice);
   createCommandPool();
+  uploadManager_ = std::make_unique<UploadManager>(*this);
 }
 
 Device::~Device() {
+  uploadManager_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  allocator_.reset();
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
@@ -79,7 +83,8 @@ void Device::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // 1.2 for core descriptor indexing
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -131,13 +136,16 @@ void Device::pickPhysicalDevice() {
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
   std::cout << "physical device: " << properties.deviceName << std::endl;
+
+  drawIndirectCountSupported = supportsDrawIndirectCount(physicalDevice);
 }
 
 void Device::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -151,9 +159,26 @@ void Device::createLogicalDevice() {
 
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  deviceFeatures.multiDrawIndirect = drawIndirectCountSupported;
+  deviceFeatures.drawIndirectFirstInstance = drawIndirectCountSupported;
+
+  // the 1.2 features all live in one struct, which must not be chained next to the
+  // per extension structs it replaces
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  // the subset of descriptor indexing the bindless texture table needs
+  vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+  vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+  // the upload manager signals finished transfers with a timeline semaphore
+  vulkan12Features.timelineSemaphore = VK_TRUE;
+  // gpu culled draws, optional
+  vulkan12Features.drawIndirectCount = drawIndirectCountSupported;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &vulkan12Features;
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -177,6 +202,7 @@ void Device::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
 }
 
 void Device::createCommandPool() {
@@ -210,7 +236,52 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) {
   vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
   return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+         supportedFeatures.samplerAnisotropy && supportsDescriptorIndexing(device) &&
+         supportsTimelineSemaphores(device);
+}
+
+bool Device::supportsDescriptorIndexing(VkPhysicalDevice device) {
+  VkPhysicalDeviceProperties deviceProperties;
+  vkGetPhysicalDeviceProperties(device, &deviceProperties);
+  if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  VkPhysicalDeviceFeatures2 features = {};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &indexingFeatures;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  return indexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+         indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+         indexingFeatures.descriptorBindingPartiallyBound && indexingFeatures.runtimeDescriptorArray;
+}
+
+bool Device::supportsTimelineSemaphores(VkPhysicalDevice device) {
+  VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+  timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  VkPhysicalDeviceFeatures2 features = {};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &timelineFeatures;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  return timelineFeatures.timelineSemaphore;
+}
+
+bool Device::supportsDrawIndirectCount(VkPhysicalDevice device) {
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 features = {};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  // more than one draw per indirect call needs multi draw indirect as well, and every model after the
+  // first starts its instances past zero
+  return vulkan12Features.drawIndirectCount && features.features.multiDrawIndirect &&
+         features.features.drawIndirectFirstInstance;
 }
 
 void Device::populateDebugMessengerCreateInfo(
@@ -345,6 +416,20 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
     i++;
   }
 
+  for (uint32_t family = 0; family < queueFamilyCount; family++) {
+    const auto &queueFamily = queueFamilies[family];
+    if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+        !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+      indices.transferFamily = family;
+      indices.transferFamilyHasValue = true;
+      break;
+    }
+  }
+  if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.transferFamily = indices.graphicsFamily;
+    indices.transferFamilyHasValue = true;
+  }
+
   return indices;
 }
 
@@ -391,16 +476,7 @@ VkFormat Device::findSupportedFormat(
 }
 
 uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-
-  throw std::runtime_error("failed to find suitable memory type!");
+  return allocator_->findMemoryType(typeFilter, properties);
 }
 
 void Device::createBuffer(
@@ -408,7 +484,7 @@ void Device::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    Allocation &allocation) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +498,8 @@ void Device::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
-
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+  allocation = allocator_->allocate(memRequirements, properties, true);
+  vkBindBufferMemory(device_, buffer, allocation.memory, allocation.offset);
 }
 
 VkCommandBuffer Device::beginSingleTimeCommands() {
@@ -460,8 +528,15 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  // waits for this submission only, frames in flight on the same queue keep running
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VkFence fence;
+  vkCreateFence(device_, &fenceInfo, nullptr, &fence);
+
+  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+  vkDestroyFence(device_, fence, nullptr);
 
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
@@ -509,7 +584,7 @@ void Device::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    Allocation &allocation) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,16 +592,10 @@ void Device::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
+  allocation = allocator_->allocate(
+      memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+  if (vkBindImageMemory(device_, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
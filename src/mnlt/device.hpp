@@ -1,8 +1,11 @@
 #pragma once
 
+#include "memory_allocator.hpp"
+#include "upload_manager.hpp"
 #include "window.hpp"
 
 // std lib headers
+#include <memory>
 #include <vector>
 
 namespace mnlt 
@@ -19,8 +22,12 @@ struct QueueFamilyIndices
 {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // a transfer only family when the device has one, so uploads run on the copy engine,
+  // otherwise the graphics family
+  uint32_t transferFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
@@ -46,9 +53,16 @@ class Device {
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  VkQueue transferQueue() { return transferQueue_; }
   VkInstance getInstance() { return instance; }
   VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+  MemoryAllocator &allocator() { return *allocator_; }
+  UploadManager &uploads() { return *uploadManager_; }
   uint32_t getGraphicsQueueFamily() { return findPhysicalQueueFamilies().graphicsFamily; }
+  uint32_t getTransferQueueFamily() { return findPhysicalQueueFamilies().transferFamily; }
+  // whether vkCmdDrawIndexedIndirectCount can be used, with a draw count above one and a first instance
+  // other than zero
+  bool hasDrawIndirectCount() const { return drawIndirectCountSupported; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -57,12 +71,13 @@ class Device {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // memory comes from the allocator, release it with allocator().free after destroying the buffer
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      Allocation &allocation);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -73,7 +88,7 @@ class Device {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      Allocation &allocation);
   void transitionImageLayout(
       VkImage image,
       VkFormat format,
@@ -100,6 +115,9 @@ class Device {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool supportsDescriptorIndexing(VkPhysicalDevice device);
+  bool supportsTimelineSemaphores(VkPhysicalDevice device);
+  bool supportsDrawIndirectCount(VkPhysicalDevice device);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
@@ -112,6 +130,10 @@ class Device {
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  bool drawIndirectCountSupported = false;
+  std::unique_ptr<MemoryAllocator> allocator_;
+  std::unique_ptr<UploadManager> uploadManager_;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
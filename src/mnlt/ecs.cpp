@@ -0,0 +1,39 @@
+#include "ecs.hpp"
+
+namespace mnlt
+{
+    Entity Registry::create()
+    {
+        if (!freeIndices.empty())
+        {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return {index, generations[index]};
+        }
+
+        generations.push_back(0);
+        return {static_cast<uint32_t>(generations.size() - 1), 0};
+    }
+
+    void Registry::destroy(Entity entity)
+    {
+        if (!valid(entity)) return;
+
+        for (auto &pool : pools)
+        {
+            if (pool != nullptr)
+            {
+                pool->remove(entity.index);
+            }
+        }
+        // every handle to it is stale from here on, and so is the index until create hands it out again
+        generations[entity.index]++;
+        freeIndices.push_back(entity.index);
+    }
+
+    bool Registry::valid(Entity entity) const
+    {
+        // a freed index already has the generation of its next entity, which no handle has been given yet
+        return entity.index < generations.size() && generations[entity.index] == entity.generation;
+    }
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mnlt
+{
+    // A stable handle to an entity. Indices are reused once an entity is destroyed, the generation
+    // tells a stale handle apart from whatever took the index over.
+    struct Entity
+    {
+        static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+        uint32_t index = NULL_INDEX;
+        uint32_t generation = 0;
+
+        bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Entity &other) const { return !(*this == other); }
+    };
+
+    class ComponentPoolBase
+    {
+        public:
+            virtual ~ComponentPoolBase() = default;
+
+            virtual bool contains(uint32_t entityIndex) const = 0;
+            virtual void remove(uint32_t entityIndex) = 0;
+            virtual size_t size() const = 0;
+    };
+
+    // A sparse set of one component type. The components and the indices of the entities owning them
+    // are dense arrays in the same order, so a system that reads one component walks plain memory, and
+    // sparse maps an entity index to its place in them. Removing moves the last component into the
+    // hole, so pointers into a pool only stay valid until its next add or remove.
+    template <typename T>
+    class ComponentPool : public ComponentPoolBase
+    {
+        public:
+            static constexpr uint32_t ABSENT = std::numeric_limits<uint32_t>::max();
+
+            bool contains(uint32_t entityIndex) const override
+            {
+                return entityIndex < sparse.size() && sparse[entityIndex] != ABSENT;
+            }
+
+            // brace initialized, so aggregates take their members in order
+            template <typename... Args>
+            T &add(uint32_t entityIndex, Args &&...args)
+            {
+                assert(!contains(entityIndex) && "Entity already has this component");
+                if (entityIndex >= sparse.size())
+                {
+                    sparse.resize(entityIndex + 1, ABSENT);
+                }
+                sparse[entityIndex] = static_cast<uint32_t>(components.size());
+                entities.push_back(entityIndex);
+                components.push_back(T{std::forward<Args>(args)...});
+                return components.back();
+            }
+
+            void remove(uint32_t entityIndex) override
+            {
+                if (!contains(entityIndex)) return;
+
+                uint32_t hole = sparse[entityIndex];
+                uint32_t last = static_cast<uint32_t>(components.size()) - 1;
+                if (hole != last)
+                {
+                    components[hole] = std::move(components[last]);
+                    entities[hole] = entities[last];
+                    sparse[entities[hole]] = hole;
+                }
+                components.pop_back();
+                entities.pop_back();
+                sparse[entityIndex] = ABSENT;
+            }
+
+            T &get(uint32_t entityIndex)
+            {
+                assert(contains(entityIndex) && "Entity doesn't have this component");
+                return components[sparse[entityIndex]];
+            }
+            const T &get(uint32_t entityIndex) const
+            {
+                assert(contains(entityIndex) && "Entity doesn't have this component");
+                return components[sparse[entityIndex]];
+            }
+
+            size_t size() const override { return components.size(); }
+            T *data() { return components.data(); }
+            const T *data() const { return components.data(); }
+            // the entity index of every component, in the same order as data()
+            const uint32_t *entityIndices() const { return entities.data(); }
+
+        private:
+            std::vector<uint32_t> sparse;
+            std::vector<uint32_t> entities;
+            std::vector<T> components;
+    };
+
+    // Entities and their components, one ComponentPool per component type. Any type can be a
+    // component, pools are created the first time a type is used.
+    class Registry
+    {
+        public:
+            Registry() = default;
+            Registry(const Registry &) = delete;
+            Registry &operator=(const Registry &) = delete;
+
+            Entity create();
+            // removes every component of entity, its handle becomes invalid
+            void destroy(Entity entity);
+            bool valid(Entity entity) const;
+
+            // live entities
+            size_t size() const { return generations.size() - freeIndices.size(); }
+            // every entity index is below this, for arrays indexed by entity index
+            uint32_t capacity() const { return static_cast<uint32_t>(generations.size()); }
+
+            template <typename T, typename... Args>
+            T &add(Entity entity, Args &&...args)
+            {
+                assert(valid(entity) && "Adding a component to an invalid entity");
+                return pool<T>().add(entity.index, std::forward<Args>(args)...);
+            }
+
+            template <typename T>
+            void remove(Entity entity)
+            {
+                assert(valid(entity) && "Removing a component from an invalid entity");
+                pool<T>().remove(entity.index);
+            }
+
+            template <typename T>
+            bool has(Entity entity) const
+            {
+                const auto *found = findPool<T>();
+                return valid(entity) && found != nullptr && found->contains(entity.index);
+            }
+
+            template <typename T>
+            T &get(Entity entity)
+            {
+                assert(valid(entity) && "Getting a component of an invalid entity");
+                return pool<T>().get(entity.index);
+            }
+
+            // nullptr when entity is invalid or doesn't have the component
+            template <typename T>
+            T *tryGet(Entity entity)
+            {
+                return has<T>(entity) ? &pool<T>().get(entity.index) : nullptr;
+            }
+
+            template <typename T>
+            ComponentPool<T> &pool()
+            {
+                size_t type = typeIndex<T>();
+                if (type >= pools.size())
+                {
+                    pools.resize(type + 1);
+                }
+                if (pools[type] == nullptr)
+                {
+                    pools[type] = std::make_unique<ComponentPool<T>>();
+                }
+                return static_cast<ComponentPool<T> &>(*pools[type]);
+            }
+
+            // Calls f(entity, components &...) for every entity with all of Ts, walking the smallest of
+            // their pools in its dense order. f must not add or remove entities or components of Ts.
+            template <typename... Ts, typename F>
+            void each(F &&f)
+            {
+                std::tuple<ComponentPool<Ts> &...> queried{pool<Ts>()...};
+
+                if constexpr (sizeof...(Ts) == 1)
+                {
+                    auto &only = std::get<0>(queried);
+                    auto *components = only.data();
+                    const uint32_t *indices = only.entityIndices();
+                    for (size_t i = 0; i < only.size(); i++)
+                    {
+                        f(Entity{indices[i], generations[indices[i]]}, components[i]);
+                    }
+                }
+                else
+                {
+                    const uint32_t *indices = nullptr;
+                    size_t count = std::numeric_limits<size_t>::max();
+                    auto pickSmallest = [&](const auto &candidate)
+                    {
+                        if (candidate.size() < count)
+                        {
+                            count = candidate.size();
+                            indices = candidate.entityIndices();
+                        }
+                    };
+                    (pickSmallest(std::get<ComponentPool<Ts> &>(queried)), ...);
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        uint32_t index = indices[i];
+                        if ((std::get<ComponentPool<Ts> &>(queried).contains(index) && ...))
+                        {
+                            f(Entity{index, generations[index]}, std::get<ComponentPool<Ts> &>(queried).get(index)...);
+                        }
+                    }
+                }
+            }
+
+        private:
+            template <typename T>
+            const ComponentPool<T> *findPool() const
+            {
+                size_t type = typeIndex<T>();
+                return type < pools.size() ? static_cast<const ComponentPool<T> *>(pools[type].get()) : nullptr;
+            }
+
+            // a small integer per component type, the same in every registry
+            template <typename T>
+            static size_t typeIndex()
+            {
+                static const size_t index = nextTypeIndex++;
+                return index;
+            }
+            inline static std::atomic<size_t> nextTypeIndex{0};
+
+            std::vector<uint32_t> generations;
+            std::vector<uint32_t> freeIndices;
+            std::vector<std::unique_ptr<ComponentPoolBase>> pools;
+    };
+}
@@ -42,6 +42,11 @@ namespace mnlt
         Camera &camera;
         VkDescriptorSet globalDescriptorSet;
         DescriptorPool &frameDescriptorPool;
-        GameObject::Map &gameObjects;
+        // the game objects' components, walked by the systems with registry.each
+        Registry &registry;
+        // owns registry, its object buffer for frameIndex holds the world matrices once updateBuffer ran
+        GameObjectManager &gameObjectManager;
+        // of the swap chain images drawn into this frame
+        VkExtent2D extent;
     };
 }
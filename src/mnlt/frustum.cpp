@@ -0,0 +1,206 @@
+#include "frustum.hpp"
+
+// std
+#include <algorithm>
+
+namespace mnlt
+{
+    namespace
+    {
+        constexpr size_t LANES = 8;
+
+        // the distance every path computes, in the same order so the results match bit for bit
+        float planeDistance(const glm::vec4 &plane, float x, float y, float z)
+        {
+            return ((plane.x * x + plane.y * y) + plane.z * z) + plane.w;
+        }
+
+        Containment containment(bool outside, bool inside)
+        {
+            return outside ? Containment::Outside : inside ? Containment::Inside : Containment::Intersecting;
+        }
+
+        void cullSpheresScalar(
+            const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+            size_t count, Containment *results)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                results[i] = frustum.testSphere({centerX[i], centerY[i], centerZ[i]}, radius[i]);
+            }
+        }
+
+#ifdef MNLT_X86
+        // the last count % 8 spheres copied into a full block, the padding lanes are never stored
+        struct TailBlock
+        {
+            alignas(32) float centerX[LANES] = {};
+            alignas(32) float centerY[LANES] = {};
+            alignas(32) float centerZ[LANES] = {};
+            alignas(32) float radius[LANES] = {};
+
+            TailBlock(const float *x, const float *y, const float *z, const float *r, size_t first, size_t count)
+            {
+                for (size_t k = 0; first + k < count; k++)
+                {
+                    centerX[k] = x[first + k];
+                    centerY[k] = y[first + k];
+                    centerZ[k] = z[first + k];
+                    radius[k] = r[first + k];
+                }
+            }
+        };
+
+        void storeResults(int outsideMask, int insideMask, size_t lanes, Containment *results)
+        {
+            for (size_t k = 0; k < lanes; k++)
+            {
+                results[k] = containment((outsideMask >> k) & 1, (insideMask >> k) & 1);
+            }
+        }
+
+        MNLT_TARGET_SSE2
+        void cullHalfSse(const Frustum &frustum, const float *x, const float *y, const float *z, const float *r, size_t lanes, Containment *results)
+        {
+            __m128 centerX = _mm_loadu_ps(x);
+            __m128 centerY = _mm_loadu_ps(y);
+            __m128 centerZ = _mm_loadu_ps(z);
+            __m128 radius = _mm_loadu_ps(r);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+            __m128 outside = _mm_setzero_ps();
+            __m128 inside = _mm_cmpeq_ps(radius, radius);
+            for (const auto &plane : frustum.planes)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+                    _mm_mul_ps(_mm_set1_ps(plane.z), centerZ)), _mm_set1_ps(plane.w));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, radius));
+            }
+            storeResults(_mm_movemask_ps(outside), _mm_movemask_ps(inside), lanes, results);
+        }
+
+        MNLT_TARGET_SSE2
+        void cullSpheresSse(
+            const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+            size_t count, Containment *results)
+        {
+            size_t blockEnd = count - count % LANES;
+            for (size_t i = 0; i < blockEnd; i += LANES)
+            {
+                cullHalfSse(frustum, centerX + i, centerY + i, centerZ + i, radius + i, 4, results + i);
+                cullHalfSse(frustum, centerX + i + 4, centerY + i + 4, centerZ + i + 4, radius + i + 4, 4, results + i + 4);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{centerX, centerY, centerZ, radius, blockEnd, count};
+                size_t lanes = count - blockEnd;
+                cullHalfSse(frustum, tail.centerX, tail.centerY, tail.centerZ, tail.radius, std::min<size_t>(lanes, 4), results + blockEnd);
+                if (lanes > 4)
+                {
+                    cullHalfSse(frustum, tail.centerX + 4, tail.centerY + 4, tail.centerZ + 4, tail.radius + 4, lanes - 4, results + blockEnd + 4);
+                }
+            }
+        }
+
+        MNLT_TARGET_AVX2
+        void cullBlockAvx(const Frustum &frustum, const float *x, const float *y, const float *z, const float *r, size_t lanes, Containment *results)
+        {
+            __m256 centerX = _mm256_loadu_ps(x);
+            __m256 centerY = _mm256_loadu_ps(y);
+            __m256 centerZ = _mm256_loadu_ps(z);
+            __m256 radius = _mm256_loadu_ps(r);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+            __m256 outside = _mm256_setzero_ps();
+            __m256 inside = _mm256_cmp_ps(radius, radius, _CMP_EQ_OQ);
+            for (const auto &plane : frustum.planes)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(plane.x), centerX), _mm256_mul_ps(_mm256_set1_ps(plane.y), centerY)),
+                    _mm256_mul_ps(_mm256_set1_ps(plane.z), centerZ)), _mm256_set1_ps(plane.w));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, radius, _CMP_GE_OQ));
+            }
+            storeResults(_mm256_movemask_ps(outside), _mm256_movemask_ps(inside), lanes, results);
+        }
+
+        MNLT_TARGET_AVX2
+        void cullSpheresAvx(
+            const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+            size_t count, Containment *results)
+        {
+            size_t blockEnd = count - count % LANES;
+            for (size_t i = 0; i < blockEnd; i += LANES)
+            {
+                cullBlockAvx(frustum, centerX + i, centerY + i, centerZ + i, radius + i, LANES, results + i);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{centerX, centerY, centerZ, radius, blockEnd, count};
+                cullBlockAvx(frustum, tail.centerX, tail.centerY, tail.centerZ, tail.radius, count - blockEnd, results + blockEnd);
+            }
+        }
+#endif
+    }
+
+    Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection)
+    {
+        // glm is column major, so row i of the matrix is m[0][i], m[1][i], m[2][i], m[3][i]
+        auto row = [&](int i) { return glm::vec4{viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]}; };
+        glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+
+        Frustum frustum{};
+        frustum.planes[0] = w + x;
+        frustum.planes[1] = w - x;
+        frustum.planes[2] = w + y;
+        frustum.planes[3] = w - y;
+        // clip space depth runs from 0 rather than -w
+        frustum.planes[4] = z;
+        frustum.planes[5] = w - z;
+        for (auto &plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3{plane});
+        }
+        return frustum;
+    }
+
+    Containment Frustum::testSphere(const glm::vec3 &center, float radius) const
+    {
+        bool outside = false;
+        bool inside = true;
+        for (const auto &plane : planes)
+        {
+            float distance = planeDistance(plane, center.x, center.y, center.z);
+            outside = outside || distance < -radius;
+            inside = inside && distance >= radius;
+        }
+        return containment(outside, inside);
+    }
+
+    Containment Frustum::testBox(const glm::vec3 &center, const glm::vec3 &extents) const
+    {
+        bool outside = false;
+        bool inside = true;
+        for (const auto &plane : planes)
+        {
+            // how far the box reaches towards the plane's normal
+            float radius = glm::dot(glm::abs(glm::vec3{plane}), extents);
+            float distance = planeDistance(plane, center.x, center.y, center.z);
+            outside = outside || distance < -radius;
+            inside = inside && distance >= radius;
+        }
+        return containment(outside, inside);
+    }
+
+    void cullSpheres(
+        const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+        size_t count, Containment *results, SimdLevel level)
+    {
+        if (level > bestSimdLevel()) level = bestSimdLevel();
+#ifdef MNLT_X86
+        if (level == SimdLevel::AVX2) return cullSpheresAvx(frustum, centerX, centerY, centerZ, radius, count, results);
+        if (level == SimdLevel::SSE2) return cullSpheresSse(frustum, centerX, centerY, centerZ, radius, count, results);
+#endif
+        cullSpheresScalar(frustum, centerX, centerY, centerZ, radius, count, results);
+    }
+}
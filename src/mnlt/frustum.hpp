@@ -0,0 +1,44 @@
+#pragma once
+
+#include "simd.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace mnlt
+{
+    enum class Containment : uint8_t
+    {
+        Outside,
+        Intersecting,
+        Inside,
+    };
+
+    // The six planes of a view frustum, normalized and facing inwards, so dot(plane.xyz, p) + plane.w
+    // is the distance of p to the inside of a plane.
+    struct Frustum
+    {
+        // left, right, bottom, top, near, far
+        glm::vec4 planes[6];
+
+        // Gribb and Hartmann's extraction from projection * view, for 0 to 1 depth like Camera's
+        static Frustum fromMatrix(const glm::mat4 &viewProjection);
+
+        Containment testSphere(const glm::vec3 &center, float radius) const;
+        // a box along the world axes, extents are half its size
+        Containment testBox(const glm::vec3 &center, const glm::vec3 &extents) const;
+    };
+
+    // Tests count spheres in structure-of-arrays form against frustum in blocks of 8, 4 lanes at a
+    // time with SSE2 and 8 with AVX2. Every level gives the same results as Frustum::testSphere.
+    // Levels above bestSimdLevel() fall back to the best supported one.
+    void cullSpheres(
+        const Frustum &frustum, const float *centerX, const float *centerY, const float *centerZ, const float *radius,
+        size_t count, Containment *results, SimdLevel level = bestSimdLevel());
+}
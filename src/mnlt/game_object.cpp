@@ -1,125 +1,132 @@
 #include "game_object.hpp"
 
-#include <numeric>
+#include <algorithm>
 #include <string>
 #include <vector>
 
 namespace mnlt 
 {
-    glm::mat4 TransformComponent::mat4() 
+    GameObject GameObjectManager::createGameObject()
     {
-        const float c3 = glm::cos(rotation.z);
-        const float s3 = glm::sin(rotation.z);
-        const float c2 = glm::cos(rotation.x);
-        const float s2 = glm::sin(rotation.x);
-        const float c1 = glm::cos(rotation.y);
-        const float s1 = glm::sin(rotation.y);
-        return glm::mat4
-        {
-            {
-                scale.x * (c1 * c3 + s1 * s2 * s3),
-                scale.x * (c2 * s3),
-                scale.x * (c1 * s2 * s3 - c3 * s1),
-                0.0f,
-            },
-            {
-                scale.y * (c3 * s1 * s2 - c1 * s3),
-                scale.y * (c2 * c3),
-                scale.y * (c1 * c3 * s2 + s1 * s3),
-                0.0f,
-            },
-            {
-                scale.z * (c2 * s1),
-                scale.z * (-s2),
-                scale.z * (c1 * c2),
-                0.0f,
-            },
-            {translation.x, translation.y, translation.z, 1.0f}
-        };
+        GameObject gameObj{registry.create(), registry};
+        gameObj.add<TransformComponent>();
+        gameObj.add<WorldTransformComponent>();
+        gameObj.add<ColorComponent>();
+        gameObj.add<NameComponent>("GameObject" + std::to_string(gameObj.getEntity().index));
+        gameObj.add<UIComponent>();
+        transformHierarchy.markStructureChanged();
+        return gameObj;
     }
 
-    glm::mat3 TransformComponent::normalMatrix() 
+    void GameObjectManager::destroyGameObject(GameObject gameObject)
     {
-        const float c3 = glm::cos(rotation.z);
-        const float s3 = glm::sin(rotation.z);
-        const float c2 = glm::cos(rotation.x);
-        const float s2 = glm::sin(rotation.x);
-        const float c1 = glm::cos(rotation.y);
-        const float s1 = glm::sin(rotation.y);
-        const glm::vec3 invScale = 1.0f / scale;
-
-        return glm::mat3
-        {
-            {
-                invScale.x * (c1 * c3 + s1 * s2 * s3),
-                invScale.x * (c2 * s3),
-                invScale.x * (c1 * s2 * s3 - c3 * s1),
-            },
-            {
-                invScale.y * (c3 * s1 * s2 - c1 * s3),
-                invScale.y * (c2 * c3),
-                invScale.y * (c1 * c3 * s2 + s1 * s3),
-            },
-            {
-                invScale.z * (c2 * s1),
-                invScale.z * (-s2),
-                invScale.z * (c1 * c2),
-            },
-        };
+        registry.destroy(gameObject.getEntity());
+        transformHierarchy.markStructureChanged();
     }
 
-    GameObject& GameObjectManager::makePointLight(float intensity, float radius, glm::vec3 color)
+    GameObject GameObjectManager::makePointLight(float intensity, float radius, glm::vec3 color)
     {
-        auto& gameObj = createGameObject();
-        gameObj.color = color;
-        gameObj.transform.scale.x = radius;
-        gameObj.pointLight = std::make_unique<PointLightComponent>();
-        gameObj.pointLight->lightIntensity = intensity;
+        auto gameObj = createGameObject();
+        gameObj.color() = color;
+        gameObj.transform().scale.x = radius;
+        gameObj.add<PointLightComponent>(intensity);
         return gameObj;
     }
 
-    GameObjectManager::GameObjectManager(Device& device) 
+    ModelComponent& GameObjectManager::setModel(GameObject gameObject, std::shared_ptr<Model> model)
     {
-        // including nonCoherentAtomSize allows us to flush a specific index at once
-        int alignment = std::lcm(
-            device.properties.limits.nonCoherentAtomSize,
-            device.properties.limits.minUniformBufferOffsetAlignment);
-        for (int i = 0; i < uboBuffers.size(); i++) {
-            uboBuffers[i] = std::make_unique<Buffer>(
-                device,
-                sizeof(GameObjectBufferData),
-                GameObjectManager::MAX_GAME_OBJECTS,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                alignment);
-            uboBuffers[i]->map();
+        if (auto* existing = gameObject.tryGet<ModelComponent>())
+        {
+            existing->model = std::move(model);
+            return *existing;
         }
-        std::vector<std::string> textures = {"assets/textures/default.png"};
-        textureDefault = Texture::createTextureFromFile(device, textures);
+        return gameObject.add<ModelComponent>(std::move(model), textureDefault);
     }
 
-    void GameObjectManager::updateBuffer(int frameIndex) 
+    GameObjectManager::GameObjectManager(Device& device, JobSystem& jobSystem) : device{device}, transformHierarchy{jobSystem}
     {
-        // copy model matrix and normal matrix for each gameObj into
-        // buffer for this frame
-        for (auto& kv : gameObjects) 
-        {
-            auto& obj = kv.second;
-            GameObjectBufferData data{};
-            data.modelMatrix = obj.transform.mat4();
-            data.normalMatrix = obj.transform.normalMatrix();
-            uboBuffers[frameIndex]->writeToIndex(&data, kv.first);
+        for (int i = 0; i < objectBuffers.size(); i++) {
+            objectBuffers[i] = createObjectBuffer(INITIAL_GAME_OBJECT_CAPACITY);
         }
-        uboBuffers[frameIndex]->flush();
+        std::vector<std::string> textures = {"assets/textures/default.png"};
+        textureDefault = Texture::createTextureFromFile(device, textures);
     }
 
-    VkDescriptorBufferInfo GameObject::getBufferInfo(int frameIndex) 
+    std::unique_ptr<Buffer> GameObjectManager::createObjectBuffer(uint32_t capacity)
     {
-        return gameObjectManger.getBufferInfoForGameObject(frameIndex, id);
+        // the shaders index one storage buffer rather than binding each object at its own offset, so
+        // entries aren't padded to minUniformBufferOffsetAlignment, flushes are widened to whole atoms
+        auto buffer = std::make_unique<Buffer>(
+            device,
+            sizeof(GameObjectBufferData),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        buffer->map();
+        return buffer;
     }
 
-    GameObject::GameObject(id_t objId, const GameObjectManager& manager) : id{objId}, gameObjectManger{manager}
+    void GameObjectManager::updateBuffer(int frameIndex) 
     {
-        name = "GameObject" + std::to_string(id);
+        transformHierarchy.update(registry);
+        uint32_t capacity = registry.capacity();
+        auto& worlds = registry.pool<WorldTransformComponent>();
+        for (auto& pending : pendingUploads)
+        {
+            if (pending.queued.size() < capacity) pending.queued.resize(capacity, 0);
+        }
+        auto& pending = pendingUploads[frameIndex];
+
+        // the frame's previous submission has finished, so its buffer can be swapped for a bigger one
+        if (objectBuffers[frameIndex]->getInstanceCount() < capacity)
+        {
+            uint32_t bufferCapacity = objectBuffers[frameIndex]->getInstanceCount();
+            while (bufferCapacity < capacity) bufferCapacity *= 2;
+            objectBuffers[frameIndex] = createObjectBuffer(bufferCapacity);
+            // nothing of the old buffer carries over
+            const uint32_t* indices = worlds.entityIndices();
+            for (size_t i = 0; i < worlds.size(); i++)
+            {
+                pending.push(indices[i]);
+            }
+        }
+
+        // every frame's buffer is behind by what changed, this one catches up now and the others when
+        // they're next updated
+        for (uint32_t index : transformHierarchy.getChangedEntities())
+        {
+            for (auto& frame : pendingUploads)
+            {
+                frame.push(index);
+            }
+        }
+
+        // sorted, neighbouring writes share one flushed range, a static scene has nothing to walk
+        auto& buffer = *objectBuffers[frameIndex];
+        std::sort(pending.indices.begin(), pending.indices.end());
+        flushRanges.clear();
+        for (uint32_t i : pending.indices)
+        {
+            pending.queued[i] = 0;
+            // destroyed since it was queued, nothing left to write
+            if (!worlds.contains(i)) continue;
+
+            const auto& world = worlds.get(i);
+            GameObjectBufferData data{world.matrix, glm::mat4{world.normalMatrix}};
+            buffer.writeToIndex(&data, i);
+            if (!flushRanges.empty() && i - (flushRanges.back().first + flushRanges.back().count) <= FLUSH_MERGE_GAP)
+            {
+                flushRanges.back().count = i + 1 - flushRanges.back().first;
+            }
+            else
+            {
+                flushRanges.push_back({i, 1});
+            }
+        }
+        pending.indices.clear();
+        if (!flushRanges.empty())
+        {
+            buffer.flushIndexRanges(flushRanges);
+        }
     }
-}
\ No newline at end of file
+}
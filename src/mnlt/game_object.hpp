@@ -1,14 +1,17 @@
 #pragma once
 
+#include "ecs.hpp"
 #include "model.hpp"
 #include "swap_chain.hpp"
 #include "texture.hpp"
+#include "transform_hierarchy.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <array>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <utility>
 
 namespace mnlt
 {
@@ -18,21 +21,10 @@ namespace mnlt
     };
     struct RigidBodyComponent 
     {
-        glm::vec3 velocity;
+        glm::vec3 velocity{};
         float mass{1.0f};
     };
-    struct TransformComponent
-    {
-        glm::vec3 translation{};
-        glm::vec3 scale{1.0f, 1.0f, 1.0f};
-        glm::vec3 rotation;
-
-        // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
-        // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
-        // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-        glm::mat4 mat4() ;
-        glm::mat3 normalMatrix();
-    };
+    // std430 layout of one entry in the object buffer, see ObjectTransform in simple_shader.vert
     struct GameObjectBufferData 
     {
         glm::mat4 modelMatrix{1.f};
@@ -43,79 +35,115 @@ namespace mnlt
         bool showPropertyWindow = false;
     };
 
-    class GameObjectManager;  // forward declare game object manager class
+    struct ColorComponent
+    {
+        glm::vec3 color{1.f, 1.f, 1.f};
+    };
+    struct NameComponent
+    {
+        std::string name;
+    };
+    struct ModelComponent
+    {
+        std::shared_ptr<Model> model{};
+        std::shared_ptr<Texture> diffuseMap = nullptr;
+    };
 
+    // A handle to an entity in the GameObjectManager's registry. Copies are cheap and refer to the same
+    // object, its components live in the registry's dense pools. References to a component are only
+    // good until another component of that type is added or removed.
     class GameObject
     {
         public:
-            using id_t = unsigned int;
-            using Map = std::unordered_map<id_t, GameObject>;
-        
-            GameObject(const GameObject &) = delete;
-            GameObject &operator=(const GameObject &) = delete;
-            GameObject(GameObject &&) = default;
-            GameObject &operator=(GameObject &&) = delete;
-
-            id_t getId() { return id; }
-
-            VkDescriptorBufferInfo getBufferInfo(int frameIndex);
-
-            glm::vec3 color{1.f,1.f,1.f};
-            TransformComponent transform{};
-            RigidBodyComponent rigidBody{};
-            UIComponent ui;
-            std::string name;
-
-
-            std::shared_ptr<Model> model {};
-            std::shared_ptr<Texture> diffuseMap = nullptr;
-            std::unique_ptr<PointLightComponent> pointLight = nullptr;
+            GameObject() = default;
+            GameObject(Entity entity, Registry &registry) : entity{entity}, registry{&registry} {}
+
+            Entity getEntity() const { return entity; }
+            bool isValid() const { return registry != nullptr && registry->valid(entity); }
+
+            template <typename T, typename... Args>
+            T &add(Args &&...args) { return registry->add<T>(entity, std::forward<Args>(args)...); }
+            template <typename T>
+            void remove() { registry->remove<T>(entity); }
+            template <typename T>
+            bool has() const { return registry->has<T>(entity); }
+            template <typename T>
+            T &get() { return registry->get<T>(entity); }
+            template <typename T>
+            T *tryGet() { return registry->tryGet<T>(entity); }
+
+            // every game object has these
+            TransformComponent &transform() { return get<TransformComponent>(); }
+            glm::vec3 &color() { return get<ColorComponent>().color; }
+            std::string &name() { return get<NameComponent>().name; }
+            UIComponent &ui() { return get<UIComponent>(); }
 
         private:
-            GameObject(id_t objId, const GameObjectManager &manager);
-
-            id_t id;
-            const GameObjectManager &gameObjectManger;
-
-            friend class GameObjectManager;
+            Entity entity{};
+            Registry *registry = nullptr;
     };
 
     class GameObjectManager 
     {
         public:
-            static constexpr int MAX_GAME_OBJECTS = 1000;
+            // entries in each frame's buffer to begin with, it grows past this as objects are created
+            static constexpr uint32_t INITIAL_GAME_OBJECT_CAPACITY = 1024;
+            // dirty entries at most this far apart share a flushed range
+            static constexpr uint32_t FLUSH_MERGE_GAP = 4;
 
-            GameObjectManager(Device &device);
+            GameObjectManager(Device &device, JobSystem &jobSystem);
             
             GameObjectManager(const GameObjectManager &) = delete;
             GameObjectManager &operator=(const GameObjectManager &) = delete;
             GameObjectManager(GameObjectManager &&) = delete;
             GameObjectManager &operator=(GameObjectManager &&) = delete;
 
-            GameObject &createGameObject() 
-            {
-                assert(currentId < MAX_GAME_OBJECTS && "Max game object count exceeded!");
-                auto gameObject = GameObject{currentId++, *this};
-                auto gameObjectId = gameObject.getId();
-                gameObject.diffuseMap = textureDefault;
-                gameObjects.emplace(gameObjectId, std::move(gameObject));
-                return gameObjects.at(gameObjectId);
-            }
+            // with a transform, color, name and ui, everything else is added as needed
+            GameObject createGameObject();
+            GameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+            // its children become roots
+            void destroyGameObject(GameObject gameObject);
+            GameObject getGameObject(Entity entity) { return {entity, registry}; }
 
-            GameObject &makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+            // child's transform becomes relative to parent, an invalid parent makes it relative to the world
+            void setParent(GameObject child, GameObject parent) { transformHierarchy.setParent(registry, child.getEntity(), parent.getEntity()); }
 
-            VkDescriptorBufferInfo getBufferInfoForGameObject(int frameIndex, id_t gameObjectId) const 
-            {
-                return uboBuffers[frameIndex]->descriptorInfoForIndex(gameObjectId);
-            }
+            // gives the game object a model, drawn with the default texture until it's given its own
+            ModelComponent &setModel(GameObject gameObject, std::shared_ptr<Model> model);
+
+            // the storage buffer of frameIndex, tightly packed GameObjectBufferData indexed by entity index.
+            // updateBuffer replaces it with a bigger one when the registry outgrows it
+            const Buffer &getObjectBuffer(int frameIndex) const { return *objectBuffers[frameIndex]; }
 
+            // updates the world matrices and writes the ones that changed since this frame's buffer was
+            // last updated, a static scene uploads nothing
             void updateBuffer(int frameIndex);
 
-            GameObject::Map gameObjects{};
-            std::vector<std::unique_ptr<Buffer>> uboBuffers{SwapChain::MAX_FRAMES_IN_FLIGHT};
+            Registry registry{};
 
         private:
-            id_t currentId = 0;
+            std::unique_ptr<Buffer> createObjectBuffer(uint32_t capacity);
+
+            Device &device;
             std::shared_ptr<Texture> textureDefault;
+            TransformHierarchy transformHierarchy;
+            std::vector<std::unique_ptr<Buffer>> objectBuffers{SwapChain::MAX_FRAMES_IN_FLIGHT};
+
+            // the entity indices whose matrices changed since a frame's buffer was last written, queued
+            // marks every index that is in the list so it's only added once
+            struct PendingUploads
+            {
+                std::vector<uint32_t> indices;
+                std::vector<uint8_t> queued;
+
+                void push(uint32_t index)
+                {
+                    if (queued[index]) return;
+                    queued[index] = 1;
+                    indices.push_back(index);
+                }
+            };
+            std::array<PendingUploads, SwapChain::MAX_FRAMES_IN_FLIGHT> pendingUploads{};
+            std::vector<Buffer::IndexRange> flushRanges;
     };
 }
@@ -0,0 +1,140 @@
+#include "job_system.hpp"
+
+namespace mnlt
+{
+    namespace
+    {
+        // lets submit and runPendingJob find the queue of the worker they are running on
+        thread_local const JobSystem *currentSystem = nullptr;
+        thread_local uint32_t currentWorker = 0;
+    }
+
+    uint32_t JobSystem::defaultWorkerCount()
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    JobSystem::JobSystem(uint32_t workerCount)
+    {
+        queues.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            running = false;
+        }
+        wakeCondition.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    void JobSystem::submit(Job job, JobCounter &counter)
+    {
+        counter.fetch_add(1);
+        Job countedJob = [job = std::move(job), &counter]
+        {
+            job();
+            counter.fetch_sub(1);
+        };
+
+        if (workers.empty())
+        {
+            countedJob();
+            return;
+        }
+
+        // workers keep their own jobs local, anyone else spreads them round robin
+        uint32_t queueIndex = currentSystem == this
+            ? currentWorker
+            : nextQueue.fetch_add(1) % static_cast<uint32_t>(queues.size());
+        {
+            // counted before the push so a thief can never take the count below zero, and under
+            // the sleep mutex so a worker can't miss the wake up between its check and sleeping
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            queuedJobs.fetch_add(1);
+        }
+        {
+            std::lock_guard<std::mutex> lock{queues[queueIndex]->mutex};
+            queues[queueIndex]->jobs.push_back(std::move(countedJob));
+        }
+        wakeCondition.notify_one();
+    }
+
+    void JobSystem::wait(const JobCounter &counter)
+    {
+        while (counter.load() > 0)
+        {
+            if (!runPendingJob())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool JobSystem::runPendingJob()
+    {
+        if (queues.empty()) return false;
+
+        Job job;
+        bool isWorker = currentSystem == this;
+        uint32_t queueCount = static_cast<uint32_t>(queues.size());
+        uint32_t first = isWorker ? currentWorker : nextQueue.load() % queueCount;
+
+        if (isWorker)
+        {
+            // newest first from our own queue, its data is most likely still in cache
+            auto &own = *queues[first];
+            std::lock_guard<std::mutex> lock{own.mutex};
+            if (!own.jobs.empty())
+            {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+            }
+        }
+        for (uint32_t offset = isWorker ? 1 : 0; !job && offset < queueCount; offset++)
+        {
+            // oldest first from everyone else, those are the jobs the owner gets to last
+            auto &victim = *queues[(first + offset) % queueCount];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+            }
+        }
+        if (!job) return false;
+
+        queuedJobs.fetch_sub(1);
+        job();
+        return true;
+    }
+
+    void JobSystem::workerLoop(uint32_t workerIndex)
+    {
+        currentSystem = this;
+        currentWorker = workerIndex;
+
+        while (true)
+        {
+            if (runPendingJob()) continue;
+
+            std::unique_lock<std::mutex> lock{sleepMutex};
+            wakeCondition.wait(lock, [this] { return !running || queuedJobs.load() > 0; });
+            if (!running) return;
+        }
+    }
+}
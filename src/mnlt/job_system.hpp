@@ -0,0 +1,90 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mnlt
+{
+    // counts the unfinished jobs of a batch, JobSystem::wait blocks until it reaches zero
+    using JobCounter = std::atomic<uint32_t>;
+
+    // Pool of worker threads with one deque per worker. A worker pushes and pops jobs at the
+    // back of its own deque and, once that is empty, steals from the front of the others, so
+    // a batch submitted to one worker spreads out over every idle core.
+    // Threads that wait on a counter run jobs themselves instead of blocking.
+    class JobSystem
+    {
+        public:
+            using Job = std::function<void()>;
+
+            // the calling thread helps out while waiting, so it doesn't get a worker of its own
+            static uint32_t defaultWorkerCount();
+
+            explicit JobSystem(uint32_t workerCount = defaultWorkerCount());
+            ~JobSystem();
+            JobSystem(const JobSystem &) = delete;
+            JobSystem &operator=(const JobSystem &) = delete;
+
+            // counter is incremented now and decremented once the job has run
+            void submit(Job job, JobCounter &counter);
+            void wait(const JobCounter &counter);
+
+            // splits [0, count) into chunks of at least minChunkSize and calls func(begin, end)
+            // on each of them in parallel, returns once every chunk is done
+            template <typename Func>
+            void parallelFor(size_t count, size_t minChunkSize, Func &&func)
+            {
+                if (count == 0) return;
+
+                // a few chunks per thread leaves room to balance uneven chunks by stealing
+                size_t threads = workers.size() + 1;
+                size_t chunkCount = std::min((count + minChunkSize - 1) / std::max<size_t>(minChunkSize, 1), threads * 4);
+                if (chunkCount <= 1)
+                {
+                    func(size_t{0}, count);
+                    return;
+                }
+                size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+                JobCounter counter{0};
+                for (size_t begin = chunkSize; begin < count; begin += chunkSize)
+                {
+                    size_t end = std::min(begin + chunkSize, count);
+                    submit([&func, begin, end] { func(begin, end); }, counter);
+                }
+                func(size_t{0}, chunkSize);
+                wait(counter);
+            }
+
+            uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+        private:
+            struct WorkQueue
+            {
+                std::mutex mutex;
+                std::deque<Job> jobs;
+            };
+
+            void workerLoop(uint32_t workerIndex);
+            // runs one job from this thread's own queue or stolen from another, false if all are empty
+            bool runPendingJob();
+
+            std::vector<std::unique_ptr<WorkQueue>> queues;
+            std::vector<std::thread> workers;
+
+            std::atomic<uint32_t> queuedJobs{0};
+            std::atomic<uint32_t> nextQueue{0};
+            bool running = true;
+            std::mutex sleepMutex;
+            std::condition_variable wakeCondition;
+    };
+}
@@ -0,0 +1,311 @@
+#include "memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace mnlt
+{
+    namespace
+    {
+        uint32_t log2(VkDeviceSize value)
+        {
+            uint32_t result = 0;
+            while (value >>= 1) result++;
+            return result;
+        }
+
+        VkDeviceSize nextPowerOfTwo(VkDeviceSize value)
+        {
+            VkDeviceSize result = 1;
+            while (result < value) result <<= 1;
+            return result;
+        }
+    }
+
+    BuddyAllocator::BuddyAllocator(VkDeviceSize size) : size{size}
+    {
+        assert(size >= MIN_ALLOCATION_SIZE && (size & (size - 1)) == 0 && "buddy allocator size must be a power of two");
+        uint32_t maxOrder = log2(size / MIN_ALLOCATION_SIZE);
+        freeLists.resize(maxOrder + 1);
+        freeLists[maxOrder].insert(0);
+    }
+
+    bool BuddyAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, uint32_t &order)
+    {
+        VkDeviceSize blockSize = nextPowerOfTwo(std::max({size, alignment, MIN_ALLOCATION_SIZE}));
+        order = log2(blockSize / MIN_ALLOCATION_SIZE);
+        if (order >= freeLists.size()) return false;
+
+        uint32_t current = order;
+        while (current < freeLists.size() && freeLists[current].empty()) current++;
+        if (current == freeLists.size()) return false;
+
+        offset = *freeLists[current].begin();
+        freeLists[current].erase(freeLists[current].begin());
+        // split down to the requested order, the upper halves become free blocks
+        while (current > order)
+        {
+            current--;
+            freeLists[current].insert(offset + orderSize(current));
+        }
+
+        allocatedBytes += orderSize(order);
+        return true;
+    }
+
+    void BuddyAllocator::free(VkDeviceSize offset, uint32_t order)
+    {
+        allocatedBytes -= orderSize(order);
+        while (order + 1 < freeLists.size())
+        {
+            VkDeviceSize buddy = offset ^ orderSize(order);
+            auto it = freeLists[order].find(buddy);
+            if (it == freeLists[order].end()) break;
+
+            freeLists[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        freeLists[order].insert(offset);
+    }
+
+    VkDeviceSize BuddyAllocator::getLargestFreeBlock() const
+    {
+        for (size_t order = freeLists.size(); order-- > 0;)
+        {
+            if (!freeLists[order].empty()) return orderSize(static_cast<uint32_t>(order));
+        }
+        return 0;
+    }
+
+    MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{device}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+        pools.resize(memoryProperties.memoryTypeCount * 2);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto &pool : pools)
+        {
+            for (auto &block : pool.blocks)
+            {
+                if (block->mapped) vkUnmapMemory(device, block->memory);
+                vkFreeMemory(device, block->memory, nullptr);
+            }
+        }
+    }
+
+    Allocation MemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        Allocation allocation{};
+        allocation.memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+        allocation.requestedSize = requirements.size;
+        allocation.linear = linear;
+
+        VkDeviceSize blockSize = getBlockSize(allocation.memoryType);
+        if (requirements.size > blockSize / 2)
+        {
+            allocation.memory = allocateMemory(requirements.size, allocation.memoryType, &allocation.mapped);
+            allocation.size = requirements.size;
+            dedicatedCount++;
+            dedicatedBytes += requirements.size;
+        }
+        else
+        {
+            Pool &pool = getPool(allocation.memoryType, linear);
+            for (auto &block : pool.blocks)
+            {
+                if (block->buddy.allocate(requirements.size, requirements.alignment, allocation.offset, allocation.order))
+                {
+                    allocation.block = block.get();
+                    break;
+                }
+            }
+
+            if (!allocation.block)
+            {
+                void *mapped = nullptr;
+                VkDeviceMemory memory = allocateMemory(blockSize, allocation.memoryType, &mapped);
+                pool.blocks.push_back(std::make_unique<MemoryBlock>(memory, blockSize, mapped));
+                allocation.block = pool.blocks.back().get();
+                // an empty block can still refuse, for example when the alignment is larger than the block
+                if (!allocation.block->buddy.allocate(requirements.size, requirements.alignment, allocation.offset, allocation.order))
+                {
+                    throw std::runtime_error("failed to sub-allocate memory from a new block!");
+                }
+            }
+
+            allocation.memory = allocation.block->memory;
+            allocation.size = BuddyAllocator::orderSize(allocation.order);
+            if (allocation.block->mapped)
+            {
+                allocation.mapped = static_cast<char *>(allocation.block->mapped) + allocation.offset;
+            }
+        }
+
+        allocationCount++;
+        usedBytes += allocation.requestedSize;
+        return allocation;
+    }
+
+    void MemoryAllocator::free(Allocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE) return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (allocation.block)
+        {
+            MemoryBlock *block = allocation.block;
+            block->buddy.free(allocation.offset, allocation.order);
+
+            // an empty block is released unless it is the last one of its pool, which avoids
+            // reallocating it every time a lone short lived resource like a staging buffer comes and goes
+            Pool &pool = getPool(allocation.memoryType, allocation.linear);
+            if (block->buddy.isEmpty() && pool.blocks.size() > 1)
+            {
+                if (block->mapped) vkUnmapMemory(device, block->memory);
+                vkFreeMemory(device, block->memory, nullptr);
+                pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                    [block](const std::unique_ptr<MemoryBlock> &b) { return b.get() == block; }));
+            }
+        }
+        else
+        {
+            if (allocation.mapped) vkUnmapMemory(device, allocation.memory);
+            vkFreeMemory(device, allocation.memory, nullptr);
+            dedicatedCount--;
+            dedicatedBytes -= allocation.size;
+        }
+
+        allocationCount--;
+        usedBytes -= allocation.requestedSize;
+        allocation = Allocation{};
+    }
+
+    VkResult MemoryAllocator::flush(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkFlushMappedMemoryRanges(device, 1, &range);
+    }
+
+    VkResult MemoryAllocator::flush(const Allocation &allocation, const std::vector<std::pair<VkDeviceSize, VkDeviceSize>> &ranges)
+    {
+        std::vector<VkMappedMemoryRange> mappedRanges;
+        mappedRanges.reserve(ranges.size());
+        for (const auto &range : ranges)
+        {
+            mappedRanges.push_back(mappedRange(allocation, range.first, range.second));
+        }
+        return vkFlushMappedMemoryRanges(device, static_cast<uint32_t>(mappedRanges.size()), mappedRanges.data());
+    }
+
+    VkResult MemoryAllocator::invalidate(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset)
+    {
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkInvalidateMappedMemoryRanges(device, 1, &range);
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    MemoryStats MemoryAllocator::getStats()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        MemoryStats stats{};
+        stats.dedicatedCount = dedicatedCount;
+        stats.allocationCount = allocationCount;
+        stats.reservedBytes = dedicatedBytes;
+        stats.usedBytes = usedBytes;
+
+        // dedicated allocations are exactly the requested size, so all rounding waste is in the blocks
+        VkDeviceSize allocatedBytes = dedicatedBytes;
+        for (auto &pool : pools)
+        {
+            for (auto &block : pool.blocks)
+            {
+                const BuddyAllocator &buddy = block->buddy;
+                stats.blockCount++;
+                stats.reservedBytes += buddy.getSize();
+                allocatedBytes += buddy.getAllocatedBytes();
+                stats.externalFragmentation += buddy.getSize() - buddy.getAllocatedBytes() - buddy.getLargestFreeBlock();
+            }
+        }
+        stats.internalFragmentation = allocatedBytes - usedBytes;
+        return stats;
+    }
+
+    VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryType) const
+    {
+        // small heaps, like the 256 MiB device local and host visible one, get blocks of an eighth of the heap
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+        while (blockSize > BuddyAllocator::MIN_ALLOCATION_SIZE && blockSize * 8 > heapSize) blockSize >>= 1;
+        return blockSize;
+    }
+
+    VkDeviceMemory MemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, void **mapped)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+
+        *mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+        return memory;
+    }
+
+    VkMappedMemoryRange MemoryAllocator::mappedRange(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset) const
+    {
+        // non coherent ranges have to start and end on multiples of nonCoherentAtomSize, blocks are
+        // split at 256 bytes or more which is the largest atom the spec allows, so widening stays inside the allocation
+        VkDeviceSize begin = allocation.offset + offset;
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+        begin = begin / nonCoherentAtomSize * nonCoherentAtomSize;
+        end = (end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+
+        VkDeviceSize memorySize = allocation.block ? allocation.block->buddy.getSize() : allocation.size;
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        range.size = end >= memorySize ? VK_WHOLE_SIZE : end - begin;
+        return range;
+    }
+}
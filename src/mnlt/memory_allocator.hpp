@@ -0,0 +1,140 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace mnlt
+{
+    // Binary buddy allocator over the offsets of one memory block. Every allocation is rounded up to a
+    // power of two, which keeps it aligned to its own size, so any alignment up to the rounded size is
+    // met by placement alone. Freed blocks merge with their buddy as soon as both halves are free.
+    class BuddyAllocator
+    {
+        public:
+            static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+
+            // size has to be a power of two and at least MIN_ALLOCATION_SIZE
+            explicit BuddyAllocator(VkDeviceSize size);
+
+            // returns false when no free block is large enough
+            bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset, uint32_t &order);
+            void free(VkDeviceSize offset, uint32_t order);
+
+            static VkDeviceSize orderSize(uint32_t order) { return MIN_ALLOCATION_SIZE << order; }
+
+            VkDeviceSize getSize() const { return size; }
+            VkDeviceSize getAllocatedBytes() const { return allocatedBytes; }
+            VkDeviceSize getLargestFreeBlock() const;
+            bool isEmpty() const { return allocatedBytes == 0; }
+
+        private:
+            VkDeviceSize size;
+            VkDeviceSize allocatedBytes = 0;
+            // free block offsets per order, kept sorted so allocations pack towards the start
+            std::vector<std::set<VkDeviceSize>> freeLists;
+    };
+
+    // one vkAllocateMemory call shared by many allocations
+    struct MemoryBlock
+    {
+        MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void *mapped)
+         : memory{memory}, mapped{mapped}, buddy{size} {}
+
+        VkDeviceMemory memory;
+        void *mapped;
+        BuddyAllocator buddy;
+    };
+
+    // a range of device memory handed out by MemoryAllocator
+    struct Allocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        // bytes reserved for the allocation, at least the requested size
+        VkDeviceSize size = 0;
+        VkDeviceSize requestedSize = 0;
+        // persistent mapping of offset, null unless the memory is host visible
+        void *mapped = nullptr;
+
+        uint32_t memoryType = 0;
+        uint32_t order = 0;
+        bool linear = false;
+        // null for dedicated allocations that own their VkDeviceMemory
+        MemoryBlock *block = nullptr;
+    };
+
+    struct MemoryStats
+    {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedCount = 0;
+        uint32_t allocationCount = 0;
+        // device memory allocated from the driver
+        VkDeviceSize reservedBytes = 0;
+        // bytes the resources asked for
+        VkDeviceSize usedBytes = 0;
+        // rounding waste inside allocations
+        VkDeviceSize internalFragmentation = 0;
+        // free bytes outside the largest free range of each block, unusable for large requests
+        VkDeviceSize externalFragmentation = 0;
+    };
+
+    // Sub-allocates buffers and images from large blocks of device memory instead of calling
+    // vkAllocateMemory per resource, which is slow and bounded by maxMemoryAllocationCount.
+    //
+    // Blocks are kept per memory type, with linear resources (buffers) and optimal images in separate
+    // blocks so neighbours never have to respect bufferImageGranularity. Requests bigger than half a
+    // block get a dedicated allocation. Host visible blocks are mapped once for their whole lifetime.
+    class MemoryAllocator
+    {
+        public:
+            static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+            MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+            ~MemoryAllocator();
+
+            MemoryAllocator(const MemoryAllocator &) = delete;
+            MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+
+            Allocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear);
+            void free(Allocation &allocation);
+
+            // offset is relative to the allocation, ranges are widened to nonCoherentAtomSize
+            VkResult flush(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+            // flushes several (size, offset) ranges of the allocation with one call
+            VkResult flush(const Allocation &allocation, const std::vector<std::pair<VkDeviceSize, VkDeviceSize>> &ranges);
+            VkResult invalidate(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+            uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+            MemoryStats getStats();
+
+        private:
+            struct Pool
+            {
+                std::vector<std::unique_ptr<MemoryBlock>> blocks;
+            };
+
+            Pool &getPool(uint32_t memoryType, bool linear) { return pools[memoryType * 2 + (linear ? 1 : 0)]; }
+            VkDeviceSize getBlockSize(uint32_t memoryType) const;
+            VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, void **mapped);
+            VkMappedMemoryRange mappedRange(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+            VkDevice device;
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            VkDeviceSize nonCoherentAtomSize;
+
+            std::mutex mutex;
+            std::vector<Pool> pools;
+            uint32_t dedicatedCount = 0;
+            VkDeviceSize dedicatedBytes = 0;
+            uint32_t allocationCount = 0;
+            VkDeviceSize usedBytes = 0;
+    };
+}
@@ -0,0 +1,261 @@
+#include "mesh_file.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mnlt
+{
+    static_assert(sizeof(MeshFileHeader) % MeshFile::DATA_ALIGNMENT == 0, "sections must start aligned after the header");
+    static_assert(sizeof(Model::PackedVertex) == 24, "Model::PackedVertex changed, bump MeshFile::VERSION and update the check");
+    static_assert(sizeof(Model::Lod) == 12 && sizeof(Model::BoundingSphere) == 16 && sizeof(Model::BoundingBox) == 24, "Model::Lod or the bounds changed, bump MeshFile::VERSION and update the check");
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    MeshFile::MeshFile(const std::string &filepath)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("failed to open mesh file: " + filepath);
+        }
+        fileHandle = file;
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        mappedSize = static_cast<size_t>(size.QuadPart);
+        if (mappedSize > 0)
+        {
+            mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            mapped = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!mapped)
+            {
+                // the destructor does not run for a throwing constructor
+                if (mappingHandle) CloseHandle(mappingHandle);
+                CloseHandle(file);
+                throw std::runtime_error("failed to map mesh file: " + filepath);
+            }
+        }
+#else
+        int file = ::open(filepath.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            throw std::runtime_error("failed to open mesh file: " + filepath);
+        }
+
+        struct stat info;
+        if (fstat(file, &info) != 0)
+        {
+            ::close(file);
+            throw std::runtime_error("failed to read mesh file: " + filepath);
+        }
+        mappedSize = static_cast<size_t>(info.st_size);
+        if (mappedSize > 0)
+        {
+            void *address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+            if (address == MAP_FAILED)
+            {
+                ::close(file);
+                throw std::runtime_error("failed to map mesh file: " + filepath);
+            }
+            mapped = address;
+            // the whole file is copied out right away, so start reading it in
+            madvise(mapped, mappedSize, MADV_WILLNEED);
+        }
+        // the mapping keeps the file alive
+        ::close(file);
+#endif
+    }
+
+    MeshFile::~MeshFile()
+    {
+#ifdef _WIN32
+        if (mapped) UnmapViewOfFile(mapped);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle) CloseHandle(fileHandle);
+#else
+        if (mapped) munmap(mapped, mappedSize);
+#endif
+    }
+
+    std::unique_ptr<MeshFile> MeshFile::open(const std::string &filepath)
+    {
+        // the constructor is private, so no make_unique
+        std::unique_ptr<MeshFile> meshFile{new MeshFile(filepath)};
+        meshFile->validate(filepath);
+
+        auto bytes = static_cast<const char *>(meshFile->mapped);
+        meshFile->header = reinterpret_cast<const MeshFileHeader *>(bytes);
+        meshFile->vertices = reinterpret_cast<const Model::PackedVertex *>(bytes + meshFile->header->vertexOffset);
+        if (meshFile->header->indexCount > 0)
+        {
+            meshFile->indices = bytes + meshFile->header->indexOffset;
+        }
+        return meshFile;
+    }
+
+    std::unique_ptr<MeshFile> MeshFile::openCooked(const std::string &sourcePath)
+    {
+        std::string cookedPath = getCookedPath(sourcePath);
+        std::error_code error;
+        auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+        if (error)
+        {
+            return nullptr;
+        }
+        auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+        if (!error && cookedTime < sourceTime)
+        {
+            std::cerr << "ignoring outdated " << cookedPath << ", run the mesh cooker again" << std::endl;
+            return nullptr;
+        }
+
+        try
+        {
+            return open(cookedPath);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "ignoring " << cookedPath << ": " << e.what() << std::endl;
+            return nullptr;
+        }
+    }
+
+    void MeshFile::write(const std::string &filepath, const Model::BuilderData &builderData)
+    {
+        std::vector<Model::PackedVertex> vertices = builderData.packVertices();
+
+        MeshFileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.vertexStride = sizeof(Model::PackedVertex);
+        header.vertexCount = static_cast<uint32_t>(vertices.size());
+        header.indexCount = static_cast<uint32_t>(builderData.indices.size());
+        header.indexSize = Model::getIndexSize(header.vertexCount);
+        if (builderData.lods.empty())
+        {
+            header.lodCount = 1;
+            header.lods[0] = {0, header.indexCount, 0.f};
+        }
+        else
+        {
+            header.lodCount = static_cast<uint32_t>(std::min<size_t>(builderData.lods.size(), Model::MAX_LOD_COUNT));
+            std::copy(builderData.lods.begin(), builderData.lods.begin() + header.lodCount, header.lods);
+        }
+        header.boundingSphere = builderData.computeBoundingSphere();
+        header.boundingBox = builderData.computeBoundingBox();
+        header.vertexOffset = sizeof(MeshFileHeader);
+        uint64_t vertexSize = uint64_t{header.vertexStride} * header.vertexCount;
+        header.indexOffset = alignUp(header.vertexOffset + vertexSize, DATA_ALIGNMENT);
+
+        std::vector<uint16_t> shortIndices;
+        const void *indices = builderData.indices.data();
+        if (header.indexSize == sizeof(uint16_t))
+        {
+            shortIndices.assign(builderData.indices.begin(), builderData.indices.end());
+            indices = shortIndices.data();
+        }
+        uint64_t indexSize = uint64_t{header.indexSize} * header.indexCount;
+
+        // written next to the target and renamed over it, so a crash never leaves a torn file to map
+        std::string tempPath = filepath + ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            if (!file.is_open())
+            {
+                throw std::runtime_error("failed to create mesh file: " + tempPath);
+            }
+
+            const char padding[DATA_ALIGNMENT] = {};
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(vertices.data()), vertexSize);
+            file.write(padding, header.indexOffset - (header.vertexOffset + vertexSize));
+            file.write(static_cast<const char *>(indices), indexSize);
+            if (!file)
+            {
+                throw std::runtime_error("failed to write mesh file: " + tempPath);
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, filepath, error);
+        if (error)
+        {
+            std::remove(tempPath.c_str());
+            throw std::runtime_error("failed to replace mesh file " + filepath + ": " + error.message());
+        }
+    }
+
+    std::string MeshFile::getCookedPath(const std::string &sourcePath)
+    {
+        return std::filesystem::path{sourcePath}.replace_extension(EXTENSION).string();
+    }
+
+    bool MeshFile::isMeshFile(const std::string &filepath)
+    {
+        return std::filesystem::path{filepath}.extension() == EXTENSION;
+    }
+
+    void MeshFile::validate(const std::string &filepath) const
+    {
+        if (mappedSize < sizeof(MeshFileHeader))
+        {
+            throw std::runtime_error("mesh file is truncated: " + filepath);
+        }
+
+        MeshFileHeader header;
+        std::memcpy(&header, mapped, sizeof(header));
+        if (header.magic != MAGIC)
+        {
+            throw std::runtime_error("not a mesh file: " + filepath);
+        }
+        if (header.version != VERSION || header.vertexStride != sizeof(Model::PackedVertex))
+        {
+            throw std::runtime_error("mesh file is from another version, cook it again: " + filepath);
+        }
+
+        uint64_t vertexEnd = header.vertexOffset + uint64_t{header.vertexStride} * header.vertexCount;
+        uint64_t indexEnd = header.indexOffset + uint64_t{header.indexSize} * header.indexCount;
+        if ((header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) ||
+            header.vertexOffset % DATA_ALIGNMENT != 0 || header.indexOffset % DATA_ALIGNMENT != 0 ||
+            header.vertexOffset < sizeof(MeshFileHeader) || vertexEnd > mappedSize ||
+            indexEnd > mappedSize || (header.indexCount > 0 && header.indexOffset < vertexEnd))
+        {
+            throw std::runtime_error("mesh file is corrupt: " + filepath);
+        }
+
+        if (header.lodCount == 0 || header.lodCount > Model::MAX_LOD_COUNT)
+        {
+            throw std::runtime_error("mesh file is corrupt: " + filepath);
+        }
+        for (uint32_t i = 0; i < header.lodCount; i++)
+        {
+            const Model::Lod &lod = header.lods[i];
+            if (uint64_t{lod.firstIndex} + lod.indexCount > header.indexCount)
+            {
+                throw std::runtime_error("mesh file is corrupt: " + filepath);
+            }
+        }
+    }
+}
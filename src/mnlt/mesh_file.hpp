@@ -0,0 +1,93 @@
+#pragma once
+
+#include "model.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace mnlt
+{
+    // Cooked meshes, written offline by tools/mesh_cooker.cpp from an obj file. The vertices are
+    // already merged, optimized and packed exactly as the vertex buffers hold them, so loading is
+    // a memory map and one copy into the staging buffer instead of parsing text.
+    //
+    // Layout: a MeshFileHeader with the lod table, then the Model::PackedVertex vertices and the 16
+    // or 32 bit indices of all lods, each section starting at a multiple of DATA_ALIGNMENT.
+    struct MeshFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        // sizeof(Model::PackedVertex) when written, files from a different vertex layout are rejected
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        // 2 or 4 bytes, see Model::getIndexSize
+        uint32_t indexSize;
+        // at least one, the entries of lods past it are zero
+        uint32_t lodCount;
+        // zero, pads the header to a multiple of DATA_ALIGNMENT
+        uint32_t reserved[4];
+        Model::BoundingSphere boundingSphere;
+        Model::BoundingBox boundingBox;
+        Model::Lod lods[Model::MAX_LOD_COUNT];
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+    };
+
+    // a read only memory mapped mesh file, unmapped on destruction
+    class MeshFile
+    {
+        public:
+            static constexpr uint32_t MAGIC = 0x534d4e4d; // "MNMS"
+            // bump whenever the layout or Model::PackedVertex changes
+            static constexpr uint32_t VERSION = 4;
+            static constexpr size_t DATA_ALIGNMENT = 16;
+            static constexpr const char *EXTENSION = ".mesh";
+
+            ~MeshFile();
+
+            MeshFile(const MeshFile &) = delete;
+            MeshFile &operator=(const MeshFile &) = delete;
+
+            // throws if the file is missing, malformed or from another version
+            static std::unique_ptr<MeshFile> open(const std::string &filepath);
+            // the cooked mesh next to the source file, null when there is none or it is older than
+            // the source or unreadable, so the caller falls back to the source
+            static std::unique_ptr<MeshFile> openCooked(const std::string &sourcePath);
+            // packs the vertices as they are, generate lods and optimize first
+            static void write(const std::string &filepath, const Model::BuilderData &builderData);
+
+            static std::string getCookedPath(const std::string &sourcePath);
+            static bool isMeshFile(const std::string &filepath);
+
+            const Model::PackedVertex *getVertices() const { return vertices; }
+            uint32_t getVertexCount() const { return header->vertexCount; }
+            // uint16_t or uint32_t as getIndexSize says
+            const void *getIndices() const { return indices; }
+            uint32_t getIndexCount() const { return header->indexCount; }
+            uint32_t getIndexSize() const { return header->indexSize; }
+            const Model::Lod *getLods() const { return header->lods; }
+            uint32_t getLodCount() const { return header->lodCount; }
+            const Model::BoundingSphere &getBoundingSphere() const { return header->boundingSphere; }
+            const Model::BoundingBox &getBoundingBox() const { return header->boundingBox; }
+
+        private:
+            MeshFile(const std::string &filepath);
+
+            void validate(const std::string &filepath) const;
+
+            void *mapped = nullptr;
+            size_t mappedSize = 0;
+#ifdef _WIN32
+            void *fileHandle = nullptr;
+            void *mappingHandle = nullptr;
+#endif
+
+            const MeshFileHeader *header = nullptr;
+            const Model::PackedVertex *vertices = nullptr;
+            const void *indices = nullptr;
+    };
+}
@@ -0,0 +1,634 @@
+#include "mesh_optimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace mnlt
+{
+    namespace
+    {
+        // scoring constants from Forsyth's paper, tuned for a 32 entry lru cache
+        constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+        constexpr float CACHE_DECAY_POWER = 1.5f;
+        constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr float VALENCE_BOOST_SCALE = 2.0f;
+        constexpr float VALENCE_BOOST_POWER = 0.5f;
+        // valences above this all get the last boost, which is close to zero by then
+        constexpr uint32_t MAX_SCORED_VALENCE = 64;
+
+        struct ForsythScores
+        {
+            float cache[FORSYTH_CACHE_SIZE];
+            float valence[MAX_SCORED_VALENCE];
+
+            ForsythScores()
+            {
+                for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; i++)
+                {
+                    // the last triangle's vertices get a fixed score, so the next triangle
+                    // doesn't just reuse the newest edge over and over
+                    cache[i] = i < 3 ? LAST_TRIANGLE_SCORE : std::pow(1.f - float(i - 3) / float(FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+                }
+                valence[0] = 0.f;
+                for (uint32_t i = 1; i < MAX_SCORED_VALENCE; i++)
+                {
+                    // vertices with few triangles left are worth finishing off
+                    valence[i] = VALENCE_BOOST_SCALE * std::pow(float(i), -VALENCE_BOOST_POWER);
+                }
+            }
+
+            float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) const
+            {
+                if (remainingTriangles == 0) return -1.f;
+                float score = cachePosition >= 0 ? cache[cachePosition] : 0.f;
+                return score + valence[std::min(remainingTriangles, MAX_SCORED_VALENCE - 1)];
+            }
+        };
+
+        // fifo cache simulation, a vertex is a miss when more than cacheSize misses happened since its last one
+        struct FifoCache
+        {
+            std::vector<uint32_t> timestamps;
+            uint32_t cacheSize;
+            uint32_t timestamp;
+
+            FifoCache(size_t vertexCount, uint32_t cacheSize) : timestamps(vertexCount, 0), cacheSize{cacheSize}, timestamp{cacheSize + 1} {}
+
+            uint32_t misses(const uint32_t *triangle)
+            {
+                uint32_t count = 0;
+                for (int i = 0; i < 3; i++)
+                {
+                    if (timestamp - timestamps[triangle[i]] > cacheSize)
+                    {
+                        timestamps[triangle[i]] = timestamp++;
+                        count++;
+                    }
+                }
+                return count;
+            }
+
+            void flush()
+            {
+                timestamp += cacheSize + 1;
+            }
+        };
+
+        // planes along open borders count this much more than the surface, so borders keep their shape
+        constexpr double BORDER_WEIGHT = 10.0;
+        // a pass takes the cheapest collapses, up to this much more than the cost of the one it expects to be its last
+        constexpr double PASS_ERROR_SLACK = 1.5;
+
+        // squared distance to a set of weighted planes, as the symmetric 4x4 matrix of Garland and Heckbert
+        struct Quadric
+        {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+            double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+            double a22 = 0.0, a23 = 0.0;
+            double a33 = 0.0;
+            double weight = 0.0;
+
+            void addPlane(const glm::dvec3 &normal, double distance, double planeWeight)
+            {
+                a00 += planeWeight * normal.x * normal.x;
+                a01 += planeWeight * normal.x * normal.y;
+                a02 += planeWeight * normal.x * normal.z;
+                a03 += planeWeight * normal.x * distance;
+                a11 += planeWeight * normal.y * normal.y;
+                a12 += planeWeight * normal.y * normal.z;
+                a13 += planeWeight * normal.y * distance;
+                a22 += planeWeight * normal.z * normal.z;
+                a23 += planeWeight * normal.z * distance;
+                a33 += planeWeight * distance * distance;
+                weight += planeWeight;
+            }
+
+            Quadric &operator+=(const Quadric &other)
+            {
+                a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+                a11 += other.a11; a12 += other.a12; a13 += other.a13;
+                a22 += other.a22; a23 += other.a23;
+                a33 += other.a33;
+                weight += other.weight;
+                return *this;
+            }
+
+            // divided by the weight, so it stays a squared distance however many planes went in
+            double error(const glm::vec3 &position) const
+            {
+                double x = position.x, y = position.y, z = position.z;
+                double sum = a00 * x * x + a11 * y * y + a22 * z * z + a33
+                    + 2.0 * (a01 * x * y + a02 * x * z + a03 * x + a12 * y * z + a13 * y + a23 * z);
+                return weight > 0.0 ? std::abs(sum) / weight : 0.0;
+            }
+        };
+
+        enum class VertexKind : uint8_t
+        {
+            Manifold,
+            // on an open border, only moves along it
+            Border,
+            // on a non-manifold edge or where borders meet, never moves
+            Locked
+        };
+
+        // an edge between two positions, once for every triangle it is a side of
+        struct Edge
+        {
+            uint32_t a;
+            uint32_t b;
+            uint32_t triangle;
+        };
+
+        struct Collapse
+        {
+            uint32_t source;
+            uint32_t target;
+            double error;
+        };
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) return;
+
+        static const ForsythScores scores{};
+
+        // triangles of every vertex, the first remaining[v] of each range are the ones not emitted yet
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (uint32_t index : indices) remaining[index]++;
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + remaining[v];
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<int32_t> cachePositions(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++) vertexScores[v] = scores.vertexScore(-1, remaining[v]);
+
+        auto triangleScore = [&](size_t triangle)
+        {
+            const uint32_t *corners = &indices[triangle * 3];
+            return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+        };
+
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        // three extra slots for the vertices pushed in before the oldest fall out
+        uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+        size_t cacheCount = 0;
+        size_t nextUnemitted = 0;
+
+        size_t best = 0;
+        float bestScore = triangleScore(0);
+        for (size_t t = 1; t < triangleCount; t++)
+        {
+            float score = triangleScore(t);
+            if (score > bestScore)
+            {
+                best = t;
+                bestScore = score;
+            }
+        }
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            const uint32_t *corners = &indices[best * 3];
+            result.insert(result.end(), corners, corners + 3);
+            emitted[best] = 1;
+
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t v = corners[i];
+                uint32_t *triangles = &adjacency[offsets[v]];
+                uint32_t *last = triangles + remaining[v] - 1;
+                *std::find(triangles, last, static_cast<uint32_t>(best)) = *last;
+                remaining[v]--;
+            }
+
+            // the triangle's vertices move to the front, the rest shift back
+            uint32_t updated[FORSYTH_CACHE_SIZE + 3];
+            size_t updatedCount = 0;
+            for (int i = 0; i < 3; i++)
+            {
+                if (std::find(updated, updated + updatedCount, corners[i]) == updated + updatedCount)
+                {
+                    updated[updatedCount++] = corners[i];
+                }
+            }
+            for (size_t i = 0; i < cacheCount; i++)
+            {
+                if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+                {
+                    updated[updatedCount++] = cache[i];
+                }
+            }
+
+            for (size_t i = 0; i < updatedCount; i++)
+            {
+                uint32_t v = updated[i];
+                cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertexScores[v] = scores.vertexScore(cachePositions[v], remaining[v]);
+            }
+            cacheCount = std::min<size_t>(updatedCount, FORSYTH_CACHE_SIZE);
+            std::copy(updated, updated + cacheCount, cache);
+
+            // only triangles around the changed vertices changed score
+            bestScore = -1.f;
+            bool found = false;
+            for (size_t i = 0; i < updatedCount; i++)
+            {
+                uint32_t v = updated[i];
+                for (uint32_t j = 0; j < remaining[v]; j++)
+                {
+                    uint32_t triangle = adjacency[offsets[v] + j];
+                    float score = triangleScore(triangle);
+                    if (score > bestScore)
+                    {
+                        best = triangle;
+                        bestScore = score;
+                        found = true;
+                    }
+                }
+            }
+
+            // the cache ran dry, carry on with the next triangle in the original order
+            if (!found)
+            {
+                while (nextUnemitted < triangleCount && emitted[nextUnemitted]) nextUnemitted++;
+                best = nextUnemitted;
+            }
+        }
+
+        indices = std::move(result);
+    }
+
+    void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices, float threshold)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) return;
+
+        // a triangle missing all three vertices is where the cache order jumped to a new area
+        FifoCache cache{vertices.size(), VERTEX_CACHE_SIZE};
+        std::vector<size_t> hardBoundaries;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (cache.misses(&indices[t * 3]) == 3) hardBoundaries.push_back(t);
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        // cut each of those again as soon as the part so far misses little enough
+        std::vector<size_t> clusters;
+        for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+        {
+            size_t begin = hardBoundaries[c];
+            size_t end = hardBoundaries[c + 1];
+
+            cache.flush();
+            uint32_t clusterMisses = 0;
+            for (size_t t = begin; t < end; t++) clusterMisses += cache.misses(&indices[t * 3]);
+            float clusterThreshold = threshold * float(clusterMisses) / float(end - begin);
+
+            cache.flush();
+            clusters.push_back(begin);
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+            for (size_t t = begin; t + 1 < end; t++)
+            {
+                runningMisses += cache.misses(&indices[t * 3]);
+                runningTriangles++;
+                if (float(runningMisses) / float(runningTriangles) <= clusterThreshold)
+                {
+                    clusters.push_back(t + 1);
+                    cache.flush();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // clusters far out from the centre and facing away from it are likely in front of the rest
+        size_t clusterCount = clusters.size() - 1;
+        std::vector<glm::vec3> centroids(clusterCount, glm::vec3{0.f});
+        std::vector<glm::vec3> normals(clusterCount, glm::vec3{0.f});
+        glm::vec3 meshCentroid{0.f};
+        for (size_t cluster = 0; cluster < clusterCount; cluster++)
+        {
+            for (size_t t = clusters[cluster]; t < clusters[cluster + 1]; t++)
+            {
+                const glm::vec3 &a = vertices[indices[t * 3]].position;
+                const glm::vec3 &b = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3 &c = vertices[indices[t * 3 + 2]].position;
+                glm::vec3 centroid = (a + b + c) / 3.f;
+                centroids[cluster] += centroid;
+                meshCentroid += centroid;
+                // twice the area, so big triangles decide the direction
+                normals[cluster] += glm::cross(b - a, c - a);
+            }
+            centroids[cluster] /= float(clusters[cluster + 1] - clusters[cluster]);
+        }
+        meshCentroid /= float(triangleCount);
+
+        std::vector<float> sortKeys(clusterCount);
+        std::vector<size_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            float length = glm::length(normals[c]);
+            glm::vec3 normal = length > 0.f ? normals[c] / length : glm::vec3{0.f};
+            sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normal);
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (size_t c : order)
+        {
+            result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        }
+        indices = std::move(result);
+    }
+
+    float simplify(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices, size_t targetIndexCount, float maxError)
+    {
+        size_t vertexCount = vertices.size();
+        if (indices.size() <= targetIndexCount || vertexCount == 0) return 0.f;
+
+        // vertices at one position, like either side of a uv seam, are wedges of it and move together.
+        // positions are numbered by their first wedge, and the wedges of each form a ring
+        std::vector<uint32_t> positionOf(vertexCount);
+        std::vector<uint32_t> nextWedge(vertexCount);
+        {
+            std::vector<uint32_t> order(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++) order[v] = v;
+            auto less = [&](uint32_t a, uint32_t b)
+            {
+                const glm::vec3 &p = vertices[a].position;
+                const glm::vec3 &q = vertices[b].position;
+                return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z != q.z ? p.z < q.z : a < b;
+            };
+            std::sort(order.begin(), order.end(), less);
+            for (size_t begin = 0, end = 0; begin < vertexCount; begin = end)
+            {
+                while (end < vertexCount && vertices[order[end]].position == vertices[order[begin]].position) end++;
+                for (size_t i = begin; i < end; i++)
+                {
+                    positionOf[order[i]] = order[begin];
+                    nextWedge[order[i]] = order[i + 1 < end ? i + 1 : begin];
+                }
+            }
+        }
+        auto position = [&](uint32_t v) -> const glm::vec3 & { return vertices[v].position; };
+
+        // kept per position and summed up as positions collapse, so errors accumulate across passes
+        std::vector<Quadric> quadrics(vertexCount);
+        auto triangleNormal = [&](size_t triangle, glm::dvec3 &normal, double &area)
+        {
+            glm::dvec3 a{position(indices[triangle * 3])};
+            glm::dvec3 b{position(indices[triangle * 3 + 1])};
+            glm::dvec3 c{position(indices[triangle * 3 + 2])};
+            normal = glm::cross(b - a, c - a);
+            area = glm::length(normal);
+            if (area > 0.0) normal /= area;
+            area *= 0.5;
+        };
+        for (size_t t = 0; t < indices.size() / 3; t++)
+        {
+            glm::dvec3 normal;
+            double area;
+            triangleNormal(t, normal, area);
+            if (area == 0.0) continue;
+            double distance = -glm::dot(normal, glm::dvec3{position(indices[t * 3])});
+            for (int k = 0; k < 3; k++) quadrics[positionOf[indices[t * 3 + k]]].addPlane(normal, distance, area);
+        }
+
+        std::vector<Edge> edges;
+        std::vector<VertexKind> kinds(vertexCount);
+        std::vector<uint8_t> borderEdges(vertexCount);
+        std::vector<uint32_t> offsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint8_t> touched(vertexCount);
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint32_t> targetWedges;
+        std::vector<uint32_t> result;
+
+        double maxErrorSquared = double(maxError) * double(maxError);
+        double resultError = 0.0;
+        bool firstPass = true;
+
+        while (indices.size() > targetIndexCount)
+        {
+            size_t triangleCount = indices.size() / 3;
+
+            // sorted, so the sides of every edge are next to each other
+            edges.clear();
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t a = positionOf[indices[t * 3 + k]];
+                    uint32_t b = positionOf[indices[t * 3 + (k + 1) % 3]];
+                    if (a != b) edges.push_back({std::min(a, b), std::max(a, b), static_cast<uint32_t>(t)});
+                }
+            }
+            std::sort(edges.begin(), edges.end(), [](const Edge &x, const Edge &y) { return x.a != y.a ? x.a < y.a : x.b < y.b; });
+
+            std::fill(kinds.begin(), kinds.end(), VertexKind::Manifold);
+            std::fill(borderEdges.begin(), borderEdges.end(), 0);
+            for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+            {
+                while (end < edges.size() && edges[end].a == edges[begin].a && edges[end].b == edges[begin].b) end++;
+                const Edge &edge = edges[begin];
+                if (end - begin > 2)
+                {
+                    kinds[edge.a] = kinds[edge.b] = VertexKind::Locked;
+                }
+                else if (end - begin == 1)
+                {
+                    borderEdges[edge.a] = static_cast<uint8_t>(std::min(borderEdges[edge.a] + 1, 255));
+                    borderEdges[edge.b] = static_cast<uint8_t>(std::min(borderEdges[edge.b] + 1, 255));
+
+                    // a plane through the border, upright on its triangle
+                    if (firstPass)
+                    {
+                        glm::dvec3 normal;
+                        double area;
+                        triangleNormal(edge.triangle, normal, area);
+                        glm::dvec3 a{position(edge.a)};
+                        glm::dvec3 side = glm::dvec3{position(edge.b)} - a;
+                        glm::dvec3 planeNormal = glm::cross(side, normal);
+                        double length = glm::length(planeNormal);
+                        if (length > 0.0)
+                        {
+                            planeNormal /= length;
+                            double distance = -glm::dot(planeNormal, a);
+                            double weight = glm::dot(side, side) * BORDER_WEIGHT;
+                            quadrics[edge.a].addPlane(planeNormal, distance, weight);
+                            quadrics[edge.b].addPlane(planeNormal, distance, weight);
+                        }
+                    }
+                }
+            }
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                if (kinds[v] == VertexKind::Locked || borderEdges[v] == 0) continue;
+                kinds[v] = borderEdges[v] == 2 ? VertexKind::Border : VertexKind::Locked;
+            }
+            firstPass = false;
+
+            // triangles around every vertex
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (uint32_t index : indices) offsets[index + 1]++;
+            for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+            adjacency.resize(indices.size());
+            {
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            // the cheaper allowed direction of every edge
+            collapses.clear();
+            for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+            {
+                while (end < edges.size() && edges[end].a == edges[begin].a && edges[end].b == edges[begin].b) end++;
+                uint32_t a = edges[begin].a;
+                uint32_t b = edges[begin].b;
+                bool border = end - begin == 1;
+                auto allowed = [&](uint32_t source)
+                {
+                    return kinds[source] == VertexKind::Manifold || (kinds[source] == VertexKind::Border && border);
+                };
+
+                Collapse best{0, 0, std::numeric_limits<double>::max()};
+                if (allowed(a)) best = {a, b, quadrics[a].error(position(b))};
+                if (allowed(b))
+                {
+                    double error = quadrics[b].error(position(a));
+                    if (error < best.error) best = {b, a, error};
+                }
+                if (best.error <= maxErrorSquared) collapses.push_back(best);
+            }
+            if (collapses.empty()) break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.error < y.error; });
+
+            // most collapses take two triangles with them
+            size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+            size_t expectedCollapses = std::min(collapses.size() - 1, (trianglesToRemove + 1) / 2);
+            double passErrorLimit = collapses[expectedCollapses].error * PASS_ERROR_SLACK;
+
+            std::fill(touched.begin(), touched.end(), 0);
+            for (uint32_t v = 0; v < vertexCount; v++) remap[v] = v;
+            auto resolved = [&](uint32_t index) { return positionOf[remap[index]]; };
+
+            size_t removed = 0;
+            for (const Collapse &collapse : collapses)
+            {
+                if (removed >= trianglesToRemove || collapse.error > passErrorLimit) break;
+                // collapses next to each other in one pass could fold the surface between them
+                if (touched[collapse.source] || touched[collapse.target]) continue;
+
+                // every wedge of the source goes to a wedge of the target it shares a triangle with,
+                // a wedge without one would carry its attributes somewhere they don't belong
+                bool valid = true;
+                targetWedges.clear();
+                uint32_t wedge = collapse.source;
+                do
+                {
+                    uint32_t match = collapse.target;
+                    bool found = false;
+                    for (uint32_t i = offsets[wedge]; i < offsets[wedge + 1] && !found; i++)
+                    {
+                        const uint32_t *corners = &indices[adjacency[i] * 3];
+                        for (int k = 0; k < 3 && !found; k++)
+                        {
+                            if (resolved(corners[k]) == collapse.target)
+                            {
+                                match = remap[corners[k]];
+                                found = true;
+                            }
+                        }
+                    }
+                    valid = valid && found;
+                    targetWedges.push_back(match);
+                    wedge = nextWedge[wedge];
+                } while (valid && wedge != collapse.source);
+                if (!valid) continue;
+
+                // no remaining triangle around the source may turn over
+                size_t degenerate = 0;
+                wedge = collapse.source;
+                do
+                {
+                    for (uint32_t i = offsets[wedge]; i < offsets[wedge + 1] && valid; i++)
+                    {
+                        const uint32_t *corners = &indices[adjacency[i] * 3];
+                        uint32_t p[3] = {resolved(corners[0]), resolved(corners[1]), resolved(corners[2])};
+                        if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) continue;
+                        if (p[0] == collapse.target || p[1] == collapse.target || p[2] == collapse.target)
+                        {
+                            degenerate++;
+                            continue;
+                        }
+
+                        glm::vec3 before = glm::cross(position(p[1]) - position(p[0]), position(p[2]) - position(p[0]));
+                        for (auto &corner : p)
+                        {
+                            if (corner == collapse.source) corner = collapse.target;
+                        }
+                        glm::vec3 after = glm::cross(position(p[1]) - position(p[0]), position(p[2]) - position(p[0]));
+                        valid = glm::dot(before, after) > 0.f;
+                    }
+                    wedge = nextWedge[wedge];
+                } while (valid && wedge != collapse.source);
+                if (!valid) continue;
+
+                wedge = collapse.source;
+                for (uint32_t target : targetWedges)
+                {
+                    remap[wedge] = target;
+                    wedge = nextWedge[wedge];
+                }
+                quadrics[collapse.target] += quadrics[collapse.source];
+                touched[collapse.source] = touched[collapse.target] = 1;
+                removed += degenerate;
+                resultError = std::max(resultError, collapse.error);
+            }
+            if (removed == 0) break;
+
+            result.clear();
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                uint32_t a = remap[indices[t * 3]];
+                uint32_t b = remap[indices[t * 3 + 1]];
+                uint32_t c = remap[indices[t * 3 + 2]];
+                if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c]) continue;
+                result.push_back(a);
+                result.push_back(b);
+                result.push_back(c);
+            }
+            indices.swap(result);
+        }
+
+        return static_cast<float>(std::sqrt(resultError));
+    }
+
+    float averageCacheMissRatio(const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) return 0.f;
+
+        FifoCache cache{vertexCount, cacheSize};
+        size_t misses = 0;
+        for (size_t t = 0; t < triangleCount; t++) misses += cache.misses(&indices[t * 3]);
+        return float(misses) / float(triangleCount);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "model.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace mnlt
+{
+    // simulated post-transform cache size, about what current gpus keep per batch
+    constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+    // Reorders triangles so consecutive ones share vertices still in the post-transform cache,
+    // with Tom Forsyth's linear-speed vertex cache optimisation. Vertices are scored by their
+    // position in a simulated LRU cache and by how many of their triangles are left, and the
+    // triangle with the best score among those around the cached vertices goes next.
+    void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+    // Reorders the output of optimizeVertexCache for less overdraw, after Sander et al.,
+    // "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". The triangles are cut
+    // into clusters where the cache order jumps, and further wherever that costs at most
+    // threshold times the cluster's cache misses, and the clusters are sorted so the ones facing
+    // out from the mesh's centre draw first and occlude the rest.
+    void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices, float threshold = 1.05f);
+
+    // Simplifies the triangle list in indices to about targetIndexCount indices with quadric error
+    // edge collapses, after Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics".
+    // Every collapse moves a vertex onto a neighbour, so the result still indexes vertices and
+    // levels of detail can share one vertex buffer. Vertices along open borders only move along
+    // the border, and vertices split by attribute seams only move along the seam, so neither opens
+    // holes. Stops early when no collapse is left under maxError, a distance in model space, and
+    // returns the largest error it introduced.
+    float simplify(std::vector<uint32_t> &indices, const std::vector<Model::Vertex> &vertices, size_t targetIndexCount, float maxError = std::numeric_limits<float>::max());
+
+    // average cache misses per triangle in a simulated fifo cache, 0.5 at best and 3 at worst
+    float averageCacheMissRatio(const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+}
@@ -1,34 +1,47 @@
 #include "model.hpp"
-#include "utils.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "../../libs/tinyobjloader/tiny_obj_loader.h"
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "mesh_file.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-#include <unordered_map>
 
 #define ENGINE_DIR "../"
 
-namespace std {
-template <>
-struct hash<mnlt::Model::Vertex> {
-  size_t operator()(mnlt::Model::Vertex const &vertex) const {
-    size_t seed = 0;
-    mnlt::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-    return seed;
-  }
-};
-}
-
 namespace mnlt
 {
     Model::Model(Device &device, const Model::BuilderData &builderData) : device{device} 
     {
-        createVertexBuffers(builderData.vertices);
-        createIndexBuffer(builderData.indices);
+        std::vector<PackedVertex> vertices = builderData.packVertices();
+        uint32_t count = static_cast<uint32_t>(vertices.size());
+        createVertexBuffers(vertices.data(), count);
+
+        if (getIndexSize(count) == sizeof(uint16_t))
+        {
+            std::vector<uint16_t> indices(builderData.indices.begin(), builderData.indices.end());
+            createIndexBuffer(indices.data(), static_cast<uint32_t>(indices.size()), sizeof(uint16_t));
+        }
+        else
+        {
+            createIndexBuffer(builderData.indices.data(), static_cast<uint32_t>(builderData.indices.size()), sizeof(uint32_t));
+        }
+
+        lods = builderData.lods;
+        if (lods.empty())
+        {
+            lods.push_back({0, indexCount, 0.f});
+        }
+        boundingSphere = builderData.computeBoundingSphere();
+        boundingBox = builderData.computeBoundingBox();
+    }
+
+    Model::Model(Device &device, const MeshFile &meshFile) : device{device}
+    {
+        // straight from the mapped file into the staging buffer
+        createVertexBuffers(meshFile.getVertices(), meshFile.getVertexCount());
+        createIndexBuffer(meshFile.getIndices(), meshFile.getIndexCount(), meshFile.getIndexSize());
+        lods.assign(meshFile.getLods(), meshFile.getLods() + meshFile.getLodCount());
+        boundingSphere = meshFile.getBoundingSphere();
+        boundingBox = meshFile.getBoundingBox();
     }
 
     Model::~Model() 
@@ -36,32 +49,33 @@ namespace mnlt
         
     }
 
-    std::unique_ptr<Model> Model::createModelFromFile(Device &device, const std::string &filepath)
+    std::unique_ptr<Model> Model::createModelFromFile(Device &device, const std::string &filepath, JobSystem *jobSystem)
     {
+        std::string path = ENGINE_DIR + filepath;
+        if (MeshFile::isMeshFile(path))
+        {
+            return std::make_unique<Model>(device, *MeshFile::open(path));
+        }
+        // prefer the cooked mesh next to the source when the cooker has been run since its last change
+        if (auto meshFile = MeshFile::openCooked(path))
+        {
+            return std::make_unique<Model>(device, *meshFile);
+        }
+
         BuilderData builderData{};
-        builderData.loadModel(ENGINE_DIR + filepath);
+        builderData.loadModel(path, jobSystem);
+        builderData.generateLods();
+        builderData.optimize();
         return std::make_unique<Model>(device, builderData);
     }
 
-    void Model::createVertexBuffers(const std::vector<Vertex> &vertices) 
+    void Model::createVertexBuffers(const PackedVertex *vertices, uint32_t count) 
     {
-        vertexCount = static_cast<uint32_t>(vertices.size());
+        vertexCount = count;
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
         uint32_t vertexSize = sizeof(vertices[0]);
 
-        Buffer stagingBuffer
-        {
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-
         vertexBuffer = std::make_unique<Buffer>
         (
             device,
@@ -71,12 +85,13 @@ namespace mnlt
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         );
 
-        device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        uploadTicket = std::max(uploadTicket, device.uploads().uploadBuffer(vertexBuffer->getBuffer(), vertices, bufferSize));
     }
 
-    void Model::createIndexBuffer(const std::vector<uint32_t> &indices) 
+    void Model::createIndexBuffer(const void *indices, uint32_t count, uint32_t indexSize) 
     {
-        indexCount = static_cast<uint32_t>(indices.size());
+        indexCount = count;
+        indexType = indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
         hasIndexBuffer = indexCount > 0;
 
         if (!hasIndexBuffer) 
@@ -84,20 +99,7 @@ namespace mnlt
             return;
         }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        Buffer stagingBuffer
-        {
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
+        VkDeviceSize bufferSize = VkDeviceSize{indexSize} * indexCount;
 
         indexBuffer = std::make_unique<Buffer>
         (
@@ -108,21 +110,41 @@ namespace mnlt
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
         );
 
-        device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        uploadTicket = std::max(uploadTicket, device.uploads().uploadBuffer(indexBuffer->getBuffer(), indices, bufferSize));
     }
 
-    void Model::draw(VkCommandBuffer commandBuffer) 
+    void Model::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) 
     {
         if (hasIndexBuffer)
         {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            assert(lod < lods.size() && "Lod out of range");
+            vkCmdDrawIndexed(commandBuffer, lods[lod].indexCount, instanceCount, lods[lod].firstIndex, 0, firstInstance);
         } 
         else
         {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
         }
     }
 
+    void Model::drawIndirect(VkCommandBuffer commandBuffer, VkBuffer commands, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount)
+    {
+        assert(hasIndexBuffer && "Indirect draws need an index buffer");
+        vkCmdDrawIndexedIndirectCount(commandBuffer, commands, offset, countBuffer, countOffset, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+
+    uint32_t Model::selectLod(float pixelsPerUnit, float maxPixelError) const
+    {
+        // errors grow with every lod, so the first one from the back that fits is the coarsest
+        for (uint32_t lod = static_cast<uint32_t>(lods.size()) - 1; lod > 0; lod--)
+        {
+            if (lods[lod].error * pixelsPerUnit <= maxPixelError)
+            {
+                return lod;
+            }
+        }
+        return 0;
+    }
+
     void Model::bind(VkCommandBuffer commandBuffer) 
     {
         VkBuffer buffers[] = {vertexBuffer->getBuffer()};
@@ -131,97 +153,30 @@ namespace mnlt
 
         if (hasIndexBuffer) 
         {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
         }
     }
 
-    std::vector<VkVertexInputBindingDescription> Model::Vertex::getBindingDescriptions() 
+    std::vector<VkVertexInputBindingDescription> Model::PackedVertex::getBindingDescriptions() 
     {
         std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
         bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Vertex);
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
         bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
         return bindingDescriptions;
     }
 
-    std::vector<VkVertexInputAttributeDescription> Model::Vertex::getAttributeDescriptions() 
+    std::vector<VkVertexInputAttributeDescription> Model::PackedVertex::getAttributeDescriptions() 
     {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-        attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
-        attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
-        attributeDescriptions.push_back({3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
-        attributeDescriptions.push_back({4, 0, VK_FORMAT_R32_SINT, offsetof(Vertex, layerIndex)});
+        // every format here is one vulkan requires for vertex buffers
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(PackedVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv)});
+        attributeDescriptions.push_back({4, 0, VK_FORMAT_R8_UINT, offsetof(PackedVertex, layerIndex)});
 
         return attributeDescriptions;
     }
-
-    void Model::BuilderData::loadModel(const std::string &filepath) 
-    {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
-
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) 
-        {
-            throw std::runtime_error(warn + err);
-        }
-
-        vertices.clear();
-        indices.clear();
-
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        for (const auto &shape : shapes) 
-        {
-            //std::cout << shape.name.c_str() << std::endl;
-            for (const auto &index : shape.mesh.indices) 
-            {
-                Vertex vertex{};
-
-                if (index.vertex_index >= 0) 
-                {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2],
-                    };
-
-                    vertex.color = 
-                    {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2],
-                    };
-                }
-
-                if (index.normal_index >= 0) 
-                {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2],
-                    };
-                }
-
-                if (index.texcoord_index >= 0) 
-                {
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1],
-                    };
-                }
-                
-                vertex.layerIndex = 0;
-
-                if (uniqueVertices.count(vertex) == 0) 
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-                indices.push_back(uniqueVertices[vertex]);
-            }
-        }
-    }
 }
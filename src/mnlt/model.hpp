@@ -7,13 +7,21 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+
+// std
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace mnlt 
 {
+    class JobSystem;
+    class MeshFile;
+
     class Model
     {
         public:
+            // full precision, meshes are loaded and processed in this and packed for upload
             struct Vertex 
             {
                 glm::vec3 position;
@@ -22,34 +30,119 @@ namespace mnlt
                 glm::vec2 uv{};
                 int layerIndex;
 
+                bool operator==(const Vertex &other) const { return position == other.position && color == other.color && normal == other.normal && uv == other.uv; }
+            };
+
+            // what the vertex buffers hold, 24 bytes against the 48 of Vertex
+            struct PackedVertex
+            {
+                glm::vec3 position;
+                // octahedral encoded unit normal as snorm, the shaders decode it
+                int16_t normal[2];
+                // half floats
+                uint16_t uv[2];
+                // unorm rgb, the vertex input reads layerIndex along as the unused alpha
+                uint8_t color[3];
+                // clamped to 255 layers
+                uint8_t layerIndex;
+
+                static PackedVertex pack(const Vertex &vertex);
+
                 static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
                 static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+            };
 
-                bool operator==(const Vertex &other) const { return position == other.position && color == other.color && normal == other.normal && uv == other.uv; }
+            // one level of detail, a range of the shared index buffer
+            struct Lod
+            {
+                uint32_t firstIndex;
+                uint32_t indexCount;
+                // about how far in model space its surface strays from the full detail mesh
+                float error;
+            };
+
+            struct BoundingSphere
+            {
+                glm::vec3 center{0.f};
+                float radius = 0.f;
+            };
+
+            struct BoundingBox
+            {
+                glm::vec3 min{0.f};
+                glm::vec3 max{0.f};
             };
 
+            // the full detail mesh and up to four simplified ones, each with about half the triangles of the last
+            static constexpr uint32_t MAX_LOD_COUNT = 5;
+
             struct BuilderData 
             {
                 std::vector<Vertex> vertices{};
+                // the index ranges of all lods one after the other
                 std::vector<uint32_t> indices{};
-
-                void loadModel(const std::string &filepath);
+                // empty until generateLods, which stands for a single lod over all indices
+                std::vector<Lod> lods{};
+
+                // parses an obj file with ObjImporter, or tinyobjloader for what it leaves out, and
+                // merges identical vertices. Large files are split over jobSystem when there is one
+                void loadModel(const std::string &filepath, JobSystem *jobSystem = nullptr);
+                // appends simplified copies of the indices for the lower lods, see simplify in
+                // mesh_optimizer.hpp. Stops early for meshes that barely simplify, like flat shaded
+                // ones where every edge is an attribute seam
+                void generateLods();
+                // reorders every lod for the post-transform vertex cache, then for overdraw, then all
+                // of them for vertex fetch, see mesh_optimizer.hpp
+                void optimize();
+                // reorders vertices by first use in the index buffer, so the vertex fetches of
+                // neighbouring triangles hit the same cache lines
+                void optimizeVertexFetch();
+
+                std::vector<PackedVertex> packVertices() const;
+                BoundingBox computeBoundingBox() const;
+                // centred on the bounding box, not the smallest sphere but close for most meshes
+                BoundingSphere computeBoundingSphere() const;
             };
 
             Model(Device &device, const Model::BuilderData &BuilderData);
+            Model(Device &device, const MeshFile &meshFile);
             ~Model();
 
             Model(const Model &) = delete;
             Model &operator=(const Model &) = delete;
 
-            static std::unique_ptr<Model> createModelFromFile(Device &device, const std::string &filepath);
+            // jobSystem is only used for obj files without an up to date cooked mesh
+            static std::unique_ptr<Model> createModelFromFile(Device &device, const std::string &filepath, JobSystem *jobSystem = nullptr);
+
+            // 16 bit indices when they can address every vertex
+            static uint32_t getIndexSize(uint32_t vertexCount) { return vertexCount < 65536 ? 2 : 4; }
 
             void bind(VkCommandBuffer commandBuffer);
-            void draw(VkCommandBuffer commandBuffer);
+            // firstInstance offsets gl_InstanceIndex, so batches can share one instance buffer
+            void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+            // up to maxDrawCount VkDrawIndexedIndirectCommands from commandBuffer at offset, as many as
+            // the uint32_t at countOffset in countBuffer says, see Device::hasDrawIndirectCount
+            void drawIndirect(VkCommandBuffer commandBuffer, VkBuffer commands, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount);
+
+            // the coarsest lod whose error stays under maxPixelError on screen, where pixelsPerUnit is
+            // what one unit of model space covers at the model's distance, see Camera::getPixelsPerUnit
+            uint32_t selectLod(float pixelsPerUnit, float maxPixelError = 1.f) const;
+            uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+            const Lod &getLod(uint32_t lod) const { return lods[lod]; }
+            // every model from a file or BuilderData with indices is, only those can draw indirect
+            bool isIndexed() const { return hasIndexBuffer; }
+            // model space bounds, both computed at load
+            const BoundingSphere &getBoundingSphere() const { return boundingSphere; }
+            const BoundingBox &getBoundingBox() const { return boundingBox; }
+
+            // complete once the vertex and index data has reached the gpu, see UploadManager::isComplete
+            uint64_t getUploadTicket() const { return uploadTicket; }
+            // device memory taken by the vertex and index buffers
+            VkDeviceSize getMemorySize() const { return vertexBuffer->getBufferSize() + (hasIndexBuffer ? indexBuffer->getBufferSize() : 0); }
 
         private:
-            void createVertexBuffers(const std::vector<Vertex> &vertices);
-            void createIndexBuffer(const std::vector<uint32_t> &indices);
+            void createVertexBuffers(const PackedVertex *vertices, uint32_t count);
+            void createIndexBuffer(const void *indices, uint32_t count, uint32_t indexSize);
 
             Device &device;
 
@@ -59,6 +152,11 @@ namespace mnlt
             bool hasIndexBuffer = false;
             std::unique_ptr<Buffer> indexBuffer;
             uint32_t indexCount;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+            std::vector<Lod> lods;
+            BoundingSphere boundingSphere;
+            BoundingBox boundingBox;
+            uint64_t uploadTicket = 0;
 
             std::string modelFilePath;
     };
@@ -0,0 +1,257 @@
+#include "model.hpp"
+#include "mesh_optimizer.hpp"
+#include "obj_importer.hpp"
+
+// libs
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../../libs/tinyobjloader/tiny_obj_loader.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+// obj import and mesh preprocessing, kept free of vulkan calls so the mesh cooker can link it
+namespace mnlt
+{
+    // round to nearest even, out of range values become infinity and tiny ones subnormal or zero
+    static uint16_t floatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t floatExponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        if (floatExponent == 0xff)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+        }
+        int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+        if (exponent >= 31)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00);
+        }
+        if (exponent <= 0)
+        {
+            if (exponent < -10) return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // a carry out of the mantissa rounds up into the exponent, which is still right
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1fff;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    static int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+    }
+
+    static uint8_t toUnorm8(float value)
+    {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+    }
+
+    Model::PackedVertex Model::PackedVertex::pack(const Vertex &vertex)
+    {
+        PackedVertex packed{};
+        packed.position = vertex.position;
+
+        // project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the upper,
+        // a zero normal ends up as +z
+        glm::vec3 n = vertex.normal;
+        float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 octahedral{0.f};
+        if (length > 0.f)
+        {
+            n /= length;
+            octahedral = {n.x, n.y};
+            if (n.z < 0.f)
+            {
+                octahedral.x = (1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f);
+                octahedral.y = (1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f);
+            }
+        }
+        packed.normal[0] = toSnorm16(octahedral.x);
+        packed.normal[1] = toSnorm16(octahedral.y);
+
+        packed.uv[0] = floatToHalf(vertex.uv.x);
+        packed.uv[1] = floatToHalf(vertex.uv.y);
+        packed.color[0] = toUnorm8(vertex.color.x);
+        packed.color[1] = toUnorm8(vertex.color.y);
+        packed.color[2] = toUnorm8(vertex.color.z);
+        packed.layerIndex = static_cast<uint8_t>(std::clamp(vertex.layerIndex, 0, 255));
+        return packed;
+    }
+
+    // for the obj features ObjImporter leaves out, like polygons with more than four corners
+    static ObjImporter::ObjData loadWithTinyObj(const std::string &filepath)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+
+        ObjImporter::ObjData data{};
+        for (size_t i = 0; i + 2 < attrib.vertices.size(); i += 3)
+        {
+            data.positions.push_back({attrib.vertices[i], attrib.vertices[i + 1], attrib.vertices[i + 2]});
+            data.colors.push_back({attrib.colors[i], attrib.colors[i + 1], attrib.colors[i + 2]});
+        }
+        for (size_t i = 0; i + 1 < attrib.texcoords.size(); i += 2)
+        {
+            data.texcoords.push_back({attrib.texcoords[i], attrib.texcoords[i + 1]});
+        }
+        for (size_t i = 0; i + 2 < attrib.normals.size(); i += 3)
+        {
+            data.normals.push_back({attrib.normals[i], attrib.normals[i + 1], attrib.normals[i + 2]});
+        }
+        for (const auto &shape : shapes)
+        {
+            for (const auto &index : shape.mesh.indices)
+            {
+                data.corners.push_back({index.vertex_index, index.texcoord_index, index.normal_index});
+            }
+        }
+        return data;
+    }
+
+    void Model::BuilderData::loadModel(const std::string &filepath, JobSystem *jobSystem) 
+    {
+        ObjImporter importer{jobSystem};
+        ObjImporter::ObjData data{};
+        std::string error;
+        if (!importer.parse(filepath, data, error))
+        {
+            std::cerr << "loading " << filepath << " with tinyobjloader: " << error << std::endl;
+            data = loadWithTinyObj(filepath);
+        }
+        importer.build(data, *this);
+    }
+
+    void Model::BuilderData::generateLods()
+    {
+        // a lod below this many triangles saves too little to be worth another range
+        constexpr size_t MIN_LOD_TRIANGLES = 64;
+        // and one that keeps more than this share of the last didn't simplify much
+        constexpr float MAX_LOD_RATIO = 0.75f;
+
+        lods.clear();
+        lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.f});
+
+        std::vector<uint32_t> lodIndices = indices;
+        float error = 0.f;
+        while (lods.size() < MAX_LOD_COUNT && lodIndices.size() / 3 >= MIN_LOD_TRIANGLES * 2)
+        {
+            size_t previousCount = lodIndices.size();
+            // each lod is simplified from the last, so its error adds up with theirs
+            error += simplify(lodIndices, vertices, previousCount / 6 * 3);
+            if (lodIndices.size() > previousCount * MAX_LOD_RATIO)
+            {
+                break;
+            }
+
+            lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), error});
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        }
+    }
+
+    void Model::BuilderData::optimize()
+    {
+        if (lods.empty())
+        {
+            lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.f});
+        }
+
+        std::vector<uint32_t> lodIndices;
+        for (const auto &lod : lods)
+        {
+            auto begin = indices.begin() + lod.firstIndex;
+            lodIndices.assign(begin, begin + lod.indexCount);
+            optimizeVertexCache(lodIndices, vertices.size());
+            optimizeOverdraw(lodIndices, vertices);
+            std::copy(lodIndices.begin(), lodIndices.end(), begin);
+        }
+        // lod 0 comes first and uses every vertex, so it decides the order
+        optimizeVertexFetch();
+    }
+
+    std::vector<Model::PackedVertex> Model::BuilderData::packVertices() const
+    {
+        std::vector<PackedVertex> packed(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), packed.begin(), PackedVertex::pack);
+        return packed;
+    }
+
+    Model::BoundingBox Model::BuilderData::computeBoundingBox() const
+    {
+        if (vertices.empty())
+        {
+            return {};
+        }
+
+        BoundingBox box{vertices[0].position, vertices[0].position};
+        for (const auto &vertex : vertices)
+        {
+            box.min = glm::min(box.min, vertex.position);
+            box.max = glm::max(box.max, vertex.position);
+        }
+        return box;
+    }
+
+    Model::BoundingSphere Model::BuilderData::computeBoundingSphere() const
+    {
+        BoundingBox box = computeBoundingBox();
+        BoundingSphere sphere{};
+        sphere.center = (box.min + box.max) * 0.5f;
+        for (const auto &vertex : vertices)
+        {
+            glm::vec3 offset = vertex.position - sphere.center;
+            sphere.radius = std::max(sphere.radius, glm::dot(offset, offset));
+        }
+        sphere.radius = std::sqrt(sphere.radius);
+        return sphere;
+    }
+
+    void Model::BuilderData::optimizeVertexFetch()
+    {
+        if (indices.empty())
+        {
+            return;
+        }
+
+        constexpr uint32_t unassigned = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(vertices.size(), unassigned);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+
+        for (auto &index : indices)
+        {
+            if (remap[index] == unassigned)
+            {
+                remap[index] = static_cast<uint32_t>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        // vertices no triangle refers to are dropped
+        vertices = std::move(ordered);
+    }
+}
@@ -0,0 +1,564 @@
+#include "obj_importer.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace mnlt
+{
+    namespace
+    {
+        // one slice of the file, parsed by one job
+        struct Chunk
+        {
+            const char *begin;
+            const char *end;
+
+            // v, vt and vn lines in the chunk, and the index of the first of each in the whole file
+            size_t positionCount = 0;
+            size_t texcoordCount = 0;
+            size_t normalCount = 0;
+            size_t positionBase = 0;
+            size_t texcoordBase = 0;
+            size_t normalBase = 0;
+
+            std::vector<ObjImporter::Corner> corners;
+            // first corner of every quad, split along the shorter diagonal once all positions are known
+            std::vector<size_t> quads;
+            std::string error;
+        };
+
+        bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        void skipSpace(const char *&p, const char *end)
+        {
+            while (p < end && isSpace(*p)) p++;
+        }
+
+        // nothing but whitespace or a comment left on the line
+        bool atLineEnd(const char *p, const char *end)
+        {
+            skipSpace(p, end);
+            return p == end || *p == '#';
+        }
+
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        // strtof is locale dependent and slow, this covers the decimal and exponent forms exporters write
+        bool parseFloat(const char *&p, const char *end, float &value)
+        {
+            static const double powersOfTen[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+            constexpr uint64_t maxMantissa = 1000000000000000000ull;
+
+            skipSpace(p, end);
+            const char *start = p;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+'))
+            {
+                negative = *p == '-';
+                p++;
+            }
+
+            // digits past what the mantissa holds only move the exponent
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            int digits = 0;
+            for (; p < end && isDigit(*p); p++, digits++)
+            {
+                if (mantissa < maxMantissa) mantissa = mantissa * 10 + (*p - '0');
+                else exponent++;
+            }
+            if (p < end && *p == '.')
+            {
+                for (p++; p < end && isDigit(*p); p++, digits++)
+                {
+                    if (mantissa < maxMantissa)
+                    {
+                        mantissa = mantissa * 10 + (*p - '0');
+                        exponent--;
+                    }
+                }
+            }
+            if (digits == 0)
+            {
+                p = start;
+                return false;
+            }
+
+            if (p < end && (*p == 'e' || *p == 'E'))
+            {
+                p++;
+                bool negativeExponent = false;
+                if (p < end && (*p == '-' || *p == '+'))
+                {
+                    negativeExponent = *p == '-';
+                    p++;
+                }
+                int exponentValue = 0;
+                int exponentDigits = 0;
+                for (; p < end && isDigit(*p); p++, exponentDigits++)
+                {
+                    if (exponentValue < 10000) exponentValue = exponentValue * 10 + (*p - '0');
+                }
+                if (exponentDigits == 0)
+                {
+                    p = start;
+                    return false;
+                }
+                exponent += negativeExponent ? -exponentValue : exponentValue;
+            }
+            if (p < end && !isSpace(*p) && *p != '#')
+            {
+                p = start;
+                return false;
+            }
+
+            // dividing by an exact power of ten rounds better than multiplying by its inverse
+            double result = static_cast<double>(mantissa);
+            for (; exponent > 22; exponent -= 22) result *= powersOfTen[22];
+            for (; exponent < -22; exponent += 22) result /= powersOfTen[22];
+            result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+            value = static_cast<float>(negative ? -result : result);
+            return true;
+        }
+
+        bool parseIndex(const char *&p, const char *end, int64_t &value)
+        {
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+'))
+            {
+                negative = *p == '-';
+                p++;
+            }
+            if (p == end || !isDigit(*p)) return false;
+
+            value = 0;
+            for (; p < end && isDigit(*p); p++)
+            {
+                if (value > std::numeric_limits<int32_t>::max()) return false;
+                value = value * 10 + (*p - '0');
+            }
+            if (negative) value = -value;
+            return true;
+        }
+
+        // obj indices count from one, negative ones count back from the last attribute so far
+        bool resolveIndex(int64_t index, size_t current, size_t total, int32_t &resolved)
+        {
+            int64_t absolute = index > 0 ? index - 1 : static_cast<int64_t>(current) + index;
+            if (index == 0 || absolute < 0 || absolute >= static_cast<int64_t>(total)) return false;
+            resolved = static_cast<int32_t>(absolute);
+            return true;
+        }
+
+        // the statement a line starts with, as far as counting and parsing care
+        enum class LineType
+        {
+            Position,
+            Texcoord,
+            Normal,
+            Face,
+            Other,
+        };
+
+        LineType lineType(const char *p, const char *end)
+        {
+            if (end - p < 2) return LineType::Other;
+            if (p[0] == 'f' && isSpace(p[1])) return LineType::Face;
+            if (p[0] != 'v') return LineType::Other;
+            if (isSpace(p[1])) return LineType::Position;
+            if (end - p < 3 || !isSpace(p[2])) return LineType::Other;
+            if (p[1] == 't') return LineType::Texcoord;
+            if (p[1] == 'n') return LineType::Normal;
+            return LineType::Other;
+        }
+
+        // calls func(lineBegin, lineEnd) with leading whitespace skipped, for every line of the chunk
+        template <typename Func>
+        void forEachLine(const Chunk &chunk, Func &&func)
+        {
+            const char *p = chunk.begin;
+            while (p < chunk.end)
+            {
+                const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', chunk.end - p));
+                if (!lineEnd) lineEnd = chunk.end;
+                skipSpace(p, lineEnd);
+                if (!func(p, lineEnd)) return;
+                p = lineEnd + 1;
+            }
+        }
+
+        void countAttributes(Chunk &chunk)
+        {
+            forEachLine(chunk, [&](const char *p, const char *end)
+            {
+                switch (lineType(p, end))
+                {
+                    case LineType::Position: chunk.positionCount++; break;
+                    case LineType::Texcoord: chunk.texcoordCount++; break;
+                    case LineType::Normal: chunk.normalCount++; break;
+                    default: break;
+                }
+                return true;
+            });
+        }
+
+        void parseChunk(Chunk &chunk, ObjImporter::ObjData &data)
+        {
+            size_t positionIndex = chunk.positionBase;
+            size_t texcoordIndex = chunk.texcoordBase;
+            size_t normalIndex = chunk.normalBase;
+            ObjImporter::Corner face[4];
+
+            forEachLine(chunk, [&](const char *p, const char *end)
+            {
+                LineType type = lineType(p, end);
+                switch (type)
+                {
+                    case LineType::Position:
+                    {
+                        p += 2;
+                        glm::vec3 &position = data.positions[positionIndex];
+                        if (!parseFloat(p, end, position.x) || !parseFloat(p, end, position.y) || !parseFloat(p, end, position.z))
+                        {
+                            chunk.error = "malformed vertex position";
+                            return false;
+                        }
+                        // an optional w, or an rgb vertex color
+                        float extra[3];
+                        int extraCount = 0;
+                        while (extraCount < 3 && parseFloat(p, end, extra[extraCount])) extraCount++;
+                        if (!atLineEnd(p, end) || extraCount == 2)
+                        {
+                            chunk.error = "unsupported vertex position";
+                            return false;
+                        }
+                        if (extraCount == 3)
+                        {
+                            data.colors[positionIndex] = {extra[0], extra[1], extra[2]};
+                        }
+                        else
+                        {
+                            data.colors[positionIndex] = glm::vec3{1.f};
+                        }
+                        positionIndex++;
+                        return true;
+                    }
+                    case LineType::Texcoord:
+                    {
+                        p += 3;
+                        glm::vec2 &texcoord = data.texcoords[texcoordIndex++];
+                        texcoord = glm::vec2{0.f};
+                        float w;
+                        if (!parseFloat(p, end, texcoord.x))
+                        {
+                            chunk.error = "malformed texture coordinate";
+                            return false;
+                        }
+                        if (parseFloat(p, end, texcoord.y))
+                        {
+                            parseFloat(p, end, w);
+                        }
+                        if (!atLineEnd(p, end))
+                        {
+                            chunk.error = "malformed texture coordinate";
+                            return false;
+                        }
+                        return true;
+                    }
+                    case LineType::Normal:
+                    {
+                        p += 3;
+                        glm::vec3 &normal = data.normals[normalIndex++];
+                        if (!parseFloat(p, end, normal.x) || !parseFloat(p, end, normal.y) || !parseFloat(p, end, normal.z) || !atLineEnd(p, end))
+                        {
+                            chunk.error = "malformed vertex normal";
+                            return false;
+                        }
+                        return true;
+                    }
+                    case LineType::Face:
+                    {
+                        p += 2;
+                        int cornerCount = 0;
+                        skipSpace(p, end);
+                        while (p < end && *p != '#')
+                        {
+                            if (cornerCount == 4)
+                            {
+                                chunk.error = "polygons with more than four corners";
+                                return false;
+                            }
+
+                            // v, v/vt, v//vn or v/vt/vn
+                            ObjImporter::Corner &corner = face[cornerCount++];
+                            corner = {-1, -1, -1};
+                            int64_t index;
+                            bool valid = parseIndex(p, end, index) && resolveIndex(index, positionIndex, data.positions.size(), corner.position);
+                            if (valid && p < end && *p == '/')
+                            {
+                                p++;
+                                if (p < end && *p != '/')
+                                {
+                                    valid = parseIndex(p, end, index) && resolveIndex(index, texcoordIndex, data.texcoords.size(), corner.texcoord);
+                                }
+                                if (valid && p < end && *p == '/')
+                                {
+                                    p++;
+                                    valid = parseIndex(p, end, index) && resolveIndex(index, normalIndex, data.normals.size(), corner.normal);
+                                }
+                            }
+                            if (!valid || (p < end && !isSpace(*p) && *p != '#'))
+                            {
+                                chunk.error = "malformed face";
+                                return false;
+                            }
+                            skipSpace(p, end);
+                        }
+
+                        if (cornerCount < 3)
+                        {
+                            chunk.error = "face with less than three corners";
+                            return false;
+                        }
+                        if (cornerCount == 4)
+                        {
+                            // split as 0 1 2 and 0 2 3 for now
+                            chunk.quads.push_back(chunk.corners.size());
+                            chunk.corners.insert(chunk.corners.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+                        }
+                        else
+                        {
+                            chunk.corners.insert(chunk.corners.end(), {face[0], face[1], face[2]});
+                        }
+                        return true;
+                    }
+                    default:
+                        return true;
+                }
+            });
+        }
+
+        // the other diagonal when it is the shorter one, which is how tinyobjloader splits quads
+        void splitQuads(Chunk &chunk, const std::vector<glm::vec3> &positions)
+        {
+            for (size_t first : chunk.quads)
+            {
+                ObjImporter::Corner *corners = &chunk.corners[first];
+                ObjImporter::Corner quad[4] = {corners[0], corners[1], corners[2], corners[5]};
+                glm::vec3 diagonal02 = positions[quad[2].position] - positions[quad[0].position];
+                glm::vec3 diagonal13 = positions[quad[3].position] - positions[quad[1].position];
+                if (glm::dot(diagonal02, diagonal02) >= glm::dot(diagonal13, diagonal13))
+                {
+                    ObjImporter::Corner split[6] = {quad[0], quad[1], quad[3], quad[1], quad[2], quad[3]};
+                    std::copy(split, split + 6, corners);
+                }
+            }
+        }
+
+        Model::Vertex makeVertex(const ObjImporter::ObjData &data, const ObjImporter::Corner &corner)
+        {
+            Model::Vertex vertex{};
+            vertex.position = data.positions[corner.position];
+            vertex.color = data.colors[corner.position];
+            if (corner.normal >= 0) vertex.normal = data.normals[corner.normal];
+            if (corner.texcoord >= 0) vertex.uv = data.texcoords[corner.texcoord];
+            vertex.layerIndex = 0;
+            return vertex;
+        }
+
+        // over the fields Vertex::operator== compares, layerIndex is always zero here
+        uint32_t hashVertex(const Model::Vertex &vertex)
+        {
+            uint32_t words[11];
+            std::memcpy(words, &vertex.position, sizeof(vertex.position));
+            std::memcpy(words + 3, &vertex.color, sizeof(vertex.color));
+            std::memcpy(words + 6, &vertex.normal, sizeof(vertex.normal));
+            std::memcpy(words + 9, &vertex.uv, sizeof(vertex.uv));
+
+            uint64_t hash = 0x9e3779b97f4a7c15ull;
+            for (uint32_t word : words)
+            {
+                hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+                hash ^= hash >> 32;
+            }
+            return static_cast<uint32_t>(hash);
+        }
+    }
+
+    template <typename Func>
+    void ObjImporter::parallelFor(size_t count, size_t minChunkSize, Func &&func)
+    {
+        if (count <= minChunkSize || !jobSystem)
+        {
+            if (count > 0) func(size_t{0}, count);
+            return;
+        }
+        jobSystem->parallelFor(count, minChunkSize, std::forward<Func>(func));
+    }
+
+    bool ObjImporter::parse(const std::string &filepath, ObjData &data, std::string &error)
+    {
+        std::ifstream file{filepath, std::ios::binary | std::ios::ate};
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+        std::vector<char> content(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(content.data(), content.size());
+        if (!file)
+        {
+            throw std::runtime_error("failed to read file: " + filepath);
+        }
+
+        // a few chunks per thread so stealing can even out dense and sparse parts of the file
+        size_t maxChunks = ((jobSystem ? jobSystem->getWorkerCount() : 0) + 1) * 4;
+        size_t chunkCount = std::max<size_t>(1, std::min(content.size() / MIN_CHUNK_SIZE, maxChunks));
+        std::vector<Chunk> chunks(chunkCount);
+        const char *begin = content.data();
+        const char *end = content.data() + content.size();
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            chunks[i].begin = i == 0 ? begin : chunks[i - 1].end;
+            const char *split = i + 1 == chunkCount ? end : std::max(chunks[i].begin, begin + content.size() * (i + 1) / chunkCount);
+            // every chunk ends just past a line break
+            const char *lineEnd = static_cast<const char *>(std::memchr(split, '\n', end - split));
+            chunks[i].end = lineEnd ? lineEnd + 1 : end;
+        }
+
+        parallelFor(chunks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++) countAttributes(chunks[i]);
+        });
+
+        size_t positionCount = 0, texcoordCount = 0, normalCount = 0;
+        for (auto &chunk : chunks)
+        {
+            chunk.positionBase = positionCount;
+            chunk.texcoordBase = texcoordCount;
+            chunk.normalBase = normalCount;
+            positionCount += chunk.positionCount;
+            texcoordCount += chunk.texcoordCount;
+            normalCount += chunk.normalCount;
+        }
+        if (std::max({positionCount, texcoordCount, normalCount}) > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        {
+            error = "too many vertices";
+            return false;
+        }
+
+        data.positions.resize(positionCount);
+        data.colors.resize(positionCount);
+        data.texcoords.resize(texcoordCount);
+        data.normals.resize(normalCount);
+        parallelFor(chunks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++) parseChunk(chunks[i], data);
+        });
+
+        size_t cornerCount = 0;
+        for (auto &chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                error = chunk.error;
+                return false;
+            }
+            cornerCount += chunk.corners.size();
+        }
+
+        // quads can refer to positions of any chunk, so they are split once every chunk is parsed
+        parallelFor(chunks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++) splitQuads(chunks[i], data.positions);
+        });
+
+        data.corners.clear();
+        data.corners.reserve(cornerCount);
+        for (auto &chunk : chunks)
+        {
+            data.corners.insert(data.corners.end(), chunk.corners.begin(), chunk.corners.end());
+        }
+        return true;
+    }
+
+    void ObjImporter::build(ObjData &data, Model::BuilderData &builderData)
+    {
+        if (std::any_of(data.corners.begin(), data.corners.end(), [](const Corner &corner) { return corner.normal < 0; }))
+        {
+            computeMissingNormals(data);
+        }
+
+        size_t cornerCount = data.corners.size();
+        std::vector<uint32_t> hashes(cornerCount);
+        parallelFor(cornerCount, MIN_CORNER_CHUNK, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++) hashes[i] = hashVertex(makeVertex(data, data.corners[i]));
+        });
+
+        // linear probing in a table at most half full
+        constexpr uint32_t empty = std::numeric_limits<uint32_t>::max();
+        size_t capacity = 16;
+        while (capacity < cornerCount * 2) capacity *= 2;
+        std::vector<uint32_t> table(capacity, empty);
+        size_t mask = capacity - 1;
+
+        builderData.vertices.clear();
+        builderData.indices.resize(cornerCount);
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            Model::Vertex vertex = makeVertex(data, data.corners[i]);
+            size_t slot = hashes[i] & mask;
+            while (table[slot] != empty && !(builderData.vertices[table[slot]] == vertex))
+            {
+                slot = (slot + 1) & mask;
+            }
+            if (table[slot] == empty)
+            {
+                table[slot] = static_cast<uint32_t>(builderData.vertices.size());
+                builderData.vertices.push_back(vertex);
+            }
+            builderData.indices[i] = table[slot];
+        }
+    }
+
+    void ObjImporter::computeMissingNormals(ObjData &data)
+    {
+        // the cross product is twice the triangle's area, so big faces weigh more
+        std::vector<glm::vec3> accumulated(data.positions.size(), glm::vec3{0.f});
+        for (size_t i = 0; i + 2 < data.corners.size(); i += 3)
+        {
+            int32_t a = data.corners[i].position;
+            int32_t b = data.corners[i + 1].position;
+            int32_t c = data.corners[i + 2].position;
+            glm::vec3 normal = glm::cross(data.positions[b] - data.positions[a], data.positions[c] - data.positions[a]);
+            accumulated[a] += normal;
+            accumulated[b] += normal;
+            accumulated[c] += normal;
+        }
+
+        size_t base = data.normals.size();
+        data.normals.reserve(base + accumulated.size());
+        for (auto &normal : accumulated)
+        {
+            float length = glm::length(normal);
+            data.normals.push_back(length > 0.f ? normal / length : glm::vec3{0.f});
+        }
+        for (auto &corner : data.corners)
+        {
+            if (corner.normal < 0) corner.normal = static_cast<int32_t>(base + corner.position);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "job_system.hpp"
+#include "model.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mnlt
+{
+    // Parses obj files in parallel. The file is split into chunks at line breaks, a first pass
+    // counts the v, vt and vn lines of every chunk so each chunk knows where its attributes land,
+    // and a second pass parses every chunk straight into the shared attribute arrays.
+    //
+    // Handles what Model uses: positions with optional vertex colors, texcoords, normals, and
+    // triangle and quad faces. Anything else makes parse() fail, so the caller can fall back to
+    // tinyobjloader. Statements that don't add geometry (o, g, s, usemtl, ...) are skipped.
+    //
+    // Files big enough to be worth it are split over the job system the caller passes in, which
+    // stays in charge of how many threads imports get. Without one everything runs on the calling thread.
+    class ObjImporter
+    {
+        public:
+            // below this many bytes or corners the work stays on the calling thread
+            static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+            static constexpr size_t MIN_CORNER_CHUNK = 1 << 16;
+
+            // attribute indices of a face corner, -1 when the face leaves the attribute out
+            struct Corner
+            {
+                int32_t position;
+                int32_t texcoord;
+                int32_t normal;
+            };
+
+            struct ObjData
+            {
+                std::vector<glm::vec3> positions;
+                // white when the file has no vertex colors, one per position
+                std::vector<glm::vec3> colors;
+                std::vector<glm::vec2> texcoords;
+                std::vector<glm::vec3> normals;
+                // every three make a triangle
+                std::vector<Corner> corners;
+            };
+
+            explicit ObjImporter(JobSystem *jobSystem = nullptr) : jobSystem{jobSystem} {}
+
+            ObjImporter(const ObjImporter &) = delete;
+            ObjImporter &operator=(const ObjImporter &) = delete;
+
+            // false with the reason in error when the file needs tinyobjloader, throws when it can't be read
+            bool parse(const std::string &filepath, ObjData &data, std::string &error);
+
+            // gives corners without a normal the area weighted normal of their position, and merges
+            // identical vertices through an open addressing table
+            void build(ObjData &data, Model::BuilderData &builderData);
+
+        private:
+            // runs on the job system once count is over minChunkSize, on the calling thread otherwise
+            template <typename Func>
+            void parallelFor(size_t count, size_t minChunkSize, Func &&func);
+
+            void computeMissingNormals(ObjData &data);
+
+            JobSystem *jobSystem;
+    };
+}
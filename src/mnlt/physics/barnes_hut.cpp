@@ -0,0 +1,183 @@
+#include "barnes_hut.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace mnlt
+{
+    void BarnesHutTree::build(const float *positionX, const float *positionY, const float *positionZ, const float *mass, size_t count)
+    {
+        // splitting only permutes order, the body arrays are gathered into tree order at the end
+        sortedX.assign(positionX, positionX + count);
+        sortedY.assign(positionY, positionY + count);
+        sortedZ.assign(positionZ, positionZ + count);
+        sortedMass.assign(mass, mass + count);
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        octants.resize(count);
+        scratch.resize(count);
+
+        glm::vec3 lowerBound{0.f};
+        glm::vec3 upperBound{0.f};
+        if (count > 0)
+        {
+            lowerBound = upperBound = bodyPosition(0);
+            for (uint32_t i = 1; i < count; i++)
+            {
+                lowerBound = glm::min(lowerBound, bodyPosition(i));
+                upperBound = glm::max(upperBound, bodyPosition(i));
+            }
+        }
+        glm::vec3 extent = upperBound - lowerBound;
+
+        nodes.clear();
+        Node root{};
+        root.center = (lowerBound + upperBound) * 0.5f;
+        // cubic cells keep the opening test a single size, padded so the far faces are inside
+        root.halfSize = std::max({extent.x, extent.y, extent.z}) * 0.5f * 1.001f + 1e-6f;
+        root.bodyEnd = static_cast<uint32_t>(count);
+        nodes.push_back(root);
+        buildNode(0, 0);
+
+        for (auto *values : {&sortedX, &sortedY, &sortedZ, &sortedMass})
+        {
+            std::vector<float> unsorted = *values;
+            for (uint32_t slot = 0; slot < count; slot++)
+            {
+                (*values)[slot] = unsorted[order[slot]];
+            }
+        }
+    }
+
+    void BarnesHutTree::buildNode(uint32_t nodeIndex, int depth)
+    {
+        // copies, nodes may reallocate while children are added
+        uint32_t begin = nodes[nodeIndex].bodyBegin;
+        uint32_t end = nodes[nodeIndex].bodyEnd;
+        glm::vec3 center = nodes[nodeIndex].center;
+        float halfSize = nodes[nodeIndex].halfSize;
+
+        if (end - begin <= LEAF_SIZE || depth >= MAX_DEPTH)
+        {
+            float totalMass = 0.f;
+            glm::vec3 weightedPosition{0.f};
+            for (uint32_t slot = begin; slot < end; slot++)
+            {
+                uint32_t body = order[slot];
+                totalMass += sortedMass[body];
+                weightedPosition += bodyPosition(body) * sortedMass[body];
+            }
+            nodes[nodeIndex].mass = totalMass;
+            nodes[nodeIndex].centerOfMass = totalMass > 0.f ? weightedPosition / totalMass : center;
+            return;
+        }
+
+        // counting sort of the slots by octant, bit 0 is x, bit 1 is y and bit 2 is z
+        uint32_t octantStart[9] = {};
+        for (uint32_t slot = begin; slot < end; slot++)
+        {
+            glm::vec3 position = bodyPosition(order[slot]);
+            uint8_t octant = static_cast<uint8_t>(
+                (position.x >= center.x ? 1 : 0) |
+                (position.y >= center.y ? 2 : 0) |
+                (position.z >= center.z ? 4 : 0));
+            octants[slot] = octant;
+            octantStart[octant + 1]++;
+        }
+        octantStart[0] = begin;
+        for (int octant = 1; octant < 9; octant++)
+        {
+            octantStart[octant] += octantStart[octant - 1];
+        }
+        uint32_t insertAt[8];
+        std::copy(octantStart, octantStart + 8, insertAt);
+        for (uint32_t slot = begin; slot < end; slot++)
+        {
+            scratch[insertAt[octants[slot]]++] = order[slot];
+        }
+        std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+        // only non-empty octants get a node, reserved up front so they stay contiguous
+        uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+        float childHalfSize = halfSize * 0.5f;
+        for (int octant = 0; octant < 8; octant++)
+        {
+            if (octantStart[octant] == octantStart[octant + 1]) continue;
+
+            Node child{};
+            child.center = center + glm::vec3
+            {
+                (octant & 1) ? childHalfSize : -childHalfSize,
+                (octant & 2) ? childHalfSize : -childHalfSize,
+                (octant & 4) ? childHalfSize : -childHalfSize,
+            };
+            child.halfSize = childHalfSize;
+            child.bodyBegin = octantStart[octant];
+            child.bodyEnd = octantStart[octant + 1];
+            nodes.push_back(child);
+        }
+        uint32_t childCount = static_cast<uint32_t>(nodes.size()) - firstChild;
+        nodes[nodeIndex].firstChild = firstChild;
+        nodes[nodeIndex].childCount = childCount;
+
+        float totalMass = 0.f;
+        glm::vec3 weightedPosition{0.f};
+        for (uint32_t child = firstChild; child < firstChild + childCount; child++)
+        {
+            buildNode(child, depth + 1);
+            totalMass += nodes[child].mass;
+            weightedPosition += nodes[child].centerOfMass * nodes[child].mass;
+        }
+        nodes[nodeIndex].mass = totalMass;
+        nodes[nodeIndex].centerOfMass = totalMass > 0.f ? weightedPosition / totalMass : center;
+    }
+
+    glm::vec3 BarnesHutTree::acceleration(glm::vec3 position, float theta, float strength, float minDistanceSquared, const ForceKernels &kernels) const
+    {
+        glm::vec3 totalAcceleration{0.f};
+        if (nodes.empty()) return totalAcceleration;
+
+        // every level pushes at most 8 children after popping its parent
+        uint32_t stack[7 * MAX_DEPTH + 8];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        float thetaSquared = theta * theta;
+
+        while (stackSize > 0)
+        {
+            const Node &node = nodes[stack[--stackSize]];
+            if (node.firstChild == 0)
+            {
+                totalAcceleration += kernels.gravityAcceleration(
+                    sortedX.data() + node.bodyBegin,
+                    sortedY.data() + node.bodyBegin,
+                    sortedZ.data() + node.bodyBegin,
+                    sortedMass.data() + node.bodyBegin,
+                    node.bodyEnd - node.bodyBegin,
+                    position,
+                    strength,
+                    minDistanceSquared);
+                continue;
+            }
+
+            glm::vec3 offset = node.centerOfMass - position;
+            float distanceSquared = glm::dot(offset, offset);
+            float size = 2.f * node.halfSize;
+            if (size * size < thetaSquared * distanceSquared)
+            {
+                if (distanceSquared >= minDistanceSquared)
+                {
+                    totalAcceleration += offset * (strength * node.mass / (distanceSquared * std::sqrt(distanceSquared)));
+                }
+                continue;
+            }
+            for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; child++)
+            {
+                stack[stackSize++] = child;
+            }
+        }
+        return totalAcceleration;
+    }
+}
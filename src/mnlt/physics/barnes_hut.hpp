@@ -0,0 +1,65 @@
+#pragma once
+
+#include "force_kernels.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace mnlt
+{
+    // Barnes-Hut octree over point masses. Nodes far enough away (their size over their distance
+    // is below the opening angle theta) act as a single mass at their centre of mass, which turns
+    // the O(n^2) direct sum into roughly O(n log n).
+    // Leaves keep their bodies in contiguous sorted arrays so they are summed with the same
+    // force kernel as the direct sum, and theta = 0 gives the direct sum back up to floating-point
+    // summation order.
+    class BarnesHutTree
+    {
+        public:
+            void build(const float *positionX, const float *positionY, const float *positionZ, const float *mass, size_t count);
+
+            // gravitational acceleration at position, see ForceKernels::GravityFn for the terms
+            glm::vec3 acceleration(glm::vec3 position, float theta, float strength, float minDistanceSquared, const ForceKernels &kernels) const;
+
+            size_t getNodeCount() const { return nodes.size(); }
+
+            // leaves are split until they hold at most this many bodies, one simd block
+            static constexpr uint32_t LEAF_SIZE = 8;
+            // stops the split when bodies sit on top of each other, that leaf just grows
+            static constexpr int MAX_DEPTH = 32;
+
+        private:
+            struct Node
+            {
+                glm::vec3 centerOfMass{0.f};
+                float mass = 0.f;
+                glm::vec3 center{0.f};
+                float halfSize = 0.f;
+                uint32_t firstChild = 0; // children are contiguous, the root is never a child so 0 means leaf
+                uint32_t childCount = 0;
+                uint32_t bodyBegin = 0;  // slots in the sorted arrays, the whole subtree for inner nodes
+                uint32_t bodyEnd = 0;
+            };
+
+            void buildNode(uint32_t nodeIndex, int depth);
+            glm::vec3 bodyPosition(uint32_t slot) const { return {sortedX[slot], sortedY[slot], sortedZ[slot]}; }
+
+            std::vector<Node> nodes;
+
+            // bodies in tree order
+            std::vector<float> sortedX;
+            std::vector<float> sortedY;
+            std::vector<float> sortedZ;
+            std::vector<float> sortedMass;
+
+            std::vector<uint8_t> octants;     // scratch, octant of each slot while splitting
+            std::vector<uint32_t> scratch;    // scratch, partition target
+            std::vector<uint32_t> order;      // original index of each slot
+    };
+}
@@ -0,0 +1,480 @@
+#include "force_kernels.hpp"
+
+// std
+#include <cmath>
+
+namespace mnlt
+{
+    namespace
+    {
+        constexpr size_t LANES = 8;
+
+        // the reduction every simd path performs, lanes 0-3 and 4-7 are added first, then the
+        // halves of that, then the last pair
+        float reduceLanes(const float *lanes)
+        {
+            return ((lanes[0] + lanes[4]) + (lanes[2] + lanes[6])) + ((lanes[1] + lanes[5]) + (lanes[3] + lanes[7]));
+        }
+
+        glm::vec3 particleForceScalar(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float radiusSquared)
+        {
+            float accX[LANES] = {}, accY[LANES] = {}, accZ[LANES] = {};
+            for (size_t j = 0; j < count; j++)
+            {
+                size_t lane = j % LANES;
+                float dx = position.x - positionX[j];
+                float dy = position.y - positionY[j];
+                float dz = position.z - positionZ[j];
+                float distanceSquared = (dx * dx + dy * dy) + dz * dz;
+                float f = distanceSquared > 0.f && distanceSquared < radiusSquared
+                    ? mass[j] / std::sqrt(distanceSquared)
+                    : 0.f;
+                accX[lane] += dx * f;
+                accY[lane] += dy * f;
+                accZ[lane] += dz * f;
+            }
+            return {reduceLanes(accX), reduceLanes(accY), reduceLanes(accZ)};
+        }
+
+        glm::vec3 gravityAccelerationScalar(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float strength, float minDistanceSquared)
+        {
+            float accX[LANES] = {}, accY[LANES] = {}, accZ[LANES] = {};
+            for (size_t j = 0; j < count; j++)
+            {
+                size_t lane = j % LANES;
+                float dx = positionX[j] - position.x;
+                float dy = positionY[j] - position.y;
+                float dz = positionZ[j] - position.z;
+                float distanceSquared = (dx * dx + dy * dy) + dz * dz;
+                float f = distanceSquared > 0.f && distanceSquared >= minDistanceSquared
+                    ? strength * mass[j] / (distanceSquared * std::sqrt(distanceSquared))
+                    : 0.f;
+                accX[lane] += dx * f;
+                accY[lane] += dy * f;
+                accZ[lane] += dz * f;
+            }
+            return {reduceLanes(accX), reduceLanes(accY), reduceLanes(accZ)};
+        }
+
+        glm::vec3 gravityPairsScalar(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float bodyMass, float strength, float minDistanceSquared,
+            float *accelerationX, float *accelerationY, float *accelerationZ)
+        {
+            float accX[LANES] = {}, accY[LANES] = {}, accZ[LANES] = {};
+            for (size_t j = 0; j < count; j++)
+            {
+                size_t lane = j % LANES;
+                float dx = positionX[j] - position.x;
+                float dy = positionY[j] - position.y;
+                float dz = positionZ[j] - position.z;
+                float distanceSquared = (dx * dx + dy * dy) + dz * dz;
+                float f = distanceSquared > 0.f && distanceSquared >= minDistanceSquared
+                    ? strength / (distanceSquared * std::sqrt(distanceSquared))
+                    : 0.f;
+                float pull = f * mass[j];
+                float reaction = f * bodyMass;
+                accX[lane] += dx * pull;
+                accY[lane] += dy * pull;
+                accZ[lane] += dz * pull;
+                accelerationX[j] -= dx * reaction;
+                accelerationY[j] -= dy * reaction;
+                accelerationZ[j] -= dz * reaction;
+            }
+            return {reduceLanes(accX), reduceLanes(accY), reduceLanes(accZ)};
+        }
+
+#ifdef MNLT_X86
+        // Copies the last count % 8 elements into full blocks, padding positions with the query
+        // point and mass with zero so the padded lanes always fail the distance mask.
+        struct TailBlock
+        {
+            alignas(32) float positionX[LANES];
+            alignas(32) float positionY[LANES];
+            alignas(32) float positionZ[LANES];
+            alignas(32) float mass[LANES];
+
+            TailBlock(const float *x, const float *y, const float *z, const float *m, size_t first, size_t count, glm::vec3 position)
+            {
+                for (size_t k = 0; k < LANES; k++)
+                {
+                    bool inside = first + k < count;
+                    positionX[k] = inside ? x[first + k] : position.x;
+                    positionY[k] = inside ? y[first + k] : position.y;
+                    positionZ[k] = inside ? z[first + k] : position.z;
+                    mass[k] = inside ? m[first + k] : 0.f;
+                }
+            }
+        };
+
+        // the accelerations a pair kernel writes for the last count % 8 slots, padding lanes are
+        // written too but never stored back
+        struct TailAccelerations
+        {
+            alignas(32) float x[LANES] = {};
+            alignas(32) float y[LANES] = {};
+            alignas(32) float z[LANES] = {};
+
+            TailAccelerations(const float *ax, const float *ay, const float *az, size_t first, size_t count)
+            {
+                for (size_t k = 0; first + k < count; k++)
+                {
+                    x[k] = ax[first + k];
+                    y[k] = ay[first + k];
+                    z[k] = az[first + k];
+                }
+            }
+
+            void store(float *ax, float *ay, float *az, size_t first, size_t count) const
+            {
+                for (size_t k = 0; first + k < count; k++)
+                {
+                    ax[first + k] = x[k];
+                    ay[first + k] = y[k];
+                    az[first + k] = z[k];
+                }
+            }
+        };
+
+        MNLT_TARGET_SSE2
+        float reduceSse(__m128 lo, __m128 hi)
+        {
+            __m128 sum = _mm_add_ps(lo, hi);
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(sum);
+        }
+
+        // one 4 lane half of a particle block, acc += d * (m / |d|) over the masked lanes
+        MNLT_TARGET_SSE2
+        void particleHalfSse(
+            const float *x, const float *y, const float *z, const float *m,
+            __m128 px, __m128 py, __m128 pz, __m128 radiusSquared,
+            __m128 &accX, __m128 &accY, __m128 &accZ)
+        {
+            __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(x));
+            __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(y));
+            __m128 dz = _mm_sub_ps(pz, _mm_loadu_ps(z));
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 mask = _mm_and_ps(
+                _mm_cmpgt_ps(distanceSquared, _mm_setzero_ps()),
+                _mm_cmplt_ps(distanceSquared, radiusSquared));
+            __m128 f = _mm_and_ps(mask, _mm_div_ps(_mm_loadu_ps(m), _mm_sqrt_ps(distanceSquared)));
+            accX = _mm_add_ps(accX, _mm_mul_ps(dx, f));
+            accY = _mm_add_ps(accY, _mm_mul_ps(dy, f));
+            accZ = _mm_add_ps(accZ, _mm_mul_ps(dz, f));
+        }
+
+        MNLT_TARGET_SSE2
+        glm::vec3 particleForceSse(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float radiusSquared)
+        {
+            __m128 px = _mm_set1_ps(position.x);
+            __m128 py = _mm_set1_ps(position.y);
+            __m128 pz = _mm_set1_ps(position.z);
+            __m128 r2 = _mm_set1_ps(radiusSquared);
+            __m128 loX = _mm_setzero_ps(), loY = _mm_setzero_ps(), loZ = _mm_setzero_ps();
+            __m128 hiX = _mm_setzero_ps(), hiY = _mm_setzero_ps(), hiZ = _mm_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                particleHalfSse(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, r2, loX, loY, loZ);
+                particleHalfSse(positionX + j + 4, positionY + j + 4, positionZ + j + 4, mass + j + 4, px, py, pz, r2, hiX, hiY, hiZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                particleHalfSse(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, r2, loX, loY, loZ);
+                particleHalfSse(tail.positionX + 4, tail.positionY + 4, tail.positionZ + 4, tail.mass + 4, px, py, pz, r2, hiX, hiY, hiZ);
+            }
+            return {reduceSse(loX, hiX), reduceSse(loY, hiY), reduceSse(loZ, hiZ)};
+        }
+
+        // one 4 lane half of a gravity block, acc += d * (strength * m / |d|^3) over the masked lanes
+        MNLT_TARGET_SSE2
+        void gravityHalfSse(
+            const float *x, const float *y, const float *z, const float *m,
+            __m128 px, __m128 py, __m128 pz, __m128 strength, __m128 minDistanceSquared,
+            __m128 &accX, __m128 &accY, __m128 &accZ)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(x), px);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(y), py);
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(z), pz);
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 mask = _mm_and_ps(
+                _mm_cmpgt_ps(distanceSquared, _mm_setzero_ps()),
+                _mm_cmpge_ps(distanceSquared, minDistanceSquared));
+            __m128 denominator = _mm_mul_ps(distanceSquared, _mm_sqrt_ps(distanceSquared));
+            __m128 f = _mm_and_ps(mask, _mm_div_ps(_mm_mul_ps(strength, _mm_loadu_ps(m)), denominator));
+            accX = _mm_add_ps(accX, _mm_mul_ps(dx, f));
+            accY = _mm_add_ps(accY, _mm_mul_ps(dy, f));
+            accZ = _mm_add_ps(accZ, _mm_mul_ps(dz, f));
+        }
+
+        MNLT_TARGET_SSE2
+        glm::vec3 gravityAccelerationSse(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float strength, float minDistanceSquared)
+        {
+            __m128 px = _mm_set1_ps(position.x);
+            __m128 py = _mm_set1_ps(position.y);
+            __m128 pz = _mm_set1_ps(position.z);
+            __m128 g = _mm_set1_ps(strength);
+            __m128 minD2 = _mm_set1_ps(minDistanceSquared);
+            __m128 loX = _mm_setzero_ps(), loY = _mm_setzero_ps(), loZ = _mm_setzero_ps();
+            __m128 hiX = _mm_setzero_ps(), hiY = _mm_setzero_ps(), hiZ = _mm_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                gravityHalfSse(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, g, minD2, loX, loY, loZ);
+                gravityHalfSse(positionX + j + 4, positionY + j + 4, positionZ + j + 4, mass + j + 4, px, py, pz, g, minD2, hiX, hiY, hiZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                gravityHalfSse(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, g, minD2, loX, loY, loZ);
+                gravityHalfSse(tail.positionX + 4, tail.positionY + 4, tail.positionZ + 4, tail.mass + 4, px, py, pz, g, minD2, hiX, hiY, hiZ);
+            }
+            return {reduceSse(loX, hiX), reduceSse(loY, hiY), reduceSse(loZ, hiZ)};
+        }
+
+        // one 4 lane half of a pair block, also writes the reaction back to the j accelerations
+        MNLT_TARGET_SSE2
+        void gravityPairsHalfSse(
+            const float *x, const float *y, const float *z, const float *m,
+            __m128 px, __m128 py, __m128 pz, __m128 bodyMass, __m128 strength, __m128 minDistanceSquared,
+            float *ax, float *ay, float *az,
+            __m128 &accX, __m128 &accY, __m128 &accZ)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(x), px);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(y), py);
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(z), pz);
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 mask = _mm_and_ps(
+                _mm_cmpgt_ps(distanceSquared, _mm_setzero_ps()),
+                _mm_cmpge_ps(distanceSquared, minDistanceSquared));
+            __m128 f = _mm_and_ps(mask, _mm_div_ps(strength, _mm_mul_ps(distanceSquared, _mm_sqrt_ps(distanceSquared))));
+            __m128 pull = _mm_mul_ps(f, _mm_loadu_ps(m));
+            __m128 reaction = _mm_mul_ps(f, bodyMass);
+            accX = _mm_add_ps(accX, _mm_mul_ps(dx, pull));
+            accY = _mm_add_ps(accY, _mm_mul_ps(dy, pull));
+            accZ = _mm_add_ps(accZ, _mm_mul_ps(dz, pull));
+            _mm_storeu_ps(ax, _mm_sub_ps(_mm_loadu_ps(ax), _mm_mul_ps(dx, reaction)));
+            _mm_storeu_ps(ay, _mm_sub_ps(_mm_loadu_ps(ay), _mm_mul_ps(dy, reaction)));
+            _mm_storeu_ps(az, _mm_sub_ps(_mm_loadu_ps(az), _mm_mul_ps(dz, reaction)));
+        }
+
+        MNLT_TARGET_SSE2
+        glm::vec3 gravityPairsSse(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float bodyMass, float strength, float minDistanceSquared,
+            float *accelerationX, float *accelerationY, float *accelerationZ)
+        {
+            __m128 px = _mm_set1_ps(position.x);
+            __m128 py = _mm_set1_ps(position.y);
+            __m128 pz = _mm_set1_ps(position.z);
+            __m128 mi = _mm_set1_ps(bodyMass);
+            __m128 g = _mm_set1_ps(strength);
+            __m128 minD2 = _mm_set1_ps(minDistanceSquared);
+            __m128 loX = _mm_setzero_ps(), loY = _mm_setzero_ps(), loZ = _mm_setzero_ps();
+            __m128 hiX = _mm_setzero_ps(), hiY = _mm_setzero_ps(), hiZ = _mm_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                gravityPairsHalfSse(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, mi, g, minD2,
+                    accelerationX + j, accelerationY + j, accelerationZ + j, loX, loY, loZ);
+                gravityPairsHalfSse(positionX + j + 4, positionY + j + 4, positionZ + j + 4, mass + j + 4, px, py, pz, mi, g, minD2,
+                    accelerationX + j + 4, accelerationY + j + 4, accelerationZ + j + 4, hiX, hiY, hiZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                TailAccelerations tailAccelerations{accelerationX, accelerationY, accelerationZ, blockEnd, count};
+                gravityPairsHalfSse(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, mi, g, minD2,
+                    tailAccelerations.x, tailAccelerations.y, tailAccelerations.z, loX, loY, loZ);
+                gravityPairsHalfSse(tail.positionX + 4, tail.positionY + 4, tail.positionZ + 4, tail.mass + 4, px, py, pz, mi, g, minD2,
+                    tailAccelerations.x + 4, tailAccelerations.y + 4, tailAccelerations.z + 4, hiX, hiY, hiZ);
+                tailAccelerations.store(accelerationX, accelerationY, accelerationZ, blockEnd, count);
+            }
+            return {reduceSse(loX, hiX), reduceSse(loY, hiY), reduceSse(loZ, hiZ)};
+        }
+
+        MNLT_TARGET_AVX2
+        float reduceAvx(__m256 acc)
+        {
+            __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(sum);
+        }
+
+        MNLT_TARGET_AVX2
+        void particleBlockAvx(
+            const float *x, const float *y, const float *z, const float *m,
+            __m256 px, __m256 py, __m256 pz, __m256 radiusSquared,
+            __m256 &accX, __m256 &accY, __m256 &accZ)
+        {
+            __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(x));
+            __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(y));
+            __m256 dz = _mm256_sub_ps(pz, _mm256_loadu_ps(z));
+            __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 mask = _mm256_and_ps(
+                _mm256_cmp_ps(distanceSquared, _mm256_setzero_ps(), _CMP_GT_OQ),
+                _mm256_cmp_ps(distanceSquared, radiusSquared, _CMP_LT_OQ));
+            __m256 f = _mm256_and_ps(mask, _mm256_div_ps(_mm256_loadu_ps(m), _mm256_sqrt_ps(distanceSquared)));
+            accX = _mm256_add_ps(accX, _mm256_mul_ps(dx, f));
+            accY = _mm256_add_ps(accY, _mm256_mul_ps(dy, f));
+            accZ = _mm256_add_ps(accZ, _mm256_mul_ps(dz, f));
+        }
+
+        MNLT_TARGET_AVX2
+        glm::vec3 particleForceAvx(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float radiusSquared)
+        {
+            __m256 px = _mm256_set1_ps(position.x);
+            __m256 py = _mm256_set1_ps(position.y);
+            __m256 pz = _mm256_set1_ps(position.z);
+            __m256 r2 = _mm256_set1_ps(radiusSquared);
+            __m256 accX = _mm256_setzero_ps(), accY = _mm256_setzero_ps(), accZ = _mm256_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                particleBlockAvx(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, r2, accX, accY, accZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                particleBlockAvx(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, r2, accX, accY, accZ);
+            }
+            return {reduceAvx(accX), reduceAvx(accY), reduceAvx(accZ)};
+        }
+
+        MNLT_TARGET_AVX2
+        void gravityBlockAvx(
+            const float *x, const float *y, const float *z, const float *m,
+            __m256 px, __m256 py, __m256 pz, __m256 strength, __m256 minDistanceSquared,
+            __m256 &accX, __m256 &accY, __m256 &accZ)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x), px);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y), py);
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z), pz);
+            __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 mask = _mm256_and_ps(
+                _mm256_cmp_ps(distanceSquared, _mm256_setzero_ps(), _CMP_GT_OQ),
+                _mm256_cmp_ps(distanceSquared, minDistanceSquared, _CMP_GE_OQ));
+            __m256 denominator = _mm256_mul_ps(distanceSquared, _mm256_sqrt_ps(distanceSquared));
+            __m256 f = _mm256_and_ps(mask, _mm256_div_ps(_mm256_mul_ps(strength, _mm256_loadu_ps(m)), denominator));
+            accX = _mm256_add_ps(accX, _mm256_mul_ps(dx, f));
+            accY = _mm256_add_ps(accY, _mm256_mul_ps(dy, f));
+            accZ = _mm256_add_ps(accZ, _mm256_mul_ps(dz, f));
+        }
+
+        MNLT_TARGET_AVX2
+        glm::vec3 gravityAccelerationAvx(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float strength, float minDistanceSquared)
+        {
+            __m256 px = _mm256_set1_ps(position.x);
+            __m256 py = _mm256_set1_ps(position.y);
+            __m256 pz = _mm256_set1_ps(position.z);
+            __m256 g = _mm256_set1_ps(strength);
+            __m256 minD2 = _mm256_set1_ps(minDistanceSquared);
+            __m256 accX = _mm256_setzero_ps(), accY = _mm256_setzero_ps(), accZ = _mm256_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                gravityBlockAvx(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, g, minD2, accX, accY, accZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                gravityBlockAvx(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, g, minD2, accX, accY, accZ);
+            }
+            return {reduceAvx(accX), reduceAvx(accY), reduceAvx(accZ)};
+        }
+
+        MNLT_TARGET_AVX2
+        void gravityPairsBlockAvx(
+            const float *x, const float *y, const float *z, const float *m,
+            __m256 px, __m256 py, __m256 pz, __m256 bodyMass, __m256 strength, __m256 minDistanceSquared,
+            float *ax, float *ay, float *az,
+            __m256 &accX, __m256 &accY, __m256 &accZ)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x), px);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y), py);
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z), pz);
+            __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 mask = _mm256_and_ps(
+                _mm256_cmp_ps(distanceSquared, _mm256_setzero_ps(), _CMP_GT_OQ),
+                _mm256_cmp_ps(distanceSquared, minDistanceSquared, _CMP_GE_OQ));
+            __m256 f = _mm256_and_ps(mask, _mm256_div_ps(strength, _mm256_mul_ps(distanceSquared, _mm256_sqrt_ps(distanceSquared))));
+            __m256 pull = _mm256_mul_ps(f, _mm256_loadu_ps(m));
+            __m256 reaction = _mm256_mul_ps(f, bodyMass);
+            accX = _mm256_add_ps(accX, _mm256_mul_ps(dx, pull));
+            accY = _mm256_add_ps(accY, _mm256_mul_ps(dy, pull));
+            accZ = _mm256_add_ps(accZ, _mm256_mul_ps(dz, pull));
+            _mm256_storeu_ps(ax, _mm256_sub_ps(_mm256_loadu_ps(ax), _mm256_mul_ps(dx, reaction)));
+            _mm256_storeu_ps(ay, _mm256_sub_ps(_mm256_loadu_ps(ay), _mm256_mul_ps(dy, reaction)));
+            _mm256_storeu_ps(az, _mm256_sub_ps(_mm256_loadu_ps(az), _mm256_mul_ps(dz, reaction)));
+        }
+
+        MNLT_TARGET_AVX2
+        glm::vec3 gravityPairsAvx(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float bodyMass, float strength, float minDistanceSquared,
+            float *accelerationX, float *accelerationY, float *accelerationZ)
+        {
+            __m256 px = _mm256_set1_ps(position.x);
+            __m256 py = _mm256_set1_ps(position.y);
+            __m256 pz = _mm256_set1_ps(position.z);
+            __m256 mi = _mm256_set1_ps(bodyMass);
+            __m256 g = _mm256_set1_ps(strength);
+            __m256 minD2 = _mm256_set1_ps(minDistanceSquared);
+            __m256 accX = _mm256_setzero_ps(), accY = _mm256_setzero_ps(), accZ = _mm256_setzero_ps();
+
+            size_t blockEnd = count - count % LANES;
+            for (size_t j = 0; j < blockEnd; j += LANES)
+            {
+                gravityPairsBlockAvx(positionX + j, positionY + j, positionZ + j, mass + j, px, py, pz, mi, g, minD2,
+                    accelerationX + j, accelerationY + j, accelerationZ + j, accX, accY, accZ);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{positionX, positionY, positionZ, mass, blockEnd, count, position};
+                TailAccelerations tailAccelerations{accelerationX, accelerationY, accelerationZ, blockEnd, count};
+                gravityPairsBlockAvx(tail.positionX, tail.positionY, tail.positionZ, tail.mass, px, py, pz, mi, g, minD2,
+                    tailAccelerations.x, tailAccelerations.y, tailAccelerations.z, accX, accY, accZ);
+                tailAccelerations.store(accelerationX, accelerationY, accelerationZ, blockEnd, count);
+            }
+            return {reduceAvx(accX), reduceAvx(accY), reduceAvx(accZ)};
+        }
+#endif
+
+        const ForceKernels scalarKernels{SimdLevel::Scalar, particleForceScalar, gravityAccelerationScalar, gravityPairsScalar};
+#ifdef MNLT_X86
+        const ForceKernels sseKernels{SimdLevel::SSE2, particleForceSse, gravityAccelerationSse, gravityPairsSse};
+        const ForceKernels avxKernels{SimdLevel::AVX2, particleForceAvx, gravityAccelerationAvx, gravityPairsAvx};
+#endif
+    }
+
+    const ForceKernels &getForceKernels(SimdLevel level)
+    {
+        if (level > bestSimdLevel()) level = bestSimdLevel();
+#ifdef MNLT_X86
+        if (level == SimdLevel::AVX2) return avxKernels;
+        if (level == SimdLevel::SSE2) return sseKernels;
+#endif
+        return scalarKernels;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../simd.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <vector>
+
+namespace mnlt
+{
+    // Pairwise force kernels over structure-of-arrays particle data.
+    // Every level processes pairs in 8 lanes and reduces them in the same order, and the scalar
+    // path emulates those lanes, so all levels return bit-identical results for the same input.
+    struct ForceKernels
+    {
+        // sum over j of (position - p[j]) * (mass[j] / |position - p[j]|)
+        // for every j with 0 < |position - p[j]|^2 < radiusSquared
+        using ParticleForceFn = glm::vec3 (*)(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float radiusSquared);
+
+        // sum over j of (p[j] - position) * (strength * mass[j] / |p[j] - position|^3)
+        // for every j with |p[j] - position|^2 >= minDistanceSquared, i.e. the gravitational
+        // acceleration at position
+        using GravityFn = glm::vec3 (*)(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float strength, float minDistanceSquared);
+
+        // newton's third law form of GravityFn for pair loops that visit every pair once. returns
+        // the pull of every j on position like GravityFn, and subtracts the opposite pull of a body
+        // of bodyMass at position from acceleration[j]
+        using GravityPairsFn = glm::vec3 (*)(
+            const float *positionX, const float *positionY, const float *positionZ, const float *mass,
+            size_t count, glm::vec3 position, float bodyMass, float strength, float minDistanceSquared,
+            float *accelerationX, float *accelerationY, float *accelerationZ);
+
+        SimdLevel level;
+        ParticleForceFn particleForce;
+        GravityFn gravityAcceleration;
+        GravityPairsFn gravityPairs;
+    };
+
+    // levels above bestSimdLevel() fall back to the best supported one
+    const ForceKernels &getForceKernels(SimdLevel level = bestSimdLevel());
+}
@@ -0,0 +1,100 @@
+#include "integrator.hpp"
+
+// std
+#include <stdexcept>
+
+namespace mnlt
+{
+    std::unique_ptr<Integrator> Integrator::create(IntegratorType type)
+    {
+        switch (type)
+        {
+            case IntegratorType::SemiImplicitEuler: return std::make_unique<SemiImplicitEulerIntegrator>();
+            case IntegratorType::VelocityVerlet: return std::make_unique<VelocityVerletIntegrator>();
+            case IntegratorType::RungeKutta4: return std::make_unique<RungeKutta4Integrator>();
+        }
+        throw std::runtime_error("unknown integrator type");
+    }
+
+    const char *Integrator::getName(IntegratorType type)
+    {
+        switch (type)
+        {
+            case IntegratorType::SemiImplicitEuler: return "Semi-Implicit Euler";
+            case IntegratorType::VelocityVerlet: return "Velocity Verlet";
+            case IntegratorType::RungeKutta4: return "Runge-Kutta 4";
+        }
+        return "Unknown";
+    }
+
+    void SemiImplicitEulerIntegrator::step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations)
+    {
+        computeAccelerations(particles, accelerations);
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            glm::vec3 velocity = particles.getVelocity(i) + deltaTime * accelerations[i];
+            particles.setVelocity(i, velocity);
+            particles.setPosition(i, particles.getPosition(i) + deltaTime * velocity);
+        }
+    }
+
+    void VelocityVerletIntegrator::step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations)
+    {
+        if (!hasAccelerations || accelerations.size() != particles.size())
+        {
+            computeAccelerations(particles, accelerations);
+            hasAccelerations = true;
+        }
+
+        float halfDeltaTime = 0.5f * deltaTime;
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            glm::vec3 velocity = particles.getVelocity(i) + halfDeltaTime * accelerations[i];
+            particles.setVelocity(i, velocity);
+            particles.setPosition(i, particles.getPosition(i) + deltaTime * velocity);
+        }
+        computeAccelerations(particles, accelerations);
+        for (size_t i = 0; i < particles.size(); i++)
+        {
+            particles.setVelocity(i, particles.getVelocity(i) + halfDeltaTime * accelerations[i]);
+        }
+    }
+
+    void RungeKutta4Integrator::step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations)
+    {
+        // the velocity of stage k is v_k = v + c[k] dt a_(k-1) and stage k + 1 is evaluated at
+        // x + c[k + 1] dt v_k, the stage velocities are cheap to rebuild so only accelerations are kept
+        const float c[4] = {0.f, 0.5f, 0.5f, 1.f};
+        const float weight[4] = {1.f, 2.f, 2.f, 1.f};
+        size_t count = particles.size();
+
+        stage = particles;
+        computeAccelerations(stage, stageAccelerations[0]);
+        for (int k = 1; k < 4; k++)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                glm::vec3 previousVelocity = particles.getVelocity(i);
+                if (k > 1)
+                    previousVelocity += c[k - 1] * deltaTime * stageAccelerations[k - 2][i];
+                stage.setPosition(i, particles.getPosition(i) + c[k] * deltaTime * previousVelocity);
+            }
+            computeAccelerations(stage, stageAccelerations[k]);
+        }
+
+        float sixthDeltaTime = deltaTime / 6.f;
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec3 velocity = particles.getVelocity(i);
+            glm::vec3 velocitySum = velocity;
+            glm::vec3 accelerationSum = stageAccelerations[0][i];
+            for (int k = 1; k < 4; k++)
+            {
+                velocitySum += weight[k] * (velocity + c[k] * deltaTime * stageAccelerations[k - 1][i]);
+                accelerationSum += weight[k] * stageAccelerations[k][i];
+            }
+            particles.setPosition(i, particles.getPosition(i) + sixthDeltaTime * velocitySum);
+            particles.setVelocity(i, velocity + sixthDeltaTime * accelerationSum);
+        }
+    }
+}
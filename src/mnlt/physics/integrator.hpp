@@ -0,0 +1,80 @@
+#pragma once
+
+#include "particle_store.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mnlt
+{
+    enum class IntegratorType
+    {
+        SemiImplicitEuler,
+        VelocityVerlet,
+        RungeKutta4,
+    };
+
+    // Advances the positions and velocities of a particle store by one step. Forces come from a
+    // callback that fills in the acceleration of every particle for the positions in the store
+    // it is given, so the same integrators work for any solver.
+    class Integrator
+    {
+        public:
+            using AccelerationFn = std::function<void(const ParticleStore &state, std::vector<glm::vec3> &accelerations)>;
+
+            static std::unique_ptr<Integrator> create(IntegratorType type);
+            static const char *getName(IntegratorType type);
+
+            virtual ~Integrator() = default;
+
+            virtual void step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations) = 0;
+            // call when positions or masses were changed outside of step(), drops anything cached from the last step
+            virtual void reset() {}
+            // acceleration evaluations per step, the main cost for n-body forces
+            virtual int getEvaluationsPerStep() const = 0;
+    };
+
+    // first order, v += a dt then x += v dt. symplectic, but its energy error only shrinks linearly with dt
+    class SemiImplicitEulerIntegrator : public Integrator
+    {
+        public:
+            void step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations) override;
+            int getEvaluationsPerStep() const override { return 1; }
+
+        private:
+            std::vector<glm::vec3> accelerations;
+    };
+
+    // second order kick-drift-kick leapfrog. time reversible and symplectic, so orbits keep their
+    // energy over long runs, and the end-of-step accelerations are reused as the next step's start
+    class VelocityVerletIntegrator : public Integrator
+    {
+        public:
+            void step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations) override;
+            void reset() override { hasAccelerations = false; }
+            int getEvaluationsPerStep() const override { return 1; }
+
+        private:
+            std::vector<glm::vec3> accelerations;
+            bool hasAccelerations = false;
+    };
+
+    // classic fourth order runge kutta. very accurate per step but not symplectic, energy slowly drifts
+    class RungeKutta4Integrator : public Integrator
+    {
+        public:
+            void step(ParticleStore &particles, float deltaTime, const AccelerationFn &computeAccelerations) override;
+            int getEvaluationsPerStep() const override { return 4; }
+
+        private:
+            ParticleStore stage;
+            std::vector<glm::vec3> stageAccelerations[4];
+    };
+}
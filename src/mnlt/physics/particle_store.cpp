@@ -0,0 +1,84 @@
+#include "particle_store.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace mnlt
+{
+    uint32_t ParticleStore::addParticle(glm::vec3 position, float particleMass, uint32_t particleTypeId)
+    {
+        uint32_t index = static_cast<uint32_t>(size());
+        positionX.push_back(position.x);
+        positionY.push_back(position.y);
+        positionZ.push_back(position.z);
+        velocityX.push_back(0.f);
+        velocityY.push_back(0.f);
+        velocityZ.push_back(0.f);
+        mass.push_back(particleMass);
+        typeId.push_back(particleTypeId);
+        return index;
+    }
+
+    void ParticleStore::clear()
+    {
+        positionX.clear();
+        positionY.clear();
+        positionZ.clear();
+        velocityX.clear();
+        velocityY.clear();
+        velocityZ.clear();
+        mass.clear();
+        typeId.clear();
+    }
+
+    void ParticleStore::reserve(size_t count)
+    {
+        positionX.reserve(count);
+        positionY.reserve(count);
+        positionZ.reserve(count);
+        velocityX.reserve(count);
+        velocityY.reserve(count);
+        velocityZ.reserve(count);
+        mass.reserve(count);
+        typeId.reserve(count);
+    }
+
+    void ParticleStore::setPosition(size_t i, glm::vec3 position)
+    {
+        positionX[i] = position.x;
+        positionY[i] = position.y;
+        positionZ[i] = position.z;
+    }
+
+    void ParticleStore::setVelocity(size_t i, glm::vec3 velocity)
+    {
+        velocityX[i] = velocity.x;
+        velocityY[i] = velocity.y;
+        velocityZ[i] = velocity.z;
+    }
+
+    void ParticleStore::reorder(size_t first, const std::vector<uint32_t> &order)
+    {
+        assert(first + order.size() <= size() && "Reorder range exceeds particle count");
+        reorderArray(positionX, first, order, floatScratch);
+        reorderArray(positionY, first, order, floatScratch);
+        reorderArray(positionZ, first, order, floatScratch);
+        reorderArray(velocityX, first, order, floatScratch);
+        reorderArray(velocityY, first, order, floatScratch);
+        reorderArray(velocityZ, first, order, floatScratch);
+        reorderArray(mass, first, order, floatScratch);
+        reorderArray(typeId, first, order, uintScratch);
+    }
+
+    template <typename T>
+    void ParticleStore::reorderArray(std::vector<T> &values, size_t first, const std::vector<uint32_t> &order, std::vector<T> &scratch)
+    {
+        scratch.resize(order.size());
+        for (size_t k = 0; k < order.size(); k++)
+        {
+            scratch[k] = values[first + order[k]];
+        }
+        std::copy(scratch.begin(), scratch.end(), values.begin() + first);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace mnlt
+{
+    // Structure-of-arrays particle storage. Every attribute lives in its own contiguous array so
+    // physics loops only stream the data they touch, and render systems read it directly instead
+    // of going through a GameObject per particle.
+    class ParticleStore
+    {
+        public:
+            uint32_t addParticle(glm::vec3 position, float particleMass, uint32_t particleTypeId);
+            void clear();
+            void reserve(size_t count);
+            size_t size() const { return mass.size(); }
+
+            glm::vec3 getPosition(size_t i) const { return {positionX[i], positionY[i], positionZ[i]}; }
+            glm::vec3 getVelocity(size_t i) const { return {velocityX[i], velocityY[i], velocityZ[i]}; }
+            void setPosition(size_t i, glm::vec3 position);
+            void setVelocity(size_t i, glm::vec3 velocity);
+
+            // reorders the slots [first, first + order.size()) so that slot first + k holds the
+            // particle that was at first + order[k]
+            void reorder(size_t first, const std::vector<uint32_t> &order);
+
+            std::vector<float> positionX;
+            std::vector<float> positionY;
+            std::vector<float> positionZ;
+            std::vector<float> velocityX;
+            std::vector<float> velocityY;
+            std::vector<float> velocityZ;
+            std::vector<float> mass;
+            std::vector<uint32_t> typeId;
+
+        private:
+            template <typename T>
+            void reorderArray(std::vector<T> &values, size_t first, const std::vector<uint32_t> &order, std::vector<T> &scratch);
+
+            std::vector<float> floatScratch;
+            std::vector<uint32_t> uintScratch;
+    };
+}
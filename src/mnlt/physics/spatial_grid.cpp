@@ -0,0 +1,60 @@
+#include "spatial_grid.hpp"
+
+// std
+#include <algorithm>
+
+namespace mnlt
+{
+    void SpatialGrid::build(const float *positionX, const float *positionY, const float *positionZ, size_t count, glm::vec3 lowerBound, glm::vec3 upperBound, float cellSize)
+    {
+        glm::vec3 extent = glm::max(upperBound - lowerBound, glm::vec3{cellSize});
+        // a zero radius has no neighbours anyway, a single cell keeps it from allocating the max grid
+        glm::vec3 size = cellSize > 0.f
+            ? glm::max(glm::vec3{cellSize}, extent / static_cast<float>(MAX_CELLS_PER_AXIS))
+            : extent;
+
+        origin = lowerBound;
+        inverseCellSize = 1.0f / size;
+        dimensions = glm::ivec3
+        {
+            glm::clamp(static_cast<int>(extent.x * inverseCellSize.x), 1, MAX_CELLS_PER_AXIS),
+            glm::clamp(static_cast<int>(extent.y * inverseCellSize.y), 1, MAX_CELLS_PER_AXIS),
+            glm::clamp(static_cast<int>(extent.z * inverseCellSize.z), 1, MAX_CELLS_PER_AXIS),
+        };
+
+        // counting sort, cellStart first holds the counts and is then turned into offsets
+        cellStart.assign(static_cast<size_t>(dimensions.x) * dimensions.y * dimensions.z + 1, 0);
+        pointCells.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::ivec3 cell = cellCoord({positionX[i], positionY[i], positionZ[i]});
+            pointCells[i] = static_cast<uint32_t>(cellIndex(cell.x, cell.y, cell.z));
+            cellStart[pointCells[i] + 1]++;
+        }
+        for (size_t i = 1; i < cellStart.size(); i++)
+        {
+            cellStart[i] += cellStart[i - 1];
+        }
+
+        // scatter using a copy of the offsets so cellStart stays intact
+        std::vector<uint32_t> insertAt(cellStart.begin(), cellStart.end() - 1);
+        sortedIndices.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            sortedIndices[insertAt[pointCells[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    glm::ivec3 SpatialGrid::cellCoord(glm::vec3 position) const
+    {
+        glm::vec3 local = (position - origin) * inverseCellSize;
+        // clamp in float space first so points far outside the box can't overflow the int cast
+        local = glm::clamp(local, glm::vec3{0.f}, glm::vec3{dimensions} - glm::vec3{1.f});
+        return glm::ivec3
+        {
+            static_cast<int>(local.x),
+            static_cast<int>(local.y),
+            static_cast<int>(local.z),
+        };
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace mnlt
+{
+    // Uniform grid broadphase over a bounded box. Points are bucketed with a counting sort so
+    // every cell is a contiguous run of indices, and cells are laid out x-fastest so the three
+    // cells along x in any neighbour row are contiguous as well.
+    // Points outside the box are clamped into the border cells, which keeps queries correct
+    // for unbounded simulations (they just get slower as the border cells fill up).
+    class SpatialGrid
+    {
+        public:
+            // cells are never smaller than cellSize, so a query only has to visit the 27 cells
+            // around a point to find everything within cellSize of it
+            void build(const float *positionX, const float *positionY, const float *positionZ, size_t count, glm::vec3 lowerBound, glm::vec3 upperBound, float cellSize);
+
+            // calls func(begin, end) for each contiguous run of sorted slots that may hold a
+            // neighbour of position, use getIndex() to map a slot back to the original point
+            template <typename Func>
+            void forEachNeighbourRange(glm::vec3 position, Func &&func) const
+            {
+                if (cellStart.empty()) return;
+
+                glm::ivec3 cell = cellCoord(position);
+                int minX = glm::max(cell.x - 1, 0);
+                int maxX = glm::min(cell.x + 1, dimensions.x - 1);
+                for (int z = glm::max(cell.z - 1, 0); z <= glm::min(cell.z + 1, dimensions.z - 1); z++)
+                {
+                    for (int y = glm::max(cell.y - 1, 0); y <= glm::min(cell.y + 1, dimensions.y - 1); y++)
+                    {
+                        uint32_t begin = cellStart[cellIndex(minX, y, z)];
+                        uint32_t end = cellStart[cellIndex(maxX, y, z) + 1];
+                        if (begin != end) func(begin, end);
+                    }
+                }
+            }
+
+            // calls func(index) for every point that may be within cellSize of position
+            template <typename Func>
+            void forEachNeighbour(glm::vec3 position, Func &&func) const
+            {
+                forEachNeighbourRange(position, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t slot = begin; slot < end; slot++)
+                        func(sortedIndices[slot]);
+                });
+            }
+
+            uint32_t getIndex(uint32_t slot) const { return sortedIndices[slot]; }
+            // point indices in cell order, usable to physically sort the source arrays so that
+            // slots and indices coincide
+            const std::vector<uint32_t> &getSortedIndices() const { return sortedIndices; }
+            size_t getCellCount() const { return cellStart.empty() ? 0 : cellStart.size() - 1; }
+
+            // caps the cell count per axis so a tiny radius can't blow up memory, cells just grow
+            static constexpr int MAX_CELLS_PER_AXIS = 128;
+
+        private:
+            glm::ivec3 cellCoord(glm::vec3 position) const;
+            int cellIndex(int x, int y, int z) const { return x + dimensions.x * (y + dimensions.y * z); }
+
+            glm::vec3 origin{0.f};
+            glm::vec3 inverseCellSize{1.f};
+            glm::ivec3 dimensions{0};
+
+            std::vector<uint32_t> cellStart;      // cell i owns slots [cellStart[i], cellStart[i + 1])
+            std::vector<uint32_t> sortedIndices;  // point indices ordered by cell
+            std::vector<uint32_t> pointCells;     // scratch, cell of each point
+    };
+}
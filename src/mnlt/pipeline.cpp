@@ -53,8 +53,8 @@ namespace mnlt
         auto vertCode = readFile(vertFilePath);
         auto fragCode = readFile(fragFilePath);
 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        createShaderModule(device, vertCode, &vertShaderModule);
+        createShaderModule(device, fragCode, &fragShaderModule);
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -107,7 +107,7 @@ namespace mnlt
         }
     }
 
-    void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+    void Pipeline::createShaderModule(Device& device, const std::vector<char>& code, VkShaderModule* shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -193,8 +193,8 @@ namespace mnlt
         configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
 
-        configInfo.bindingDescriptions = Model::Vertex::getBindingDescriptions();
-        configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+        configInfo.bindingDescriptions = Model::PackedVertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = Model::PackedVertex::getAttributeDescriptions();
     }
 
     void Pipeline::enableAlphaBlending(PipelineConfigInfo& configInfo) 
@@ -217,4 +217,46 @@ namespace mnlt
         configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
         configInfo.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
     }
-}
\ No newline at end of file
+
+    ComputePipeline::ComputePipeline(Device& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout) : device{device}
+    {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto compCode = Pipeline::readFile(compFilePath);
+        Pipeline::createShaderModule(device, compCode, &compShaderModule);
+
+        VkPipelineShaderStageCreateInfo shaderStage{};
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        shaderStage.module = compShaderModule;
+        shaderStage.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = shaderStage;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+
+        if(vkCreateComputePipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create compute pipeline");
+        }
+    }
+
+    ComputePipeline::~ComputePipeline()
+    {
+        vkDestroyShaderModule(device.device(), compShaderModule, nullptr);
+        vkDestroyPipeline(device.device(), computePipeline, nullptr);
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
+    void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t invocationCount, uint32_t groupSize)
+    {
+        vkCmdDispatch(commandBuffer, (invocationCount + groupSize - 1) / groupSize, 1, 1);
+    }
+}
@@ -39,15 +39,34 @@ namespace mnlt
             static void enableAlphaBlending(PipelineConfigInfo& configInfo);
             static void setLineInputAssembly(PipelineConfigInfo& configInfo);
 
-        private:
             static std::vector<char> readFile(const std::string filepath);
+            static void createShaderModule(Device& device, const std::vector<char>& code, VkShaderModule* shaderModule);
+
+        private:
             Device& device;
             VkPipeline graphicsPipeline;
             VkShaderModule vertShaderModule;
             VkShaderModule fragShaderModule;
 
             void createGraphicsPipeline(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
+    };
 
-            void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+    // A single compute shader stage, the pipeline layout is owned by the system using it
+    class ComputePipeline
+    {
+        public:
+            ComputePipeline(Device& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout);
+            ~ComputePipeline();
+            ComputePipeline(const ComputePipeline&) = delete;
+            ComputePipeline operator=(const ComputePipeline&) = delete;
+
+            void bind(VkCommandBuffer commandBuffer);
+            // enough workgroups of groupSize invocations to cover invocationCount
+            static void dispatch(VkCommandBuffer commandBuffer, uint32_t invocationCount, uint32_t groupSize);
+
+        private:
+            Device& device;
+            VkPipeline computePipeline;
+            VkShaderModule compShaderModule;
     };
 }
\ No newline at end of file
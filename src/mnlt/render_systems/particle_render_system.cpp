@@ -0,0 +1,182 @@
+#include "particle_render_system.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace mnlt
+{
+    ParticleRenderSystem::ParticleRenderSystem(Device& device) : device{device}
+    {
+
+    }
+    ParticleRenderSystem::~ParticleRenderSystem()
+    {
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+    }
+
+    void ParticleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void ParticleRenderSystem::createPipeline(VkRenderPass renderPass)
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        PipelineConfigInfo pipelineConfig{};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+
+        // binding 1 advances once per particle instead of once per vertex
+        pipelineConfig.bindingDescriptions.push_back({1, sizeof(ParticleInstance), VK_VERTEX_INPUT_RATE_INSTANCE});
+        pipelineConfig.attributeDescriptions.push_back({5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ParticleInstance, positionScale)});
+        pipelineConfig.attributeDescriptions.push_back({6, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(ParticleInstance, color)});
+
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        pipeline = std::make_unique<Pipeline>
+        (
+            device,
+            "shaders/particle.vert.spv",
+            "shaders/particle.frag.spv",
+            pipelineConfig
+        );
+    }
+
+    void ParticleRenderSystem::createRenderer(VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
+    {
+        createPipelineLayout(globalSetLayout);
+        createPipeline(renderPass);
+    }
+
+    void ParticleRenderSystem::reserveInstances(int frameIndex, size_t count)
+    {
+        auto& buffer = instanceBuffers[frameIndex];
+        if (buffer != nullptr && buffer->getInstanceCount() >= count) return;
+
+        // grow geometrically so a slowly increasing particle count doesn't reallocate every frame.
+        // the previous buffer for this frame index is no longer in flight once beginFrame returned
+        uint32_t capacity = buffer == nullptr ? 1024 : buffer->getInstanceCount();
+        while (capacity < count) capacity *= 2;
+
+        buffer = std::make_unique<Buffer>
+        (
+            device,
+            sizeof(ParticleInstance),
+            capacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        buffer->map();
+    }
+
+    void ParticleRenderSystem::renderParticles(FrameInfo& frameInfo, Model& model, const ParticleStore& particles, const std::vector<glm::vec3>& typeColors, float particleScale)
+    {
+        size_t count = particles.size();
+        if (count == 0) return;
+
+        reserveInstances(frameInfo.frameIndex, count);
+        auto& instanceBuffer = instanceBuffers[frameInfo.frameIndex];
+
+        uint32_t lodCount = model.getLodCount();
+        lodInstanceCounts.assign(lodCount, 0);
+        particleLods.resize(count);
+
+        // the store is already laid out the way cullSpheres wants, moving the planes back by the
+        // sphere's offset saves adding it to every particle
+        const auto& sphere = model.getBoundingSphere();
+        Frustum frustum = Frustum::fromMatrix(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        for (auto& plane : frustum.planes)
+        {
+            plane.w += glm::dot(glm::vec3{plane}, sphere.center * particleScale);
+        }
+        particleRadius.assign(count, sphere.radius * particleScale);
+        containment.resize(count);
+        cullSpheres(frustum, particles.positionX.data(), particles.positionY.data(), particles.positionZ.data(), particleRadius.data(), count, containment.data());
+
+        // same choice as SimpleRenderSystem, from the nearest point of the scaled bounding sphere
+        glm::vec3 cameraPosition = frameInfo.camera.getPosition();
+        float viewportHeight = static_cast<float>(frameInfo.extent.height);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (containment[i] == Containment::Outside) continue;
+
+            glm::vec3 center = glm::vec3{particles.positionX[i], particles.positionY[i], particles.positionZ[i]} + sphere.center * particleScale;
+            float distance = glm::length(center - cameraPosition) - sphere.radius * particleScale;
+            uint32_t lod = model.selectLod(frameInfo.camera.getPixelsPerUnit(distance, viewportHeight) * particleScale);
+            particleLods[i] = static_cast<uint8_t>(lod);
+            lodInstanceCounts[lod]++;
+        }
+
+        lodOffsets.assign(lodCount, 0);
+        for (uint32_t lod = 1; lod < lodCount; lod++)
+        {
+            lodOffsets[lod] = lodOffsets[lod - 1] + lodInstanceCounts[lod - 1];
+        }
+
+        auto* instances = static_cast<ParticleInstance*>(instanceBuffer->getMappedMemory());
+        for (size_t i = 0; i < count; i++)
+        {
+            if (containment[i] == Containment::Outside) continue;
+
+            auto& instance = instances[lodOffsets[particleLods[i]]++];
+            instance.positionScale = {particles.positionX[i], particles.positionY[i], particles.positionZ[i], particleScale};
+            instance.color = glm::vec4(typeColors[particles.typeId[i]], 1.f);
+        }
+
+        drawInstances(frameInfo, model, instanceBuffer->getBuffer(), lodInstanceCounts);
+    }
+
+    void ParticleRenderSystem::renderParticles(FrameInfo& frameInfo, Model& model, VkBuffer instanceBuffer, uint32_t instanceCount)
+    {
+        if (instanceCount == 0) return;
+        lodInstanceCounts.assign(1, instanceCount);
+        drawInstances(frameInfo, model, instanceBuffer, lodInstanceCounts);
+    }
+
+    void ParticleRenderSystem::drawInstances(FrameInfo& frameInfo, Model& model, VkBuffer instanceBuffer, const std::vector<uint32_t>& instanceCounts)
+    {
+        pipeline->bind(frameInfo.commandBuffer);
+
+        vkCmdBindDescriptorSets
+        (
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &frameInfo.globalDescriptorSet,
+            0,
+            nullptr
+        );
+
+        model.bind(frameInfo.commandBuffer);
+        VkBuffer buffers[] = {instanceBuffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, buffers, offsets);
+
+        uint32_t firstInstance = 0;
+        for (uint32_t lod = 0; lod < instanceCounts.size(); lod++)
+        {
+            if (instanceCounts[lod] == 0) continue;
+            model.draw(frameInfo.commandBuffer, instanceCounts[lod], firstInstance, lod);
+            firstInstance += instanceCounts[lod];
+        }
+    }
+}
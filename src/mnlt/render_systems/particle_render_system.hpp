@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../buffer.hpp"
+#include "../device.hpp"
+#include "../frame_info.hpp"
+#include "../frustum.hpp"
+#include "../model.hpp"
+#include "../pipeline.hpp"
+#include "../physics/particle_store.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace mnlt
+{
+    // per instance vertex data, compute shaders that write instances directly must match this layout
+    struct ParticleInstance
+    {
+        glm::vec4 positionScale{};  // w is scale
+        glm::vec4 color{1.f};
+    };
+
+    // Draws every particle of a ParticleStore as an instance of one model. Instance data is streamed
+    // straight from the store into a per-frame vertex buffer, leaving out particles outside the view
+    // frustum and grouped by the lod each particle's distance calls for, and every lod is one draw call.
+    class ParticleRenderSystem
+    {
+        public:
+            ParticleRenderSystem(Device &device);
+            ~ParticleRenderSystem();
+
+            ParticleRenderSystem(const ParticleRenderSystem &) = delete;
+            ParticleRenderSystem &operator=(const ParticleRenderSystem &) = delete;
+
+            void createRenderer(VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+            // typeColors is indexed by the particles type id
+            void renderParticles(FrameInfo &frameInfo, Model &model, const ParticleStore &particles, const std::vector<glm::vec3> &typeColors, float particleScale);
+            // draws instances that already live on the gpu, e.g. written by a compute shader this frame.
+            // their positions never reach the cpu, so none are culled and they all draw at full detail
+            void renderParticles(FrameInfo &frameInfo, Model &model, VkBuffer instanceBuffer, uint32_t instanceCount);
+
+        private:
+            void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+            void createPipeline(VkRenderPass renderPass);
+            void reserveInstances(int frameIndex, size_t count);
+            // instanceCounts[lod] instances draw at lod, in lod order from the start of the buffer
+            void drawInstances(FrameInfo &frameInfo, Model &model, VkBuffer instanceBuffer, const std::vector<uint32_t> &instanceCounts);
+
+            Device &device;
+
+            std::unique_ptr<Pipeline> pipeline;
+            VkPipelineLayout pipelineLayout;
+
+            std::vector<std::unique_ptr<Buffer>> instanceBuffers{SwapChain::MAX_FRAMES_IN_FLIGHT};
+
+            // scratch reused every frame
+            std::vector<float> particleRadius;
+            std::vector<Containment> containment;
+            std::vector<uint8_t> particleLods;
+            std::vector<uint32_t> lodInstanceCounts;
+            std::vector<uint32_t> lodOffsets;
+    };
+}
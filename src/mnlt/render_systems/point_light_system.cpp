@@ -93,15 +93,14 @@ namespace mnlt
         //auto rotateLight = glm::rotate(glm::mat4(1.f), 0.5f * (float)frameInfo.time.getDeltaTime(), {0.f, -1.f, 0.f});
         int lightIndex = 0;
 
-        for (auto& kv : frameInfo.gameObjects) 
+        frameInfo.registry.each<PointLightComponent, TransformComponent, WorldTransformComponent, ColorComponent>(
+            [&](Entity entity, PointLightComponent& pointLight, TransformComponent& transform, WorldTransformComponent& world, ColorComponent& color)
         {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
             PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
+            // placed by the hierarchy, sized by its own scale
+            push.position = world.matrix[3];
+            push.color = glm::vec4(color.color, pointLight.lightIntensity);
+            push.radius = transform.scale.x;
 
             vkCmdPushConstants(
                 frameInfo.commandBuffer,
@@ -116,14 +115,14 @@ namespace mnlt
             assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified");
 
             // update light position
-            //obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
+            //transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
 
             // copy light to ubo
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+            ubo.pointLights[lightIndex].position = world.matrix[3];
+            ubo.pointLights[lightIndex].color = glm::vec4(color.color, pointLight.lightIntensity);
 
             lightIndex += 1;
-        }
+        });
         
         ubo.numLights = lightIndex;
     }
@@ -7,49 +7,149 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <numeric>
 #include <stdexcept>
 
 namespace mnlt
 {
 
-    struct SimplePushConstantData 
+    // std430 layout of one entry in the object storage buffer
+    struct SimpleInstanceData
     {
-        glm::vec3 color{1.f};
+        glm::vec4 color{1.f};
+        uint32_t textureIndex = 0;
+        // into the mesh table of the gpu culling passes
+        uint32_t meshIndex = 0;
+        // into the GameObjectManager's object buffer
+        uint32_t transformIndex = 0;
+        uint32_t padding;
     };
+    static_assert(sizeof(SimpleInstanceData) == 32, "SimpleInstanceData must match the std430 layout of ObjectInstance");
 
-    SimpleRenderSystem::SimpleRenderSystem(Device& device) : device{device} 
+    // std430 layouts of the culling passes, see cull_objects.comp
+    struct CullMesh
+    {
+        glm::vec4 boundingSphere{0.f};  // w is the radius
+        uint32_t firstDraw;
+        uint32_t lodCount;
+        float lodErrors[Model::MAX_LOD_COUNT];
+        uint32_t padding;
+    };
+    static_assert(sizeof(CullMesh) == 48, "CullMesh must match the std430 layout of Mesh");
+
+    struct CullDraw
+    {
+        VkDrawIndexedIndirectCommand command;
+        uint32_t meshIndex;
+    };
+    static_assert(sizeof(CullDraw) == 24, "CullDraw must match the std430 layout of Draw");
+
+    // the length of the longest axis of the matrix, a sphere scaled by it still holds the transformed model
+    static float maxAxisScale(const glm::mat4 &matrix)
+    {
+        float lengthSquared = glm::max(
+            glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+            glm::max(glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])), glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))));
+        return glm::sqrt(lengthSquared);
+    }
+
+    struct CullPushConstants
+    {
+        glm::vec4 planes[6];
+        glm::vec4 cameraPosition;  // w is the near distance, 0 for an orthographic projection
+        float projectionScale;
+        uint32_t objectCount;
+        uint32_t drawCount;
+    };
+
+    namespace
+    {
+        constexpr uint32_t CULL_GROUP_SIZE = 256;
+
+        // grows buffer to hold count instances, doubling so a slowly growing scene doesn't reallocate
+        // every frame. Returns whether it had to
+        bool reserveBuffer(
+            Device &device, std::unique_ptr<Buffer> &buffer, VkDeviceSize instanceSize, size_t count,
+            VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+        {
+            if (buffer != nullptr && buffer->getInstanceCount() >= count) return false;
+
+            // the previous buffer for this frame index is no longer in flight once beginFrame returned
+            uint32_t capacity = buffer == nullptr ? 256 : buffer->getInstanceCount();
+            while (capacity < count) capacity *= 2;
+
+            buffer = std::make_unique<Buffer>(device, instanceSize, capacity, usage, properties);
+            if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            {
+                buffer->map();
+            }
+            return true;
+        }
+
+        void computeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+        {
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+            vkCmdPipelineBarrier
+            (
+                commandBuffer,
+                srcStage,
+                dstStage,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+            );
+        }
+    }
+
+    SimpleRenderSystem::SimpleRenderSystem(Device& device, TextureTable& textureTable) : device{device}, textureTable{textureTable}
     {
         
     }
     SimpleRenderSystem::~SimpleRenderSystem() 
     {
         vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+        if (cullPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(device.device(), cullPipelineLayout, nullptr);
+        }
     }
 
     void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) 
     {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
-
         renderSystemLayout = DescriptorSetLayout::Builder(device)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
-            .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+
+        // per frame the instance set with three buffers and the cull set with seven
+        descriptorPool = DescriptorPool::Builder(device)
+            .setMaxSets(2 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 10 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
             .build();
 
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts
         {
             globalSetLayout,
-            renderSystemLayout->getDescriptorSetLayout()
+            renderSystemLayout->getDescriptorSetLayout(),
+            textureTable.getDescriptorSetLayout()
         };
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to create pipeline layout!");
@@ -73,69 +173,533 @@ namespace mnlt
         );
     }
 
+    void SimpleRenderSystem::createCullPipelines()
+    {
+        // 0 objects, 1 meshes, 2 draws, 3 visible objects, 4 draw commands, 5 draw counts, 6 object transforms
+        auto builder = DescriptorSetLayout::Builder(device);
+        for (uint32_t binding = 0; binding < 7; binding++)
+        {
+            builder.addBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT);
+        }
+        cullSetLayout = builder.build();
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkDescriptorSetLayout descriptorSetLayout = cullSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        cullPipeline = std::make_unique<ComputePipeline>(device, "shaders/cull_objects.comp.spv", cullPipelineLayout);
+        compactPipeline = std::make_unique<ComputePipeline>(device, "shaders/compact_draws.comp.spv", cullPipelineLayout);
+    }
+
     void SimpleRenderSystem::createRenderer(VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
     {
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
+
+        gpuCulling = device.hasDrawIndirectCount();
+        if (gpuCulling)
+        {
+            createCullPipelines();
+        }
     }
 
-    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+    void SimpleRenderSystem::reserveFrameBuffers(
+        int frameIndex, const Buffer& objectTransforms, size_t objectCount, size_t visibleCount, size_t meshCount, size_t drawCount)
+    {
+        auto& frame = frames[frameIndex];
+        constexpr VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        bool moved = frame.objectTransforms != objectTransforms.getBuffer();
+        moved |= reserveBuffer(device, frame.objects, sizeof(SimpleInstanceData), objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+        if (!gpuCulling)
+        {
+            if (reserveBuffer(device, frame.visibleObjects, sizeof(uint32_t), visibleCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible))
+            {
+                auto* visible = static_cast<uint32_t*>(frame.visibleObjects->getMappedMemory());
+                std::iota(visible, visible + frame.visibleObjects->getInstanceCount(), 0u);
+                moved = true;
+            }
+        }
+        else
+        {
+            // only the gpu touches what the culling passes write, the indices of the objects drawn directly are copied in
+            moved |= reserveBuffer(
+                device, frame.visibleObjects, sizeof(uint32_t), visibleCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            moved |= reserveBuffer(device, frame.meshes, sizeof(CullMesh), meshCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+            moved |= reserveBuffer(device, frame.draws, sizeof(CullDraw), drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible);
+            moved |= reserveBuffer(
+                device, frame.drawCommands, sizeof(VkDrawIndexedIndirectCommand), drawCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            moved |= reserveBuffer(
+                device, frame.drawCounts, sizeof(uint32_t), meshCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        if (moved)
+        {
+            writeDescriptorSets(frameIndex, objectTransforms);
+        }
+    }
+
+    void SimpleRenderSystem::writeDescriptorSets(int frameIndex, const Buffer& objectTransforms)
+    {
+        auto& frame = frames[frameIndex];
+        std::vector<VkDescriptorSet> oldSets;
+        if (frame.instanceSet != VK_NULL_HANDLE) oldSets.push_back(frame.instanceSet);
+        if (frame.cullSet != VK_NULL_HANDLE) oldSets.push_back(frame.cullSet);
+        if (!oldSets.empty())
+        {
+            descriptorPool->freeDescriptors(oldSets);
+        }
+
+        auto objectInfo = frame.objects->descriptorInfo();
+        auto visibleInfo = frame.visibleObjects->descriptorInfo();
+        auto transformInfo = objectTransforms.descriptorInfo();
+        frame.objectTransforms = objectTransforms.getBuffer();
+        if (!DescriptorWriter(*renderSystemLayout, *descriptorPool)
+                .writeBuffer(0, &objectInfo)
+                .writeBuffer(1, &visibleInfo)
+                .writeBuffer(2, &transformInfo)
+                .build(frame.instanceSet))
+        {
+            throw std::runtime_error("failed to allocate game object descriptor set!");
+        }
+
+        frame.cullSet = VK_NULL_HANDLE;
+        if (!gpuCulling) return;
+
+        auto meshInfo = frame.meshes->descriptorInfo();
+        auto drawInfo = frame.draws->descriptorInfo();
+        auto drawCommandInfo = frame.drawCommands->descriptorInfo();
+        auto drawCountInfo = frame.drawCounts->descriptorInfo();
+        if (!DescriptorWriter(*cullSetLayout, *descriptorPool)
+                .writeBuffer(0, &objectInfo)
+                .writeBuffer(1, &meshInfo)
+                .writeBuffer(2, &drawInfo)
+                .writeBuffer(3, &visibleInfo)
+                .writeBuffer(4, &drawCommandInfo)
+                .writeBuffer(5, &drawCountInfo)
+                .writeBuffer(6, &transformInfo)
+                .build(frame.cullSet))
+        {
+            throw std::runtime_error("failed to allocate game object cull descriptor set!");
+        }
+    }
+
+    void SimpleRenderSystem::addBoundingSphere(const WorldTransformComponent& transform, const Model& model)
+    {
+        // scaled by the largest axis, so the sphere still holds the model
+        const auto& sphere = model.getBoundingSphere();
+        glm::vec3 center = glm::vec3(transform.matrix * glm::vec4(sphere.center, 1.f));
+
+        sphereX.push_back(center.x);
+        sphereY.push_back(center.y);
+        sphereZ.push_back(center.z);
+        sphereRadius.push_back(sphere.radius * maxAxisScale(transform.matrix));
+    }
+
+    void SimpleRenderSystem::buildBatches(FrameInfo& frameInfo)
+    {
+        cullObjects.clear();
+        sphereX.clear();
+        sphereY.clear();
+        sphereZ.clear();
+        sphereRadius.clear();
+        frameInfo.registry.each<ModelComponent, WorldTransformComponent, ColorComponent>(
+            [&](Entity entity, ModelComponent& model, WorldTransformComponent& transform, ColorComponent& color)
+        {
+            if (model.model == nullptr) return;
+
+            cullObjects.push_back({entity.index, &transform, &color, &model});
+            addBoundingSphere(transform, *model.model);
+        });
+        batchVisibleObjects(frameInfo, cullObjects);
+    }
+
+    void SimpleRenderSystem::batchVisibleObjects(FrameInfo& frameInfo, const std::vector<RenderObject>& objects)
+    {
+        Frustum frustum = Frustum::fromMatrix(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        containment.resize(objects.size());
+        cullSpheres(frustum, sphereX.data(), sphereY.data(), sphereZ.data(), sphereRadius.data(), objects.size(), containment.data());
+
+        glm::vec3 cameraPosition = frameInfo.camera.getPosition();
+        float viewportHeight = static_cast<float>(frameInfo.extent.height);
+        drawOrder.clear();
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            if (containment[i] == Containment::Outside) continue;
+
+            const auto& obj = objects[i];
+            const glm::mat4& modelMatrix = obj.transform->matrix;
+            if (containment[i] == Containment::Intersecting)
+            {
+                // the box is tighter for long or flat models, transformed it still lines up with the world axes
+                const auto& box = obj.model->model->getBoundingBox();
+                glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((box.min + box.max) * 0.5f, 1.f));
+                glm::vec3 halfSize = (box.max - box.min) * 0.5f;
+                glm::vec3 extents = glm::abs(glm::vec3(modelMatrix[0])) * halfSize.x
+                    + glm::abs(glm::vec3(modelMatrix[1])) * halfSize.y
+                    + glm::abs(glm::vec3(modelMatrix[2])) * halfSize.z;
+                if (frustum.testBox(center, extents) == Containment::Outside) continue;
+            }
+
+            // the distance to the nearest point of the bounding sphere errs towards more detail
+            glm::vec3 center{sphereX[i], sphereY[i], sphereZ[i]};
+            float maxScale = maxAxisScale(modelMatrix);
+            float distance = glm::length(center - cameraPosition) - sphereRadius[i];
+            uint32_t lod = obj.model->model->selectLod(frameInfo.camera.getPixelsPerUnit(distance, viewportHeight) * maxScale);
+
+            drawOrder.push_back({obj, lod});
+        }
+
+        // objects of a batch end up next to each other, so each batch is one range of instances
+        std::less<const void*> before;
+        std::sort(drawOrder.begin(), drawOrder.end(), [&](const DrawItem& a, const DrawItem& b)
+        {
+            if (a.object.model->model != b.object.model->model) return before(a.object.model->model.get(), b.object.model->model.get());
+            return a.lod < b.lod;
+        });
+
+        batches.clear();
+        for (uint32_t i = 0; i < drawOrder.size(); i++)
+        {
+            auto& item = drawOrder[i];
+            if (batches.empty() || batches.back().model != item.object.model->model.get() || batches.back().lod != item.lod)
+            {
+                batches.push_back({item.object.model->model.get(), item.lod, i, 0});
+            }
+            batches.back().instanceCount++;
+        }
+    }
+
+    bool SimpleRenderSystem::requestCullingCheck()
+    {
+        if (!gpuCulling) return false;
+
+        // a check still in flight would finish the new one with older counts
+        for (auto& frame : frames)
+        {
+            frame.checkedDrawCount = 0;
+        }
+        cullingCheckRequested = true;
+        cullingCheck = {};
+        return true;
+    }
+
+    void SimpleRenderSystem::checkCulledCount(FrameResources& frame)
+    {
+        if (frame.checkedDrawCount == 0) return;
+
+        // the first pass added every object it kept to the instance count of one draw
+        const auto* draws = static_cast<const CullDraw*>(frame.draws->getMappedMemory());
+        uint32_t gpuVisibleCount = 0;
+        for (uint32_t i = 0; i < frame.checkedDrawCount; i++)
+        {
+            gpuVisibleCount += draws[i].command.instanceCount;
+        }
+        frame.checkedDrawCount = 0;
+
+        cullingCheck.finished = true;
+        cullingCheck.gpuVisibleCount = gpuVisibleCount;
+        cullingCheck.cpuVisibleCount = frame.cpuVisibleCount;
+    }
+
+    void SimpleRenderSystem::cullGameObjects(FrameInfo& frameInfo)
+    {
+        if (!gpuCulling) return;
+        culled = true;
+
+        // beginFrame waited for the last frame recorded with this index, before its buffers are reused
+        int frameIndex = frameInfo.frameIndex;
+        checkCulledCount(frames[frameIndex]);
+
+        // the mesh table gets an entry per model, in the order the objects first use them
+        cullObjects.clear();
+        directObjects.clear();
+        objectMeshes.clear();
+        meshIndices.clear();
+        meshObjectCounts.clear();
+        meshDraws.clear();
+        frameInfo.registry.each<ModelComponent, WorldTransformComponent, ColorComponent>(
+            [&](Entity entity, ModelComponent& model, WorldTransformComponent& transform, ColorComponent& color)
+        {
+            if (model.model == nullptr) return;
+            // indirect draws need an index buffer
+            if (!model.model->isIndexed())
+            {
+                directObjects.push_back({entity.index, &transform, &color, &model});
+                return;
+            }
+
+            auto inserted = meshIndices.emplace(model.model.get(), static_cast<uint32_t>(meshDraws.size()));
+            if (inserted.second)
+            {
+                meshDraws.push_back({model.model.get(), 0, model.model->getLodCount()});
+                meshObjectCounts.push_back(0);
+            }
+            uint32_t meshIndex = inserted.first->second;
+            meshObjectCounts[meshIndex]++;
+            cullObjects.push_back({entity.index, &transform, &color, &model});
+            objectMeshes.push_back(meshIndex);
+        });
+
+        sphereX.clear();
+        sphereY.clear();
+        sphereZ.clear();
+        sphereRadius.clear();
+        for (const auto& obj : directObjects)
+        {
+            addBoundingSphere(*obj.transform, *obj.model->model);
+        }
+        batchVisibleObjects(frameInfo, directObjects);
+        if (cullObjects.empty() && drawOrder.empty()) return;
+
+        // every lod of a model has room for all of its objects, the first pass never has to bounds check
+        uint32_t drawCount = 0;
+        uint32_t visibleCount = 0;
+        for (size_t i = 0; i < meshDraws.size(); i++)
+        {
+            meshDraws[i].firstDraw = drawCount;
+            drawCount += meshDraws[i].lodCount;
+            visibleCount += meshObjectCounts[i] * meshDraws[i].lodCount;
+        }
+        directFirstInstance = visibleCount;
+
+        reserveFrameBuffers(
+            frameIndex, frameInfo.gameObjectManager.getObjectBuffer(frameIndex), cullObjects.size() + drawOrder.size(),
+            visibleCount + drawOrder.size(), meshDraws.size(), drawCount);
+        auto& frame = frames[frameIndex];
+
+        auto* objects = static_cast<SimpleInstanceData*>(frame.objects->getMappedMemory());
+        for (size_t i = 0; i < cullObjects.size(); i++)
+        {
+            const auto& obj = cullObjects[i];
+            objects[i].transformIndex = obj.entityIndex;
+            objects[i].color = glm::vec4(obj.color->color, 1.f);
+            objects[i].textureIndex = textureTable.getIndex(obj.model->diffuseMap);
+            objects[i].meshIndex = objectMeshes[i];
+        }
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        if (!drawOrder.empty())
+        {
+            // the objects drawn directly come after the ones the culling pass sees, in batch order
+            directVisible.resize(drawOrder.size());
+            for (size_t i = 0; i < drawOrder.size(); i++)
+            {
+                const auto& obj = drawOrder[i].object;
+                auto& instance = objects[cullObjects.size() + i];
+                instance.transformIndex = obj.entityIndex;
+                instance.color = glm::vec4(obj.color->color, 1.f);
+                instance.textureIndex = textureTable.getIndex(obj.model->diffuseMap);
+                directVisible[i] = static_cast<uint32_t>(cullObjects.size() + i);
+            }
+
+            // vkCmdUpdateBuffer takes at most 65536 bytes at a time
+            constexpr size_t MAX_UPDATE_COUNT = 65536 / sizeof(uint32_t);
+            for (size_t first = 0; first < directVisible.size(); first += MAX_UPDATE_COUNT)
+            {
+                size_t count = std::min(MAX_UPDATE_COUNT, directVisible.size() - first);
+                vkCmdUpdateBuffer(
+                    commandBuffer, frame.visibleObjects->getBuffer(), sizeof(uint32_t) * (directFirstInstance + first),
+                    sizeof(uint32_t) * count, directVisible.data() + first);
+            }
+            computeBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+        if (cullObjects.empty()) return;
+
+        auto* meshes = static_cast<CullMesh*>(frame.meshes->getMappedMemory());
+        auto* draws = static_cast<CullDraw*>(frame.draws->getMappedMemory());
+        uint32_t firstInstance = 0;
+        for (uint32_t m = 0; m < meshDraws.size(); m++)
+        {
+            const auto& mesh = meshDraws[m];
+            const auto& sphere = mesh.model->getBoundingSphere();
+            meshes[m].boundingSphere = glm::vec4(sphere.center, sphere.radius);
+            meshes[m].firstDraw = mesh.firstDraw;
+            meshes[m].lodCount = mesh.lodCount;
+            for (uint32_t lod = 0; lod < mesh.lodCount; lod++)
+            {
+                const auto& range = mesh.model->getLod(lod);
+                meshes[m].lodErrors[lod] = range.error;
+                // the first pass counts the instances up from zero
+                draws[mesh.firstDraw + lod] = {{range.indexCount, 0, range.firstIndex, 0, firstInstance}, m};
+                firstInstance += meshObjectCounts[m];
+            }
+        }
+
+        CullPushConstants push{};
+        Frustum frustum = Frustum::fromMatrix(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+        std::copy(std::begin(frustum.planes), std::end(frustum.planes), push.planes);
+        // Camera::getPixelsPerUnit split into what is the same for every object and the distance
+        const glm::mat4& projection = frameInfo.camera.getProjection();
+        bool orthographic = projection[2][3] == 0.f;
+        push.cameraPosition = glm::vec4(frameInfo.camera.getPosition(), orthographic ? 0.f : frameInfo.camera.getNear());
+        push.projectionScale = glm::abs(projection[1][1]) * 0.5f * static_cast<float>(frameInfo.extent.height);
+        push.objectCount = static_cast<uint32_t>(cullObjects.size());
+        push.drawCount = drawCount;
+
+        bool checking = cullingCheckRequested;
+        if (checking)
+        {
+            sphereX.clear();
+            sphereY.clear();
+            sphereZ.clear();
+            sphereRadius.clear();
+            for (const auto& obj : cullObjects)
+            {
+                addBoundingSphere(*obj.transform, *obj.model->model);
+            }
+            containment.resize(cullObjects.size());
+            cullSpheres(frustum, sphereX.data(), sphereY.data(), sphereZ.data(), sphereRadius.data(), cullObjects.size(), containment.data());
+            frame.cpuVisibleCount = static_cast<uint32_t>(
+                std::count_if(containment.begin(), containment.end(), [](Containment c) { return c != Containment::Outside; }));
+            frame.checkedDrawCount = drawCount;
+            cullingCheckRequested = false;
+        }
+
+        vkCmdFillBuffer(commandBuffer, frame.drawCounts->getBuffer(), 0, sizeof(uint32_t) * meshDraws.size(), 0);
+        computeBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+
+        cullPipeline->bind(commandBuffer);
+        ComputePipeline::dispatch(commandBuffer, push.objectCount, CULL_GROUP_SIZE);
+        // the second pass reads the instance counts the first one added up
+        computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        compactPipeline->bind(commandBuffer);
+        ComputePipeline::dispatch(commandBuffer, drawCount, CULL_GROUP_SIZE);
+        computeBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+        if (checking)
+        {
+            // checkCulledCount reads the instance counts of the first pass once the frame has finished
+            computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+        }
+    }
+
+    void SimpleRenderSystem::bindDescriptorSets(FrameInfo& frameInfo)
     {
         pipeline->bind(frameInfo.commandBuffer);
 
+        // 0 is the globalDescriptorSet, 1 this frame's objects and 2 the texture table
+        VkDescriptorSet descriptorSets[] =
+        {
+            frameInfo.globalDescriptorSet,
+            frames[frameInfo.frameIndex].instanceSet,
+            textureTable.getDescriptorSet()
+        };
         vkCmdBindDescriptorSets
         (
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
-            1,
-            &frameInfo.globalDescriptorSet,
+            3,
+            descriptorSets,
             0,
             nullptr
         );
+    }
 
-        for (auto& kv : frameInfo.gameObjects) 
+    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+    {
+        if (gpuCulling)
+        {
+            renderGpuCulled(frameInfo);
+        }
+        else
         {
-            auto& obj = kv.second;
+            renderCpuCulled(frameInfo);
+        }
+    }
 
-            if (obj.model == nullptr) continue;
+    void SimpleRenderSystem::renderCpuCulled(FrameInfo& frameInfo)
+    {
+        buildBatches(frameInfo);
+        if (drawOrder.empty()) return;
 
-            // writing descriptor set each frame can slow performance
-            // would be more efficient to implement some sort of caching
-            auto bufferInfo = obj.getBufferInfo(frameInfo.frameIndex);
-            auto imageInfo = obj.diffuseMap->getImageInfo();
-            VkDescriptorSet gameObjectDescriptorSet;
-            DescriptorWriter(*renderSystemLayout, frameInfo.frameDescriptorPool)
-                .writeBuffer(0, &bufferInfo)
-                .writeImage(1, &imageInfo)
-                .build(gameObjectDescriptorSet);
+        int frameIndex = frameInfo.frameIndex;
+        reserveFrameBuffers(frameIndex, frameInfo.gameObjectManager.getObjectBuffer(frameIndex), drawOrder.size(), drawOrder.size(), 0, 0);
+        auto* instances = static_cast<SimpleInstanceData*>(frames[frameIndex].objects->getMappedMemory());
+        for (size_t i = 0; i < drawOrder.size(); i++)
+        {
+            const auto& obj = drawOrder[i].object;
+            instances[i].transformIndex = obj.entityIndex;
+            instances[i].color = glm::vec4(obj.color->color, 1.f);
+            instances[i].textureIndex = textureTable.getIndex(obj.model->diffuseMap);
+        }
 
-            vkCmdBindDescriptorSets(
-                frameInfo.commandBuffer,
-                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                pipelineLayout,
-                1,  // starting set (0 is the globalDescriptorSet, 1 is the set specific to this system)
-                1,  // set count
-                &gameObjectDescriptorSet,
-                0,
-                nullptr);
+        bindDescriptorSets(frameInfo);
 
-            SimplePushConstantData push{};
-            push.color = obj.color;
+        // the lods of a model share its buffers
+        Model* boundModel = nullptr;
+        for (auto& batch : batches)
+        {
+            if (batch.model != boundModel)
+            {
+                batch.model->bind(frameInfo.commandBuffer);
+                boundModel = batch.model;
+            }
+            batch.model->draw(frameInfo.commandBuffer, batch.instanceCount, batch.firstInstance, batch.lod);
+        }
+    }
+
+    void SimpleRenderSystem::renderGpuCulled(FrameInfo& frameInfo)
+    {
+        assert(culled && "cullGameObjects must be recorded before renderGameObjects");
+        culled = false;
+        if (cullObjects.empty() && drawOrder.empty()) return;
 
-            vkCmdPushConstants
+        bindDescriptorSets(frameInfo);
+
+        // one call per model no matter how many of its objects are visible, a model with none draws nothing
+        auto& frame = frames[frameInfo.frameIndex];
+        for (uint32_t m = 0; m < meshDraws.size(); m++)
+        {
+            const auto& mesh = meshDraws[m];
+            mesh.model->bind(frameInfo.commandBuffer);
+            mesh.model->drawIndirect
             (
                 frameInfo.commandBuffer,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(SimplePushConstantData),
-                &push
+                frame.drawCommands->getBuffer(),
+                sizeof(VkDrawIndexedIndirectCommand) * mesh.firstDraw,
+                frame.drawCounts->getBuffer(),
+                sizeof(uint32_t) * m,
+                mesh.lodCount
             );
+        }
 
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+        // then the models without an index buffer that the cpu kept
+        Model* boundModel = nullptr;
+        for (auto& batch : batches)
+        {
+            if (batch.model != boundModel)
+            {
+                batch.model->bind(frameInfo.commandBuffer);
+                boundModel = batch.model;
+            }
+            batch.model->draw(frameInfo.commandBuffer, batch.instanceCount, directFirstInstance + batch.firstInstance, batch.lod);
         }
     }
 }
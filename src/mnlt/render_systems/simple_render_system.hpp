@@ -1,35 +1,184 @@
 #pragma once
 
+#include "../buffer.hpp"
+#include "../descriptors.hpp"
 #include "../device.hpp"
 #include "../pipeline.hpp"
 #include "../frame_info.hpp"
+#include "../frustum.hpp"
+#include "../texture_table.hpp"
 
 // std
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace mnlt
 {
+    // Draws game objects with instancing. Every object's color, texture table slot, mesh and entity
+    // index go into a per-frame storage buffer, and the vertex shader finds its object through a list of
+    // visible object indices at gl_InstanceIndex. Matrices aren't copied, the shaders read them from the
+    // GameObjectManager's object buffer at the entity index, which only uploads the ones that changed. Textures come from the bindless TextureTable, so
+    // objects with different diffuse maps still share a draw. Every object draws the coarsest level of
+    // detail of its model whose error stays under a pixel at its distance.
+    //
+    // On devices with draw indirect count, culling runs on the gpu. cullGameObjects records two compute
+    // passes before the render pass: the first tests every object's bounding sphere against the view
+    // frustum, picks its lod and appends it to the visible list of its model and lod, the second packs
+    // the draws that got any instances into indirect commands and a count per model. renderGameObjects
+    // then issues one vkCmdDrawIndexedIndirectCount per model, however many objects there are. Models
+    // without an index buffer can't be drawn indirectly, their objects are culled on the cpu as below and
+    // drawn directly after the indirect draws. requestCullingCheck tests the bounding spheres of one
+    // culling pass on the cpu too, to compare how many objects each kept.
+    //
+    // Elsewhere culling runs on the cpu in renderGameObjects and cullGameObjects does nothing. Bounding
+    // spheres are tested all at once with cullSpheres and the boxes of those that cross a plane one by
+    // one, then the objects sharing a model and a lod form a batch drawn with one instanced draw.
     class SimpleRenderSystem 
     {
         public:
-            SimpleRenderSystem(Device &device);
+            SimpleRenderSystem(Device &device, TextureTable &textureTable);
             ~SimpleRenderSystem();
 
             SimpleRenderSystem(const SimpleRenderSystem &) = delete;
             SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
             void createRenderer(VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+            // records this frame's culling passes, must come before the render pass begins and before
+            // renderGameObjects
+            void cullGameObjects(FrameInfo &frameInfo);
             void renderGameObjects(FrameInfo &frameInfo);
 
+            struct CullingCheck
+            {
+                // false until the frame of the last request has finished
+                bool finished = false;
+                uint32_t gpuVisibleCount = 0;
+                uint32_t cpuVisibleCount = 0;
+            };
+
+            // checks the next culling pass that has objects, false when culling runs on the cpu anyway
+            bool requestCullingCheck();
+            const CullingCheck &getCullingCheck() const { return cullingCheck; }
+
         private:
             void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
             void createPipeline(VkRenderPass renderPass);
+            void createCullPipelines();
+            // grows the buffers of frameIndex to fit and rebuilds its descriptor sets when any moved
+            void reserveFrameBuffers(
+                int frameIndex, const Buffer &objectTransforms, size_t objectCount, size_t visibleCount, size_t meshCount, size_t drawCount);
+            void writeDescriptorSets(int frameIndex, const Buffer &objectTransforms);
+            // adds the world space bounding sphere of an object to the ones cullSpheres tests
+            void addBoundingSphere(const WorldTransformComponent &transform, const Model &model);
+            // culls every object with a model and batches what's left
+            void buildBatches(FrameInfo &frameInfo);
+            void renderCpuCulled(FrameInfo &frameInfo);
+            void renderGpuCulled(FrameInfo &frameInfo);
+            void bindDescriptorSets(FrameInfo &frameInfo);
+
+            // the components of an object with a model, they stay put while the frame is recorded
+            struct RenderObject
+            {
+                // where its matrices are in the object buffer
+                uint32_t entityIndex;
+                const WorldTransformComponent *transform;
+                const ColorComponent *color;
+                const ModelComponent *model;
+            };
+
+            struct DrawItem
+            {
+                RenderObject object;
+                uint32_t lod;
+            };
+
+            struct Batch
+            {
+                Model *model;
+                uint32_t lod;
+                uint32_t firstInstance;
+                uint32_t instanceCount;
+            };
+
+            // a model drawn this frame on the gpu path, its lods are draws firstDraw on
+            struct MeshDraws
+            {
+                Model *model;
+                uint32_t firstDraw;
+                uint32_t lodCount;
+            };
+
+            struct FrameResources
+            {
+                // every object with a model on the gpu path followed by the visible ones without an index
+                // buffer, the visible ones in batch order on the cpu path
+                std::unique_ptr<Buffer> objects;
+                // filled by the culling pass on the gpu path and followed by the objects drawn directly,
+                // always 0, 1, 2, ... on the cpu path
+                std::unique_ptr<Buffer> visibleObjects;
+                // only used on the gpu path
+                std::unique_ptr<Buffer> meshes;
+                std::unique_ptr<Buffer> draws;
+                std::unique_ptr<Buffer> drawCommands;
+                std::unique_ptr<Buffer> drawCounts;
+                // the GameObjectManager's object buffer the sets were written with, it's replaced as it grows
+                VkBuffer objectTransforms = VK_NULL_HANDLE;
+                // objects and visible objects for the vertex shader
+                VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+                // everything for the culling passes
+                VkDescriptorSet cullSet = VK_NULL_HANDLE;
+                // for a requested check, how many objects the cpu found inside the frustum and how many
+                // draws the culling pass counted them into, 0 when there's nothing to compare
+                uint32_t cpuVisibleCount = 0;
+                uint32_t checkedDrawCount = 0;
+            };
+
+            // culls objects on the cpu, their bounding spheres must have been added in the same order, then
+            // sorts the visible ones into drawOrder and batches
+            void batchVisibleObjects(FrameInfo &frameInfo, const std::vector<RenderObject> &objects);
+            // compares what the finished culling pass of frame kept with what the cpu did when it was recorded
+            void checkCulledCount(FrameResources &frame);
 
             Device &device;
+            TextureTable &textureTable;
 
             std::unique_ptr<Pipeline> pipeline;
             VkPipelineLayout pipelineLayout;
 
+            bool gpuCulling = false;
+            std::unique_ptr<ComputePipeline> cullPipeline;
+            std::unique_ptr<ComputePipeline> compactPipeline;
+            VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+
             std::unique_ptr<DescriptorSetLayout> renderSystemLayout;
+            std::unique_ptr<DescriptorSetLayout> cullSetLayout;
+            // the sets of a frame in flight are only rebuilt when one of its buffers grows
+            std::unique_ptr<DescriptorPool> descriptorPool;
+            std::vector<FrameResources> frames = std::vector<FrameResources>(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+            // scratch reused every frame, the world space bounding spheres of every object with a model
+            // as cullSpheres takes them, then what survives culling
+            std::vector<RenderObject> cullObjects;
+            std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+            std::vector<Containment> containment;
+            std::vector<DrawItem> drawOrder;
+            std::vector<Batch> batches;
+
+            // gpu path scratch, the models of this frame's objects in the order of the mesh table
+            std::unordered_map<Model *, uint32_t> meshIndices;
+            std::vector<uint32_t> objectMeshes;
+            std::vector<uint32_t> meshObjectCounts;
+            std::vector<MeshDraws> meshDraws;
+            // objects without an index buffer, culled on the cpu into drawOrder and batches
+            std::vector<RenderObject> directObjects;
+            std::vector<uint32_t> directVisible;
+            // where the objects drawn directly start in visibleObjects
+            uint32_t directFirstInstance = 0;
+            // set by cullGameObjects, so renderGameObjects can tell the passes were recorded
+            bool culled = false;
+
+            bool cullingCheckRequested = false;
+            CullingCheck cullingCheck{};
     };
 }
@@ -21,6 +21,7 @@ namespace mnlt
 
             VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); }
             float getAspectRatio() const { return swapChain->extentAspectRatio(); }
+            VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); }
             uint32_t getImageCount() const { return swapChain->imageCount(); }
             bool isFrameInProgress() const { return isFrameStarted; }
 
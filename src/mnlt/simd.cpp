@@ -0,0 +1,78 @@
+#include "simd.hpp"
+
+namespace mnlt
+{
+    namespace
+    {
+#ifdef MNLT_X86
+        bool cpuSupportsAvx2()
+        {
+    #if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuidex(info, 1, 0);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx) return false;
+            // the os has to save the ymm registers on context switches
+            if ((_xgetbv(0) & 0x6) != 0x6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+    #else
+            // also checks that the os saves the ymm registers
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+    #endif
+        }
+
+        bool cpuSupportsSse2()
+        {
+    #if defined(_M_X64) || defined(__x86_64__)
+            return true; // part of the x86-64 baseline
+    #elif defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+    #else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+    #endif
+        }
+#endif
+
+        SimdLevel detectSimdLevel()
+        {
+#ifdef MNLT_X86
+            if (cpuSupportsAvx2()) return SimdLevel::AVX2;
+            if (cpuSupportsSse2()) return SimdLevel::SSE2;
+#endif
+            return SimdLevel::Scalar;
+        }
+    }
+
+    SimdLevel bestSimdLevel()
+    {
+        static const SimdLevel level = detectSimdLevel();
+        return level;
+    }
+
+    std::vector<SimdLevel> supportedSimdLevels()
+    {
+        std::vector<SimdLevel> levels{SimdLevel::Scalar};
+        if (bestSimdLevel() >= SimdLevel::SSE2) levels.push_back(SimdLevel::SSE2);
+        if (bestSimdLevel() >= SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+        return levels;
+    }
+
+    const char *simdLevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+            case SimdLevel::Scalar: return "Scalar";
+            case SimdLevel::SSE2: return "SSE2";
+            case SimdLevel::AVX2: return "AVX2";
+        }
+        return "Unknown";
+    }
+}
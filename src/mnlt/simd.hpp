@@ -0,0 +1,36 @@
+#pragma once
+
+// std
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define MNLT_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        // msvc lets every translation unit use every intrinsic, no per function targets needed
+        #define MNLT_TARGET_SSE2
+        #define MNLT_TARGET_AVX2
+    #else
+        #define MNLT_TARGET_SSE2 __attribute__((target("sse2")))
+        #define MNLT_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace mnlt
+{
+    // instruction sets the kernels are written for, kernels pick theirs at run time so one binary
+    // runs everywhere
+    enum class SimdLevel
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    // highest level both the cpu and the os support, detected once
+    SimdLevel bestSimdLevel();
+    // every level this machine can run, lowest first
+    std::vector<SimdLevel> supportedSimdLevels();
+    const char *simdLevelName(SimdLevel level);
+}
@@ -42,7 +42,7 @@ SwapChain::~SwapChain() {
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.allocator().free(depthImageAllocations[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -87,12 +87,22 @@ VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  // also waits for the uploads submitted so far, which frees the cpu from waiting on any copy
+  VkSemaphore waitSemaphores[] = {
+      imageAvailableSemaphores[currentFrame], device.uploads().getSemaphore()};
+  VkPipelineStageFlags waitStages[] = {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, UploadManager::WAIT_STAGES};
+  uint64_t waitValues[] = {0, device.uploads().getSubmittedValue()};
+  submitInfo.waitSemaphoreCount = 2;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
+  VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.waitSemaphoreValueCount = 2;
+  timelineInfo.pWaitSemaphoreValues = waitValues;
+  submitInfo.pNext = &timelineInfo;
+
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = buffers;
 
@@ -299,7 +309,7 @@ void SwapChain::createDepthResources() {
   VkExtent2D swapChainExtent = getSwapChainExtent();
 
   depthImages.resize(imageCount());
-  depthImageMemorys.resize(imageCount());
+  depthImageAllocations.resize(imageCount());
   depthImageViews.resize(imageCount());
 
   for (int i = 0; i < depthImages.size(); i++) {
@@ -323,7 +333,7 @@ void SwapChain::createDepthResources() {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageAllocations[i]);
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
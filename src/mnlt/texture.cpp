@@ -50,7 +50,7 @@ Texture::Texture(Device &device, VkFormat format, VkExtent3D extent,
   imageInfo.usage = usage;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                             mTextureImage, mTextureImageMemory);
+                             mTextureImage, mTextureAllocation);
 
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -104,7 +104,7 @@ Texture::~Texture() {
   vkDestroySampler(mDevice.device(), mTextureSampler, nullptr);
   vkDestroyImageView(mDevice.device(), mTextureImageView, nullptr);
   vkDestroyImage(mDevice.device(), mTextureImage, nullptr);
-  vkFreeMemory(mDevice.device(), mTextureImageMemory, nullptr);
+  mDevice.allocator().free(mTextureAllocation);
 }
 
 std::unique_ptr<Texture> Texture::createTextureFromFile(Device &device, const std::vector<std::string> &filepaths) {
@@ -134,24 +134,6 @@ void Texture::createTextureImage(const std::vector<std::string> &filepaths) {
         }
     }
     mLayerCount = static_cast<uint32_t>(filepaths.size());
-    VkDeviceSize imageSize = layerSize * filepaths.size(); // Total size for all layers
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    mDevice.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                         stagingBuffer, stagingBufferMemory);
-
-    char* data;
-    vkMapMemory(mDevice.device(), stagingBufferMemory, 0, imageSize, 0, (void**)&data);
-    for (size_t i = 0; i < filepaths.size(); ++i) {
-        memcpy(data + (layerSize * i), pixelsArray[i], static_cast<size_t>(layerSize));
-    }
-    vkUnmapMemory(mDevice.device(), stagingBufferMemory);
-
-    for (auto pixels : pixelsArray) {
-        stbi_image_free(pixels);
-    }
 
     mFormat = VK_FORMAT_R8G8B8A8_SRGB;
     mExtent = {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1};
@@ -172,20 +154,16 @@ void Texture::createTextureImage(const std::vector<std::string> &filepaths) {
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     mDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                mTextureImage, mTextureImageMemory);
-
-    mDevice.transitionImageLayout(mTextureImage, mFormat, VK_IMAGE_LAYOUT_UNDEFINED,
-                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, mLayerCount);
-    mDevice.copyBufferToImage(stagingBuffer, mTextureImage, static_cast<uint32_t>(texWidth),
-                              static_cast<uint32_t>(texHeight), mLayerCount);
+                                mTextureImage, mTextureAllocation);
 
-    mDevice.transitionImageLayout(mTextureImage, mFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, mLayerCount);
+    // the upload leaves the image in shader read only layout
+    std::vector<const void*> layers(pixelsArray.begin(), pixelsArray.end());
+    mUploadTicket = mDevice.uploads().uploadImage(mTextureImage, layers, layerSize, mExtent);
+    for (auto pixels : pixelsArray) {
+        stbi_image_free(pixels);
+    }
 
     mTextureLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-    vkDestroyBuffer(mDevice.device(), stagingBuffer, nullptr);
-    vkFreeMemory(mDevice.device(), stagingBufferMemory, nullptr);
 }
 
 void Texture::createTextureImageView(VkImageViewType viewType) {
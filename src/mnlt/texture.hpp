@@ -28,6 +28,9 @@ namespace mnlt
             VkImageLayout getImageLayout() const { return mTextureLayout; }
             VkExtent3D getExtent() const { return mExtent; }
             VkFormat getFormat() const { return mFormat; }
+            // complete once the pixels have reached the gpu, see UploadManager::isComplete
+            uint64_t getUploadTicket() const { return mUploadTicket; }
+            VkDeviceSize getMemorySize() const { return mTextureAllocation.requestedSize; }
 
             void updateDescriptor();
             void transitionLayout(
@@ -45,7 +48,7 @@ namespace mnlt
 
             Device &mDevice;
             VkImage mTextureImage = nullptr;
-            VkDeviceMemory mTextureImageMemory = nullptr;
+            Allocation mTextureAllocation{};
             VkImageView mTextureImageView = nullptr;
             VkSampler mTextureSampler = nullptr;
             VkFormat mFormat;
@@ -53,5 +56,6 @@ namespace mnlt
             uint32_t mMipLevels{1};
             uint32_t mLayerCount{1};
             VkExtent3D mExtent{};
+            uint64_t mUploadTicket{0};
     };
 }
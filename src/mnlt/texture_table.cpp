@@ -0,0 +1,96 @@
+#include "texture_table.hpp"
+
+#include "swap_chain.hpp"
+
+// std
+#include <stdexcept>
+
+namespace mnlt
+{
+    TextureTable::TextureTable(Device& device) : device{device}
+    {
+        // partially bound, so the slots past the last registered texture never need a descriptor
+        setLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_TEXTURES)
+            .setBindingFlags(0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+            .build();
+
+        pool = DescriptorPool::Builder(device)
+            .setMaxSets(1)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+            .build();
+
+        if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet))
+        {
+            throw std::runtime_error("failed to allocate texture table descriptor set!");
+        }
+    }
+
+    uint32_t TextureTable::getIndex(const std::shared_ptr<Texture>& texture)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = indices.find(texture.get());
+        if (it != indices.end()) return it->second;
+
+        uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else if (textures.size() < MAX_TEXTURES)
+        {
+            index = static_cast<uint32_t>(textures.size());
+            textures.emplace_back();
+        }
+        else
+        {
+            throw std::runtime_error("texture table is full!");
+        }
+
+        auto imageInfo = texture->getImageInfo();
+        DescriptorWriter(*setLayout, *pool)
+            .writeImage(0, index, &imageInfo)
+            .overwrite(descriptorSet);
+
+        textures[index] = texture;
+        indices.emplace(texture.get(), index);
+        return index;
+    }
+
+    bool TextureTable::isRegistered(const Texture* texture)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return indices.count(texture) > 0;
+    }
+
+    void TextureTable::release(const Texture* texture)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = indices.find(texture);
+        if (it == indices.end()) return;
+
+        // the descriptor stays as it is, the draws still in flight may sample it
+        textures[it->second].reset();
+        releasedSlots.emplace_back(frame, it->second);
+        indices.erase(it);
+    }
+
+    void TextureTable::update()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        frame++;
+        while (!releasedSlots.empty() && releasedSlots.front().first + SwapChain::MAX_FRAMES_IN_FLIGHT < frame)
+        {
+            freeSlots.push_back(releasedSlots.front().second);
+            releasedSlots.pop_front();
+        }
+    }
+
+    uint32_t TextureTable::getTextureCount()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return static_cast<uint32_t>(indices.size());
+    }
+}
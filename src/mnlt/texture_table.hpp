@@ -0,0 +1,63 @@
+#pragma once
+
+#include "descriptors.hpp"
+#include "device.hpp"
+#include "texture.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mnlt
+{
+    // One descriptor set holding every texture that has been drawn with, as an array of samplers that
+    // shaders index with a per instance texture index. Binding it once lets a single draw mix textures.
+    //
+    // Slots are written with update after bind, so textures can be added while earlier frames that
+    // bound the set are still in flight. A registered texture is kept alive by the table until it is
+    // released, its slot is only handed out again once the frames that may still sample it are done.
+    //
+    // Thread safe, the asset cache releases textures from its loader threads.
+    class TextureTable
+    {
+        public:
+            static constexpr uint32_t MAX_TEXTURES = 1024;
+
+            TextureTable(Device &device);
+
+            TextureTable(const TextureTable &) = delete;
+            TextureTable &operator=(const TextureTable &) = delete;
+
+            // slot of the texture, registering it on first use
+            uint32_t getIndex(const std::shared_ptr<Texture> &texture);
+            bool isRegistered(const Texture *texture);
+            // drops the table's reference, nothing may draw with the texture anymore
+            void release(const Texture *texture);
+            // makes slots released long enough ago reusable, once per frame on the main thread
+            void update();
+
+            VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+            VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+            uint32_t getTextureCount();
+
+        private:
+            Device &device;
+            std::unique_ptr<DescriptorSetLayout> setLayout;
+            std::unique_ptr<DescriptorPool> pool;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+            std::mutex mutex;
+            // indexed by slot, empty for free slots
+            std::vector<std::shared_ptr<Texture>> textures;
+            std::unordered_map<const Texture *, uint32_t> indices;
+            std::vector<uint32_t> freeSlots;
+            // released slots and the frame they were released in
+            std::deque<std::pair<uint64_t, uint32_t>> releasedSlots;
+            uint64_t frame = 0;
+    };
+}
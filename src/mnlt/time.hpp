@@ -41,4 +41,41 @@ namespace mnlt
             double pureDeltaTime;
             double fixedDeltaTime;
     };
+
+    // Turns variable frame times into a whole number of fixed steps of Time::getFixedDeltaTime().
+    // Time is handed to update() by value, so the leftover time carried between frames lives here.
+    // Frames are counted in unscaled time so steps keep a steady rate at any time scale, the time
+    // scale instead stretches how much simulated time one step covers.
+    class FixedTimestep
+    {
+        public:
+            // adds this frame's time and returns how many fixed steps are due
+            int advance(const Time &time) {
+                accumulator += time.getPureDeltaTime();
+                int steps = static_cast<int>(accumulator / time.getFixedDeltaTime());
+                accumulator -= steps * time.getFixedDeltaTime();
+
+                // a long hitch would otherwise queue up more steps than a frame can run,
+                // making the next frame even slower, so the backlog is dropped instead
+                if (steps > maxStepsPerFrame) {
+                    steps = maxStepsPerFrame;
+                }
+                return steps;
+            }
+
+            // simulated time covered by one fixed step
+            double getStepTime(const Time &time) const {
+                return time.getFixedDeltaTime() * time.timeScale;
+            }
+
+            // fraction of a step that is still waiting in the accumulator, for interpolation
+            double getAlpha(const Time &time) const {
+                return accumulator / time.getFixedDeltaTime();
+            }
+
+            int maxStepsPerFrame = 4;
+
+        private:
+            double accumulator = 0.0;
+    };
 }
\ No newline at end of file
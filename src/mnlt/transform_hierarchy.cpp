@@ -0,0 +1,281 @@
+#include "transform_hierarchy.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace mnlt
+{
+    // the floats of a TransformComponent, one per array of TransformArrays
+    static constexpr size_t TRANSFORM_FLOATS = sizeof(TransformArrays) / sizeof(const float *);
+
+    static bool sameTransform(const TransformComponent &a, const TransformComponent &b)
+    {
+        return a.translation == b.translation && a.rotation == b.rotation && a.scale == b.scale;
+    }
+
+    glm::mat4 TransformComponent::mat4() const
+    {
+        const glm::mat3 r = glm::mat3_cast(rotation);
+        return glm::mat4
+        {
+            glm::vec4(r[0] * scale.x, 0.0f),
+            glm::vec4(r[1] * scale.y, 0.0f),
+            glm::vec4(r[2] * scale.z, 0.0f),
+            glm::vec4(translation, 1.0f)
+        };
+    }
+
+    glm::mat3 TransformComponent::normalMatrix() const
+    {
+        const glm::mat3 r = glm::mat3_cast(rotation);
+        const glm::vec3 invScale = 1.0f / scale;
+        return glm::mat3{r[0] * invScale.x, r[1] * invScale.y, r[2] * invScale.z};
+    }
+
+    void TransformComponent::setEulerAngles(const glm::vec3 &angles)
+    {
+        rotation = glm::angleAxis(angles.y, glm::vec3{0.f, 1.f, 0.f})
+            * glm::angleAxis(angles.x, glm::vec3{1.f, 0.f, 0.f})
+            * glm::angleAxis(angles.z, glm::vec3{0.f, 0.f, 1.f});
+    }
+
+    glm::vec3 TransformComponent::getEulerAngles() const
+    {
+        // the third column is (c2 * s1, -s2, c1 * c2) and the second row (c2 * s3, c2 * c3), see the link
+        const glm::mat3 r = glm::mat3_cast(rotation);
+        return glm::vec3
+        {
+            glm::asin(glm::clamp(-r[2][1], -1.0f, 1.0f)),
+            glm::atan(r[2][0], r[2][2]),
+            glm::atan(r[0][1], r[1][1])
+        };
+    }
+
+    void TransformHierarchy::setParent(Registry &registry, Entity child, Entity parent)
+    {
+        if (!registry.valid(parent))
+        {
+            registry.remove<ParentComponent>(child);
+            structureChanged = true;
+            return;
+        }
+
+        for (Entity ancestor = parent; registry.valid(ancestor);)
+        {
+            if (ancestor == child)
+            {
+                throw std::runtime_error("parenting would create a cycle in the transform hierarchy!");
+            }
+            auto *link = registry.tryGet<ParentComponent>(ancestor);
+            if (link == nullptr) break;
+            ancestor = link->parent;
+        }
+
+        if (auto *link = registry.tryGet<ParentComponent>(child))
+        {
+            link->parent = parent;
+        }
+        else
+        {
+            registry.add<ParentComponent>(child, parent);
+        }
+        structureChanged = true;
+    }
+
+    void TransformHierarchy::rebuildOrder(Registry &registry)
+    {
+        auto &worlds = registry.pool<WorldTransformComponent>();
+        uint32_t capacity = registry.capacity();
+
+        // every entity with a transform, parentSlots holds the index of its parent until the order is built
+        order.clear();
+        parentSlots.clear();
+        registry.each<TransformComponent>([&](Entity entity, TransformComponent &)
+        {
+            if (!worlds.contains(entity.index))
+            {
+                worlds.add(entity.index);
+            }
+            uint32_t parentIndex = NO_PARENT;
+            if (auto *link = registry.tryGet<ParentComponent>(entity))
+            {
+                if (registry.has<TransformComponent>(link->parent)) parentIndex = link->parent.index;
+            }
+            order.push_back(entity);
+            parentSlots.push_back(parentIndex);
+        });
+
+        // counting sort of the children by the index of their parent
+        childStarts.assign(capacity + 1, 0);
+        for (uint32_t parentIndex : parentSlots)
+        {
+            if (parentIndex != NO_PARENT) childStarts[parentIndex + 1]++;
+        }
+        for (uint32_t i = 0; i < capacity; i++)
+        {
+            childStarts[i + 1] += childStarts[i];
+        }
+        children.resize(childStarts[capacity]);
+        std::vector<uint32_t> childCursors(childStarts.begin(), childStarts.end() - 1);
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (parentSlots[i] != NO_PARENT) children[childCursors[parentSlots[i]]++] = order[i];
+        }
+
+        // the roots are the first level, every level after them holds the children of the one before
+        size_t rootCount = 0;
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (parentSlots[i] == NO_PARENT) order[rootCount++] = order[i];
+        }
+        order.resize(rootCount);
+        parentSlots.assign(rootCount, NO_PARENT);
+        levelStarts.assign(1, 0);
+
+        size_t levelEnd = order.size();
+        for (size_t slot = 0; slot < order.size(); slot++)
+        {
+            if (slot == levelEnd)
+            {
+                levelStarts.push_back(slot);
+                levelEnd = order.size();
+            }
+            uint32_t index = order[slot].index;
+            for (uint32_t child = childStarts[index]; child < childStarts[index + 1]; child++)
+            {
+                order.push_back(children[child]);
+                parentSlots.push_back(static_cast<uint32_t>(slot));
+            }
+        }
+        levelStarts.push_back(order.size());
+        worldChanged.assign(order.size(), 0);
+        localChanged.assign(order.size(), 0);
+    }
+
+    void TransformHierarchy::update(Registry &registry)
+    {
+        auto &transforms = registry.pool<TransformComponent>();
+        auto &worlds = registry.pool<WorldTransformComponent>();
+        // entities made outside of GameObjectManager don't mark the structure as changed
+        if (structureChanged || order.size() != transforms.size())
+        {
+            rebuildOrder(registry);
+            structureChanged = false;
+        }
+
+        uint32_t capacity = registry.capacity();
+        if (localCache.size() < capacity)
+        {
+            localCache.resize(capacity);
+        }
+        changedEntities.clear();
+
+        // a level only reads the world matrices of the one above it, so its entities can go in any order
+        for (size_t level = 0; level + 1 < levelStarts.size(); level++)
+        {
+            size_t begin = levelStarts[level];
+            size_t end = levelStarts[level + 1];
+            jobSystem.parallelFor(end - begin, PARALLEL_CHUNK_SIZE, [&](size_t first, size_t last)
+            {
+                updateSlots(transforms, worlds, begin + first, begin + last);
+            });
+        }
+    }
+
+    void TransformHierarchy::updateSlots(
+        const ComponentPool<TransformComponent> &transforms,
+        ComponentPool<WorldTransformComponent> &worlds,
+        size_t begin,
+        size_t end)
+    {
+        std::vector<uint32_t> changed;
+        for (size_t batchBegin = begin; batchBegin < end; batchBegin += COMPOSE_BATCH_SIZE)
+        {
+            size_t batchEnd = std::min(batchBegin + COMPOSE_BATCH_SIZE, end);
+            composeChangedLocals(transforms, batchBegin, batchEnd);
+
+            for (size_t slot = batchBegin; slot < batchEnd; slot++)
+            {
+                Entity entity = order[slot];
+                uint32_t parentSlot = parentSlots[slot];
+                Entity parent = parentSlot == NO_PARENT ? Entity{} : order[parentSlot];
+                auto &cache = localCache[entity.index];
+
+                bool parentChanged = parentSlot != NO_PARENT && worldChanged[parentSlot];
+                if (!localChanged[slot] && !parentChanged && cache.parent == parent)
+                {
+                    worldChanged[slot] = 0;
+                    continue;
+                }
+
+                cache.parent = parent;
+                auto &world = worlds.get(entity.index);
+                if (parentSlot == NO_PARENT)
+                {
+                    world.matrix = cache.matrices.model;
+                    world.normalMatrix = glm::mat3{cache.matrices.normal};
+                }
+                else
+                {
+                    const auto &parentWorld = worlds.get(parent.index);
+                    world.matrix = parentWorld.matrix * cache.matrices.model;
+                    // the inverse transpose of a product is the product of the inverse transposes
+                    world.normalMatrix = parentWorld.normalMatrix * glm::mat3{cache.matrices.normal};
+                }
+                worldChanged[slot] = 1;
+                changed.push_back(entity.index);
+            }
+        }
+
+        if (!changed.empty())
+        {
+            std::lock_guard<std::mutex> lock{changedMutex};
+            changedEntities.insert(changedEntities.end(), changed.begin(), changed.end());
+        }
+    }
+
+    void TransformHierarchy::composeChangedLocals(const ComponentPool<TransformComponent> &transforms, size_t begin, size_t end)
+    {
+        // the changed transforms of the batch in structure-of-arrays form, and the slots they belong to
+        float arrays[TRANSFORM_FLOATS][COMPOSE_BATCH_SIZE];
+        uint32_t changedSlots[COMPOSE_BATCH_SIZE];
+        size_t count = 0;
+
+        for (size_t slot = begin; slot < end; slot++)
+        {
+            Entity entity = order[slot];
+            const auto &transform = transforms.get(entity.index);
+            auto &cache = localCache[entity.index];
+
+            // a reused entity index never matches the cache of the entity it belonged to before
+            bool changed = cache.generation != entity.generation || !sameTransform(cache.transform, transform);
+            localChanged[slot] = changed;
+            if (!changed) continue;
+
+            cache.transform = transform;
+            cache.generation = entity.generation;
+            const float values[TRANSFORM_FLOATS] = {
+                transform.translation.x, transform.translation.y, transform.translation.z,
+                transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+                transform.scale.x, transform.scale.y, transform.scale.z};
+            for (size_t array = 0; array < TRANSFORM_FLOATS; array++)
+            {
+                arrays[array][count] = values[array];
+            }
+            changedSlots[count++] = static_cast<uint32_t>(slot);
+        }
+        if (count == 0) return;
+
+        TransformMatrices matrices[COMPOSE_BATCH_SIZE];
+        TransformArrays batch{
+            arrays[0], arrays[1], arrays[2],
+            arrays[3], arrays[4], arrays[5], arrays[6],
+            arrays[7], arrays[8], arrays[9]};
+        composeTransforms(batch, count, matrices, sizeof(TransformMatrices));
+        for (size_t i = 0; i < count; i++)
+        {
+            localCache[order[changedSlots[i]].index].matrices = matrices[i];
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ecs.hpp"
+#include "job_system.hpp"
+#include "transform_kernels.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mnlt
+{
+    // relative to the parent, or to the world for an object without one
+    struct TransformComponent
+    {
+        glm::vec3 translation{};
+        glm::vec3 scale{1.0f, 1.0f, 1.0f};
+        glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+
+        // Matrix corresponds to Translate * Rotate * Scale
+        glm::mat4 mat4() const;
+        glm::mat3 normalMatrix() const;
+
+        // Tait-bryan angles of Y(1), X(2), Z(3), the order rotations used to be given in
+        // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+        void setEulerAngles(const glm::vec3 &angles);
+        glm::vec3 getEulerAngles() const;
+    };
+    // an object whose parent is destroyed becomes a root
+    struct ParentComponent
+    {
+        Entity parent{};
+    };
+    // the transform of the object and all its ancestors combined, written by TransformHierarchy::update
+    struct WorldTransformComponent
+    {
+        glm::mat4 matrix{1.f};
+        glm::mat3 normalMatrix{1.f};
+    };
+
+    // Computes the world matrices of every entity with a TransformComponent. Entities are kept in
+    // breadth first order, so every parent comes before its children and siblings sit next to each other,
+    // and each level is split across the job system once it's wide enough. Local matrices are cached
+    // and recomputed only when the transform changed, a batch at a time with composeTransforms, world
+    // matrices only when the local matrix or the parent's world matrix did, so an unchanged subtree costs
+    // one comparison per entity.
+    class TransformHierarchy
+    {
+        public:
+            // levels narrower than this run on the calling thread
+            static constexpr size_t PARALLEL_CHUNK_SIZE = 1024;
+            // slots whose changed transforms go through composeTransforms together
+            static constexpr size_t COMPOSE_BATCH_SIZE = 64;
+
+            explicit TransformHierarchy(JobSystem &jobSystem) : jobSystem{jobSystem} {}
+
+            TransformHierarchy(const TransformHierarchy &) = delete;
+            TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+            // throws if parent is child or one of its descendants, an invalid parent makes child a root
+            void setParent(Registry &registry, Entity child, Entity parent);
+            // entities were created, destroyed or reparented, the order is rebuilt on the next update
+            void markStructureChanged() { structureChanged = true; }
+
+            void update(Registry &registry);
+
+            // the entity indices whose world matrices changed on the last update, in no particular order
+            const std::vector<uint32_t> &getChangedEntities() const { return changedEntities; }
+
+        private:
+            static constexpr uint32_t NO_PARENT = Entity::NULL_INDEX;
+
+            // the transform an entity index's local matrices were last computed from
+            struct LocalCache
+            {
+                TransformComponent transform{};
+                uint32_t generation = Entity::NULL_INDEX;
+                TransformMatrices matrices{};
+                // the parent the world matrices were last computed under
+                Entity parent{};
+            };
+
+            void rebuildOrder(Registry &registry);
+            void updateSlots(
+                const ComponentPool<TransformComponent> &transforms,
+                ComponentPool<WorldTransformComponent> &worlds,
+                size_t begin,
+                size_t end);
+            // refreshes the cached local matrices of the slots whose transform changed and flags them
+            void composeChangedLocals(const ComponentPool<TransformComponent> &transforms, size_t begin, size_t end);
+
+            JobSystem &jobSystem;
+            bool structureChanged = true;
+
+            // breadth first, the slot of each entity's parent in it and where every level starts, with
+            // one past the last level at the end
+            std::vector<Entity> order;
+            std::vector<uint32_t> parentSlots;
+            std::vector<size_t> levelStarts;
+            // per slot, set when the world matrices changed this update and when the local ones did
+            std::vector<uint8_t> worldChanged;
+            std::vector<uint8_t> localChanged;
+
+            // per entity index
+            std::vector<LocalCache> localCache;
+            // every chunk appends the entities it changed once it's done
+            std::mutex changedMutex;
+            std::vector<uint32_t> changedEntities;
+
+            // scratch for rebuildOrder, the children of every entity index grouped by parent
+            std::vector<uint32_t> childStarts;
+            std::vector<Entity> children;
+    };
+}
@@ -0,0 +1,237 @@
+#include "transform_kernels.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace mnlt
+{
+    namespace
+    {
+        constexpr size_t LANES = 8;
+        constexpr size_t MODEL_OFFSET = offsetof(TransformMatrices, model);
+        constexpr size_t NORMAL_OFFSET = offsetof(TransformMatrices, normal);
+        constexpr size_t COLUMN_SIZE = sizeof(glm::vec4);
+
+        // the rotation matrix every path computes, in the same order as glm::mat3_cast so the results
+        // match bit for bit
+        void composeScalar(const TransformArrays &t, size_t count, char *output, size_t stride)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                float x = t.rotationX[i], y = t.rotationY[i], z = t.rotationZ[i], w = t.rotationW[i];
+                float xx = x * x, yy = y * y, zz = z * z;
+                float xy = x * y, xz = x * z, yz = y * z;
+                float wx = w * x, wy = w * y, wz = w * z;
+                glm::vec3 r0{1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy)};
+                glm::vec3 r1{2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx)};
+                glm::vec3 r2{2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy)};
+
+                TransformMatrices matrices{};
+                matrices.model[0] = glm::vec4{r0 * t.scaleX[i], 0.0f};
+                matrices.model[1] = glm::vec4{r1 * t.scaleY[i], 0.0f};
+                matrices.model[2] = glm::vec4{r2 * t.scaleZ[i], 0.0f};
+                matrices.model[3] = glm::vec4{t.translationX[i], t.translationY[i], t.translationZ[i], 1.0f};
+                matrices.normal[0] = glm::vec4{r0 * (1.0f / t.scaleX[i]), 0.0f};
+                matrices.normal[1] = glm::vec4{r1 * (1.0f / t.scaleY[i]), 0.0f};
+                matrices.normal[2] = glm::vec4{r2 * (1.0f / t.scaleZ[i]), 0.0f};
+                std::memcpy(output + i * stride, &matrices, sizeof(matrices));
+            }
+        }
+
+#ifdef MNLT_X86
+        // the last count % 8 transforms copied into a full block, the padding lanes are never stored
+        struct TailBlock
+        {
+            static constexpr size_t ARRAY_COUNT = sizeof(TransformArrays) / sizeof(const float *);
+            static constexpr size_t FIRST_SCALE_ARRAY = 7;
+
+            // padding lanes get a unit scale so they don't divide by zero
+            alignas(32) float values[ARRAY_COUNT][LANES] = {};
+            TransformArrays arrays{};
+
+            TailBlock(const TransformArrays &t, size_t first, size_t count)
+            {
+                const float *sources[ARRAY_COUNT] = {
+                    t.translationX, t.translationY, t.translationZ,
+                    t.rotationX, t.rotationY, t.rotationZ, t.rotationW,
+                    t.scaleX, t.scaleY, t.scaleZ};
+                for (size_t array = 0; array < ARRAY_COUNT; array++)
+                {
+                    float padding = array >= FIRST_SCALE_ARRAY ? 1.0f : 0.0f;
+                    for (size_t k = 0; k < LANES; k++)
+                    {
+                        values[array][k] = first + k < count ? sources[array][first + k] : padding;
+                    }
+                }
+                arrays = {
+                    values[0], values[1], values[2],
+                    values[3], values[4], values[5], values[6],
+                    values[7], values[8], values[9]};
+            }
+        };
+
+        // c0 to c3 hold the components of one column for 4 transforms, stored as that column of each
+        MNLT_TARGET_SSE2
+        void storeColumns(__m128 c0, __m128 c1, __m128 c2, __m128 c3, size_t lanes, char *output, size_t stride, size_t offset)
+        {
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            const __m128 columns[4] = {c0, c1, c2, c3};
+            for (size_t k = 0; k < lanes; k++)
+            {
+                _mm_storeu_ps(reinterpret_cast<float *>(output + k * stride + offset), columns[k]);
+            }
+        }
+
+        MNLT_TARGET_SSE2
+        void composeHalfSse(const TransformArrays &t, size_t first, size_t lanes, char *output, size_t stride)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 two = _mm_set1_ps(2.0f);
+            __m128 x = _mm_loadu_ps(t.rotationX + first);
+            __m128 y = _mm_loadu_ps(t.rotationY + first);
+            __m128 z = _mm_loadu_ps(t.rotationZ + first);
+            __m128 w = _mm_loadu_ps(t.rotationW + first);
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+            __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+            __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+            __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+            __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+            __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+            __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+            __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+            __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+            __m128 scaleX = _mm_loadu_ps(t.scaleX + first);
+            __m128 scaleY = _mm_loadu_ps(t.scaleY + first);
+            __m128 scaleZ = _mm_loadu_ps(t.scaleZ + first);
+            __m128 inverseX = _mm_div_ps(one, scaleX);
+            __m128 inverseY = _mm_div_ps(one, scaleY);
+            __m128 inverseZ = _mm_div_ps(one, scaleZ);
+
+            size_t model = MODEL_OFFSET, normal = NORMAL_OFFSET;
+            storeColumns(_mm_mul_ps(r00, scaleX), _mm_mul_ps(r01, scaleX), _mm_mul_ps(r02, scaleX), zero, lanes, output, stride, model);
+            storeColumns(_mm_mul_ps(r10, scaleY), _mm_mul_ps(r11, scaleY), _mm_mul_ps(r12, scaleY), zero, lanes, output, stride, model + COLUMN_SIZE);
+            storeColumns(_mm_mul_ps(r20, scaleZ), _mm_mul_ps(r21, scaleZ), _mm_mul_ps(r22, scaleZ), zero, lanes, output, stride, model + 2 * COLUMN_SIZE);
+            storeColumns(
+                _mm_loadu_ps(t.translationX + first), _mm_loadu_ps(t.translationY + first), _mm_loadu_ps(t.translationZ + first), one,
+                lanes, output, stride, model + 3 * COLUMN_SIZE);
+            storeColumns(_mm_mul_ps(r00, inverseX), _mm_mul_ps(r01, inverseX), _mm_mul_ps(r02, inverseX), zero, lanes, output, stride, normal);
+            storeColumns(_mm_mul_ps(r10, inverseY), _mm_mul_ps(r11, inverseY), _mm_mul_ps(r12, inverseY), zero, lanes, output, stride, normal + COLUMN_SIZE);
+            storeColumns(_mm_mul_ps(r20, inverseZ), _mm_mul_ps(r21, inverseZ), _mm_mul_ps(r22, inverseZ), zero, lanes, output, stride, normal + 2 * COLUMN_SIZE);
+            storeColumns(zero, zero, zero, one, lanes, output, stride, normal + 3 * COLUMN_SIZE);
+        }
+
+        MNLT_TARGET_SSE2
+        void composeSse(const TransformArrays &t, size_t count, char *output, size_t stride)
+        {
+            size_t blockEnd = count - count % LANES;
+            for (size_t i = 0; i < blockEnd; i += LANES)
+            {
+                composeHalfSse(t, i, 4, output + i * stride, stride);
+                composeHalfSse(t, i + 4, 4, output + (i + 4) * stride, stride);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{t, blockEnd, count};
+                size_t lanes = count - blockEnd;
+                composeHalfSse(tail.arrays, 0, std::min<size_t>(lanes, 4), output + blockEnd * stride, stride);
+                if (lanes > 4)
+                {
+                    composeHalfSse(tail.arrays, 4, lanes - 4, output + (blockEnd + 4) * stride, stride);
+                }
+            }
+        }
+
+        // the 8 lane version of storeColumns, through its two halves
+        MNLT_TARGET_AVX2
+        void storeColumns(__m256 c0, __m256 c1, __m256 c2, __m256 c3, size_t lanes, char *output, size_t stride, size_t offset)
+        {
+            storeColumns(
+                _mm256_castps256_ps128(c0), _mm256_castps256_ps128(c1), _mm256_castps256_ps128(c2), _mm256_castps256_ps128(c3),
+                std::min<size_t>(lanes, 4), output, stride, offset);
+            if (lanes > 4)
+            {
+                storeColumns(
+                    _mm256_extractf128_ps(c0, 1), _mm256_extractf128_ps(c1, 1), _mm256_extractf128_ps(c2, 1), _mm256_extractf128_ps(c3, 1),
+                    lanes - 4, output + 4 * stride, stride, offset);
+            }
+        }
+
+        MNLT_TARGET_AVX2
+        void composeBlockAvx(const TransformArrays &t, size_t first, size_t lanes, char *output, size_t stride)
+        {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            __m256 x = _mm256_loadu_ps(t.rotationX + first);
+            __m256 y = _mm256_loadu_ps(t.rotationY + first);
+            __m256 z = _mm256_loadu_ps(t.rotationZ + first);
+            __m256 w = _mm256_loadu_ps(t.rotationW + first);
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            __m256 r00 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz)));
+            __m256 r01 = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+            __m256 r02 = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+            __m256 r10 = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+            __m256 r11 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz)));
+            __m256 r12 = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+            __m256 r20 = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+            __m256 r21 = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+            __m256 r22 = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy)));
+
+            __m256 scaleX = _mm256_loadu_ps(t.scaleX + first);
+            __m256 scaleY = _mm256_loadu_ps(t.scaleY + first);
+            __m256 scaleZ = _mm256_loadu_ps(t.scaleZ + first);
+            __m256 inverseX = _mm256_div_ps(one, scaleX);
+            __m256 inverseY = _mm256_div_ps(one, scaleY);
+            __m256 inverseZ = _mm256_div_ps(one, scaleZ);
+
+            size_t model = MODEL_OFFSET, normal = NORMAL_OFFSET;
+            storeColumns(_mm256_mul_ps(r00, scaleX), _mm256_mul_ps(r01, scaleX), _mm256_mul_ps(r02, scaleX), zero, lanes, output, stride, model);
+            storeColumns(_mm256_mul_ps(r10, scaleY), _mm256_mul_ps(r11, scaleY), _mm256_mul_ps(r12, scaleY), zero, lanes, output, stride, model + COLUMN_SIZE);
+            storeColumns(_mm256_mul_ps(r20, scaleZ), _mm256_mul_ps(r21, scaleZ), _mm256_mul_ps(r22, scaleZ), zero, lanes, output, stride, model + 2 * COLUMN_SIZE);
+            storeColumns(
+                _mm256_loadu_ps(t.translationX + first), _mm256_loadu_ps(t.translationY + first), _mm256_loadu_ps(t.translationZ + first), one,
+                lanes, output, stride, model + 3 * COLUMN_SIZE);
+            storeColumns(_mm256_mul_ps(r00, inverseX), _mm256_mul_ps(r01, inverseX), _mm256_mul_ps(r02, inverseX), zero, lanes, output, stride, normal);
+            storeColumns(_mm256_mul_ps(r10, inverseY), _mm256_mul_ps(r11, inverseY), _mm256_mul_ps(r12, inverseY), zero, lanes, output, stride, normal + COLUMN_SIZE);
+            storeColumns(_mm256_mul_ps(r20, inverseZ), _mm256_mul_ps(r21, inverseZ), _mm256_mul_ps(r22, inverseZ), zero, lanes, output, stride, normal + 2 * COLUMN_SIZE);
+            storeColumns(zero, zero, zero, one, lanes, output, stride, normal + 3 * COLUMN_SIZE);
+        }
+
+        MNLT_TARGET_AVX2
+        void composeAvx(const TransformArrays &t, size_t count, char *output, size_t stride)
+        {
+            size_t blockEnd = count - count % LANES;
+            for (size_t i = 0; i < blockEnd; i += LANES)
+            {
+                composeBlockAvx(t, i, LANES, output + i * stride, stride);
+            }
+            if (blockEnd < count)
+            {
+                TailBlock tail{t, blockEnd, count};
+                composeBlockAvx(tail.arrays, 0, count - blockEnd, output + blockEnd * stride, stride);
+            }
+        }
+#endif
+    }
+
+    void composeTransforms(const TransformArrays &transforms, size_t count, void *output, size_t stride, SimdLevel level)
+    {
+        char *bytes = static_cast<char *>(output);
+        if (level > bestSimdLevel()) level = bestSimdLevel();
+#ifdef MNLT_X86
+        if (level == SimdLevel::AVX2) return composeAvx(transforms, count, bytes, stride);
+        if (level == SimdLevel::SSE2) return composeSse(transforms, count, bytes, stride);
+#endif
+        composeScalar(transforms, count, bytes, stride);
+    }
+}
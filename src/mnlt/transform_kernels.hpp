@@ -0,0 +1,46 @@
+#pragma once
+
+#include "simd.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+
+namespace mnlt
+{
+    // what composeTransforms writes for every transform, laid out like GameObjectBufferData
+    struct TransformMatrices
+    {
+        // Translate * Rotate * Scale
+        glm::mat4 model{1.f};
+        // the inverse transpose of the model's upper 3x3, in the upper 3x3 of an identity
+        glm::mat4 normal{1.f};
+    };
+
+    // transforms in structure-of-arrays form, rotations as unit quaternions
+    struct TransformArrays
+    {
+        const float *translationX;
+        const float *translationY;
+        const float *translationZ;
+        const float *rotationX;
+        const float *rotationY;
+        const float *rotationZ;
+        const float *rotationW;
+        const float *scaleX;
+        const float *scaleY;
+        const float *scaleZ;
+    };
+
+    // Writes the TransformMatrices of count transforms to output, stride bytes apart so padded slots of
+    // a mapped buffer can be filled in place. 4 transforms at a time with SSE2 and 8 with AVX2, every
+    // level gives the same results as the scalar path and as TransformComponent::mat4 and normalMatrix
+    // as long as neither is built with fma contraction, tools/transform_check.cpp compares them.
+    // Levels above bestSimdLevel() fall back to the best supported one.
+    void composeTransforms(
+        const TransformArrays &transforms, size_t count, void *output, size_t stride, SimdLevel level = bestSimdLevel());
+}
@@ -80,25 +80,32 @@ namespace mnlt
         ImGui_ImplVulkan_RenderDrawData(drawdata, commandBuffer);
     }
 
-    void UI::showGameObjectWindow(GameObject *gameObject)
+    void UI::showGameObjectWindow(GameObject gameObject)
     {
         ImGui::Begin("Properties");
-        if(gameObject->ui.showPropertyWindow)
+        if(gameObject.ui().showPropertyWindow)
         {
-            ImGui::Text("%s", gameObject->name.c_str());
+            ImGui::Text("%s", gameObject.name().c_str());
             ImGui::Text("Transform Component");
-            ImGui::DragFloat3("Translation", &gameObject->transform.translation[0], 0.1f);
-            ImGui::DragFloat3("Rotation", &gameObject->transform.rotation[0], 0.1f);
-            ImGui::DragFloat3("Scale", &gameObject->transform.scale[0], 0.1f);
-            ImGui::Text("Rigidbody Component");
-            ImGui::DragFloat3("Velocity", &gameObject->rigidBody.velocity[0], 0.1f);
-            ImGui::DragFloat("Mass", &gameObject->rigidBody.mass, 0.1f);
+            ImGui::DragFloat3("Translation", &gameObject.transform().translation[0], 0.1f);
+            glm::vec3 eulerAngles = gameObject.transform().getEulerAngles();
+            if(ImGui::DragFloat3("Rotation", &eulerAngles[0], 0.1f))
+            {
+                gameObject.transform().setEulerAngles(eulerAngles);
+            }
+            ImGui::DragFloat3("Scale", &gameObject.transform().scale[0], 0.1f);
+            if(auto* rigidBody = gameObject.tryGet<RigidBodyComponent>())
+            {
+                ImGui::Text("Rigidbody Component");
+                ImGui::DragFloat3("Velocity", &rigidBody->velocity[0], 0.1f);
+                ImGui::DragFloat("Mass", &rigidBody->mass, 0.1f);
+            }
             ImGui::Text("Color Component");
-            ImGui::ColorEdit3("Color", &gameObject->color[0]);
-            if(gameObject->pointLight != nullptr)
+            ImGui::ColorEdit3("Color", &gameObject.color()[0]);
+            if(auto* pointLight = gameObject.tryGet<PointLightComponent>())
             {
                 ImGui::Text("Pointlight Component");
-                ImGui::DragFloat("Intensity", &gameObject->pointLight->lightIntensity, 0.1f);
+                ImGui::DragFloat("Intensity", &pointLight->lightIntensity, 0.1f);
             }
         }
         ImGui::End();
@@ -154,29 +161,42 @@ namespace mnlt
                     ImGui::DragFloat3("Rotation", &frameInfo.camera.viewerObject.rotation[0], 0.1f);
                     ImGui::EndMenu();
                 }
+                // Memory Tab
+                if (ImGui::BeginMenu("Memory"))
+                {
+                    MemoryStats stats = device.allocator().getStats();
+                    const float mib = 1024.f * 1024.f;
+                    ImGui::Text("Allocations: %u", stats.allocationCount);
+                    ImGui::Text("Blocks: %u, Dedicated: %u", stats.blockCount, stats.dedicatedCount);
+                    ImGui::Text("Reserved: %.2f MiB", stats.reservedBytes / mib);
+                    ImGui::Text("Used: %.2f MiB", stats.usedBytes / mib);
+                    ImGui::Text("Internal Fragmentation: %.2f MiB", stats.internalFragmentation / mib);
+                    ImGui::Text("External Fragmentation: %.2f MiB", stats.externalFragmentation / mib);
+                    ImGui::EndMenu();
+                }
                 ImGui::EndMenuBar();
             }
             
             static std::string selectedGameObjectName;
             ImGui::Begin("Scene");
             ImGui::Text("GameObjects:");
-            for (auto& obj : frameInfo.gameObjects) {
+            frameInfo.registry.each<NameComponent, UIComponent>([&](Entity entity, NameComponent& name, UIComponent& ui) {
                 // Highlight the selectable if it's the selected GameObject
-                bool isSelected = (obj.second.name == selectedGameObjectName);
+                bool isSelected = (name.name == selectedGameObjectName);
 
-                if (ImGui::Selectable(obj.second.name.c_str(), isSelected)) {
+                if (ImGui::Selectable(name.name.c_str(), isSelected)) {
                     // Update the selected GameObject name
-                    selectedGameObjectName = obj.second.name;
+                    selectedGameObjectName = name.name;
                 }
                 
                 // Open the property window for the selected GameObject
                 if (isSelected) {
-                    obj.second.ui.showPropertyWindow = true;
-                    showGameObjectWindow(&obj.second);
+                    ui.showPropertyWindow = true;
+                    showGameObjectWindow(GameObject{entity, frameInfo.registry});
                 } else {
-                    obj.second.ui.showPropertyWindow = false;
+                    ui.showPropertyWindow = false;
                 }
-            }
+            });
             ImGui::End();
         }
 
@@ -30,7 +30,7 @@ namespace mnlt
             void runExample(FrameInfo frameInfo);
 
         private:
-            void showGameObjectWindow(GameObject *gameObject);
+            void showGameObjectWindow(GameObject gameObject);
             Device &device;
             Window &window;
     };
@@ -0,0 +1,345 @@
+#include "upload_manager.hpp"
+
+#include "device.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace mnlt
+{
+    namespace
+    {
+        // a multiple of every texel size, which buffer to image copies need their source offset to be
+        constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+    }
+
+    UploadManager::UploadManager(Device &device) : device{device}
+    {
+        transferFamily = device.getTransferQueueFamily();
+        graphicsFamily = device.getGraphicsQueueFamily();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &timelineSemaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload timeline semaphore!");
+        }
+
+        device.createBuffer(
+            STAGING_RING_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ring.buffer,
+            ring.allocation);
+    }
+
+    UploadManager::~UploadManager()
+    {
+        waitIdle();
+
+        if (open.commandBuffer)
+        {
+            vkEndCommandBuffer(open.commandBuffer);
+            inFlight.push_back(std::move(open));
+            inFlight.back().value = 0;
+        }
+        reclaim(UINT64_MAX);
+
+        vkDestroyBuffer(device.device(), ring.buffer, nullptr);
+        device.allocator().free(ring.allocation);
+        vkDestroySemaphore(device.device(), timelineSemaphore, nullptr);
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);
+    }
+
+    uint64_t UploadManager::uploadBuffer(VkBuffer buffer, const void *data, VkDeviceSize size, VkDeviceSize bufferOffset)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        VkDeviceSize stagingOffset;
+        VkBuffer stagingBuffer = stage({data}, size, stagingOffset);
+        VkCommandBuffer commandBuffer = openBatch();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = bufferOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffer, 1, &copyRegion);
+
+        if (ownershipTransfer())
+        {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.buffer = buffer;
+            barrier.offset = bufferOffset;
+            barrier.size = size;
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            bufferAcquires.push_back(barrier);
+        }
+
+        return submittedValue + 1;
+    }
+
+    uint64_t UploadManager::uploadImage(VkImage image, const std::vector<const void *> &layers, VkDeviceSize layerSize, VkExtent3D extent)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        VkDeviceSize stagingOffset;
+        VkBuffer stagingBuffer = stage(layers, layerSize, stagingOffset);
+        VkCommandBuffer commandBuffer = openBatch();
+        uint32_t layerCount = static_cast<uint32_t>(layers.size());
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = extent;
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // without an ownership transfer the semaphore wait of the frame makes the copy visible,
+        // so the barrier only has to change the layout
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (ownershipTransfer())
+        {
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+        }
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        if (ownershipTransfer())
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            imageAcquires.push_back(barrier);
+        }
+
+        return submittedValue + 1;
+    }
+
+    void UploadManager::submit(VkCommandBuffer commandBuffer)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        reclaim(completedValue());
+
+        if (open.commandBuffer)
+        {
+            vkEndCommandBuffer(open.commandBuffer);
+            open.value = submittedValue + 1;
+            open.ringEnd = ringHead;
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo{};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &open.value;
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &open.commandBuffer;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &timelineSemaphore;
+            if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit upload command buffer!");
+            }
+
+            submittedValue = open.value;
+            inFlight.push_back(std::move(open));
+            open = Batch{};
+        }
+
+        if (!bufferAcquires.empty() || !imageAcquires.empty())
+        {
+            // the source stages chain onto the frame's semaphore wait, which orders the acquires after the releases
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                WAIT_STAGES,
+                WAIT_STAGES,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(bufferAcquires.size()), bufferAcquires.data(),
+                static_cast<uint32_t>(imageAcquires.size()), imageAcquires.data());
+            bufferAcquires.clear();
+            imageAcquires.clear();
+        }
+    }
+
+    bool UploadManager::isComplete(uint64_t ticket)
+    {
+        return completedValue() >= ticket;
+    }
+
+    void UploadManager::waitIdle()
+    {
+        uint64_t value = submittedValue;
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timelineSemaphore;
+        waitInfo.pValues = &value;
+        vkWaitSemaphores(device.device(), &waitInfo, UINT64_MAX);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        reclaim(value);
+    }
+
+    VkBuffer UploadManager::stage(const std::vector<const void *> &chunks, VkDeviceSize chunkSize, VkDeviceSize &offset)
+    {
+        VkDeviceSize size = chunkSize * chunks.size();
+        reclaim(completedValue());
+
+        // never split a copy across the end of the ring, skip to its start instead
+        VkDeviceSize position = (ringHead + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+        if (position % STAGING_RING_SIZE + size > STAGING_RING_SIZE)
+        {
+            position += STAGING_RING_SIZE - position % STAGING_RING_SIZE;
+        }
+
+        char *destination;
+        VkBuffer buffer;
+        if (position + size - ringTail <= STAGING_RING_SIZE)
+        {
+            offset = position % STAGING_RING_SIZE;
+            ringHead = position + size;
+            destination = static_cast<char *>(ring.allocation.mapped) + offset;
+            buffer = ring.buffer;
+        }
+        else
+        {
+            StagingBuffer temporary{};
+            device.createBuffer(
+                size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                temporary.buffer,
+                temporary.allocation);
+            open.temporaryBuffers.push_back(temporary);
+
+            offset = 0;
+            destination = static_cast<char *>(temporary.allocation.mapped);
+            buffer = temporary.buffer;
+        }
+
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            memcpy(destination + chunkSize * i, chunks[i], static_cast<size_t>(chunkSize));
+        }
+        return buffer;
+    }
+
+    VkCommandBuffer UploadManager::openBatch()
+    {
+        if (open.commandBuffer)
+        {
+            return open.commandBuffer;
+        }
+
+        if (freeCommandBuffers.empty())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &open.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+        }
+        else
+        {
+            open.commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(open.commandBuffer, &beginInfo);
+        return open.commandBuffer;
+    }
+
+    void UploadManager::reclaim(uint64_t completedValue)
+    {
+        while (!inFlight.empty() && inFlight.front().value <= completedValue)
+        {
+            Batch &batch = inFlight.front();
+            ringTail = std::max(ringTail, batch.ringEnd);
+            for (auto &temporary : batch.temporaryBuffers)
+            {
+                vkDestroyBuffer(device.device(), temporary.buffer, nullptr);
+                device.allocator().free(temporary.allocation);
+            }
+            freeCommandBuffers.push_back(batch.commandBuffer);
+            inFlight.pop_front();
+        }
+    }
+
+    uint64_t UploadManager::completedValue()
+    {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(device.device(), timelineSemaphore, &value);
+        return value;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "memory_allocator.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace mnlt
+{
+    class Device;
+
+    // Batches buffer and image uploads into one transfer queue submission per frame instead of a
+    // blocking single time command buffer per copy.
+    //
+    // Data is copied into a persistently mapped staging ring right away, so callers can free their
+    // copy as soon as an upload call returns. The copies are recorded into an open batch that the
+    // render loop submits once per frame with submit(), which signals a timeline semaphore. Every
+    // frame submission waits on the last signalled value on the gpu, so resources uploaded before
+    // submit() can be drawn in that same frame without the cpu ever waiting on the copy.
+    //
+    // With a dedicated transfer family the resources change queue family ownership: the release is
+    // recorded in the batch and the matching acquire into the frame's command buffer.
+    //
+    // Upload calls are thread safe. Uploads that don't fit in the free part of the ring get a
+    // temporary staging buffer instead of waiting for the ring to drain. A destination must stay
+    // alive until its upload is complete.
+    class UploadManager
+    {
+        public:
+            static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+            // stages that can read uploads, frame submissions wait on the semaphore at these
+            static constexpr VkPipelineStageFlags WAIT_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            UploadManager(Device &device);
+            ~UploadManager();
+
+            UploadManager(const UploadManager &) = delete;
+            UploadManager &operator=(const UploadManager &) = delete;
+
+            // the returned ticket is complete once the copy has finished on the gpu
+            uint64_t uploadBuffer(VkBuffer buffer, const void *data, VkDeviceSize size, VkDeviceSize bufferOffset = 0);
+            // uploads tightly packed layers of layerSize bytes and leaves the image in shader read only layout
+            uint64_t uploadImage(VkImage image, const std::vector<const void *> &layers, VkDeviceSize layerSize, VkExtent3D extent);
+
+            // submits the open batch and records the ownership acquires of every submitted batch into
+            // commandBuffer, called once per frame before anything is recorded that reads uploads
+            void submit(VkCommandBuffer commandBuffer);
+            bool isComplete(uint64_t ticket);
+            // blocks until every submitted batch has finished
+            void waitIdle();
+
+            // frame submissions wait on this semaphore reaching getSubmittedValue()
+            VkSemaphore getSemaphore() const { return timelineSemaphore; }
+            uint64_t getSubmittedValue() const { return submittedValue; }
+
+        private:
+            struct StagingBuffer
+            {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                Allocation allocation{};
+            };
+
+            struct Batch
+            {
+                VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+                uint64_t value = 0;
+                // the ring is free up to here once the batch is complete
+                VkDeviceSize ringEnd = 0;
+                std::vector<StagingBuffer> temporaryBuffers;
+            };
+
+            // copies the chunks back to back into the ring, or into a temporary buffer of the open batch
+            // when the ring is short on space, and returns the buffer and offset they landed at
+            VkBuffer stage(const std::vector<const void *> &chunks, VkDeviceSize chunkSize, VkDeviceSize &offset);
+            VkCommandBuffer openBatch();
+            void reclaim(uint64_t completedValue);
+            uint64_t completedValue();
+            bool ownershipTransfer() const { return transferFamily != graphicsFamily; }
+
+            Device &device;
+            uint32_t transferFamily;
+            uint32_t graphicsFamily;
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+            StagingBuffer ring{};
+            // monotonic byte positions, the ring offset is position % STAGING_RING_SIZE
+            VkDeviceSize ringHead = 0;
+            VkDeviceSize ringTail = 0;
+
+            std::mutex mutex;
+            Batch open{};
+            std::deque<Batch> inFlight;
+            std::vector<VkCommandBuffer> freeCommandBuffers;
+            std::vector<VkBufferMemoryBarrier> bufferAcquires;
+            std::vector<VkImageMemoryBarrier> imageAcquires;
+            std::atomic<uint64_t> submittedValue{0};
+    };
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace mnlt 
@@ -12,4 +14,15 @@ namespace mnlt
     (hashCombine(seed, rest), ...);
     };
 
+    // 64 bit FNV-1a, stable across runs and platforms unlike std::hash, continue a hash by passing it as seed
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t seed = 14695981039346656037ull) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+    }
+
 } 
\ No newline at end of file
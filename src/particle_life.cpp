@@ -4,6 +4,7 @@
 #include "mnlt/game_object.hpp"
 
 #include <glm/common.hpp>
+#include <chrono>
 #include <random>
 
 void PartcleLife::start()
@@ -13,8 +14,10 @@ void PartcleLife::start()
 
     ui.initialize(renderer.getSwapChainRenderPass(), renderer.getImageCount(), globalPool->getDescriptorPool());
     simpleRenderSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+    particleRenderSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
     pointLightSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
     gridSystem.createRenderer(renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+    particleLifeCompute.createPipeline();
 
     PartcleType p1{"red", {1.f, 0.f, 0.f}, 50};
     particleLifeSystem.particleTypes.push_back(p1);
@@ -24,17 +27,18 @@ void PartcleLife::start()
     particleLifeSystem.particleTypes.push_back(p3);
     PartcleType p4{"white", {1.f, 1.f, 1.f}, 50};
     particleLifeSystem.particleTypes.push_back(p4);
-    particleLifeSystem.createParticles(&gameObjectManager);
+    particleLifeSystem.createParticles();
 }
 void PartcleLife::renderSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo)
 {
     simpleRenderSystem.renderGameObjects(frameInfo);
+    particleLifeSystem.renderParticles(frameInfo, particleRenderSystem, particleLifeCompute);
     pointLightSystem.renderLights(frameInfo, ubo);
     if(camera.enableGrid)
         gridSystem.render(frameInfo);
     ui.newFrame();
     ui.runExample(frameInfo);
-    particleLifeSystem.createParticleLifeUI(&gameObjectManager);
+    particleLifeSystem.createParticleLifeUI();
     ui.render(commandBuffer);
 }
 void PartcleLife::update(mnlt::Time time)
@@ -42,83 +46,272 @@ void PartcleLife::update(mnlt::Time time)
     camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), 0.1f, 1000.f);
     camera.move(window.getGLFWwindow(), time.getPureDeltaTime());
 
-    particleLifeSystem.updateParticleLife(time);
+    particleLifeSystem.updateParticleLife(time, particleLifeCompute);
+}
+void PartcleLife::computeSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo)
+{
+    simpleRenderSystem.cullGameObjects(frameInfo);
+    particleLifeSystem.computeParticleLife(commandBuffer, particleLifeCompute);
 }
 
-void ParticleLifeSystem::createParticles(mnlt::GameObjectManager* particleObjectsManager)
+void ParticleLifeSystem::createParticles()
 {
-    for(auto& pt : particleTypes)
+    particles.clear();
+    typeOffsets.assign(1, 0);
+    for(uint32_t type = 0; type < particleTypes.size(); type++)
     {
+        auto& pt = particleTypes[type];
         for(auto& paty : particleTypes)
         {
             pt.attraction.push_back(randomFloat(-1.f, 1.f));
         }
         for(int i=0; i<pt.numOfParticles; i++)
         {
-            auto& obj = particleObjectsManager->createGameObject();
-            obj.color = pt.color;
-            obj.model = model;
-            obj.transform.scale = glm::vec3(0.01f);
-            obj.transform.translation = random3DPosition(lowerBound, upperBound);
-            obj.rigidBody.mass = randomFloat(0, 100);
-         
-            pt.particles.push_back(&obj);
+            particles.addParticle(random3DPosition(lowerBound, upperBound), randomFloat(0, 100), type);
         }
+        typeOffsets.push_back(static_cast<uint32_t>(particles.size()));
     }
+    gpuStateStale = true;
 }
-void ParticleLifeSystem::updateParticleLife(mnlt::Time time) 
+void ParticleLifeSystem::updateParticleLife(mnlt::Time time, mnlt::ParticleComputeSystem& computeSystem) 
 {
-    for (auto& type1 : particleTypes) 
+    if (gpuRequested && particleTypes.size() > mnlt::ParticleComputeSystem::MAX_TYPES)
+    {
+        gpuRequested = false;
+    }
+    if (gpuRequested != simulateOnGpu)
+    {
+        // the gpu keeps the particles in store order, so the type ranges stay valid after a download
+        if (gpuRequested)
+            computeSystem.upload(particles);
+        else
+            computeSystem.download(particles);
+        simulateOnGpu = gpuRequested;
+        gpuStateStale = false;
+        gpuCheckPending = false;
+    }
+    else if (simulateOnGpu && gpuStateStale)
+    {
+        computeSystem.upload(particles);
+        gpuStateStale = false;
+        gpuCheckPending = false;
+    }
+    if (simulateOnGpu)
     {
-        for (auto& type2 : particleTypes) 
+        gpuDeltaTime = static_cast<float>(time.getDeltaTime());
+        if (gpuCheckPending)
+            finishGpuCheck(computeSystem);
+        if (gpuCheckRequested)
+            startGpuCheck(computeSystem, gpuDeltaTime);
+        return;
+    }
+
+    auto stepStart = std::chrono::high_resolution_clock::now();
+    sortParticles();
+
+    nextPositions.resize(particles.size());
+    float deltaTime = static_cast<float>(time.getDeltaTime());
+    // particles only read start-of-step positions and write their own slots, so chunks are independent
+    jobSystem.parallelFor(particles.size(), 64, [&](size_t begin, size_t end)
+    {
+        particlePhysics(begin, end, deltaTime);
+    });
+    jobSystem.parallelFor(particles.size(), 1024, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
         {
-            particleTypePhysics(type1, type2, time.getDeltaTime());
+            particles.setPosition(i, nextPositions[i]);
         }
+    });
+    stepMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - stepStart).count();
+}
+void ParticleLifeSystem::startGpuCheck(mnlt::ParticleComputeSystem& computeSystem, float deltaTime)
+{
+    gpuCheckRequested = false;
+    if (particles.size() == 0) return;
+
+    // the gpu doesn't care about the order, so it gets the one the cpu step sorts the particles into
+    computeSystem.download(particles);
+    sortParticles();
+    computeSystem.upload(particles);
+
+    // leaves the expected velocities in the store and the positions in nextPositions, the store is
+    // only read again when the gpu state is downloaded
+    nextPositions.resize(particles.size());
+    jobSystem.parallelFor(particles.size(), 64, [&](size_t begin, size_t end)
+    {
+        particlePhysics(begin, end, deltaTime);
+    });
+    gpuCheckPending = true;
+}
+void ParticleLifeSystem::finishGpuCheck(mnlt::ParticleComputeSystem& computeSystem)
+{
+    gpuCheckPending = false;
+    if (computeSystem.getParticleCount() != particles.size()) return;
+
+    mnlt::ParticleStore gpuStep = particles;
+    computeSystem.download(gpuStep);
+
+    // forces are summed in a different order on the gpu, so the two only agree up to rounding
+    maxPositionDifference = 0.f;
+    maxVelocityDifference = 0.f;
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        glm::vec3 positionDifference = glm::abs(gpuStep.getPosition(i) - nextPositions[i]);
+        glm::vec3 velocityDifference = glm::abs(gpuStep.getVelocity(i) - particles.getVelocity(i));
+        maxPositionDifference = glm::max(maxPositionDifference, glm::max(positionDifference.x, glm::max(positionDifference.y, positionDifference.z)));
+        maxVelocityDifference = glm::max(maxVelocityDifference, glm::max(velocityDifference.x, glm::max(velocityDifference.y, velocityDifference.z)));
     }
-    
+    particles = std::move(gpuStep);
 }
-void ParticleLifeSystem::particleTypePhysics(PartcleType& type1, PartcleType& type2, float deltaTime)
+void ParticleLifeSystem::sortParticles()
 {
-    float g = type1.attraction[type2.getId()] / -100;
-    
-    for(auto& p1 : type1.particles)
+    // forces are zero past radiusOfAttraction, so cells of that size only need their 26 neighbours checked.
+    // sorting each type's slots by cell turns every neighbour row into one linear run through the store
+    typeGrids.resize(particleTypes.size());
+    jobSystem.parallelFor(particleTypes.size(), 1, [&](size_t begin, size_t end)
     {
-        glm::vec3 totalForce{0};
+        for (size_t type = begin; type < end; type++)
+        {
+            uint32_t first = typeOffsets[type];
+            typeGrids[type].build(
+                particles.positionX.data() + first,
+                particles.positionY.data() + first,
+                particles.positionZ.data() + first,
+                typeOffsets[type + 1] - first,
+                lowerBound,
+                upperBound,
+                radiusOfAttraction);
+        }
+    });
+    // the store reorders through shared scratch arrays, so this part stays on one thread
+    for (size_t type = 0; type < particleTypes.size(); type++)
+    {
+        particles.reorder(typeOffsets[type], typeGrids[type].getSortedIndices());
+    }
+}
+glm::vec3 ParticleLifeSystem::typeForce(glm::vec3 position, uint32_t type) const
+{
+    float radiusSquared = radiusOfAttraction * radiusOfAttraction;
+    uint32_t first = typeOffsets[type];
+    const auto& kernels = mnlt::getForceKernels(simdLevel);
+    glm::vec3 totalForce{0};
 
-        for(auto& p2 : type2.particles)
+    typeGrids[type].forEachNeighbourRange(position, [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t j = first + begin;
+        totalForce += kernels.particleForce(
+            particles.positionX.data() + j,
+            particles.positionY.data() + j,
+            particles.positionZ.data() + j,
+            particles.mass.data() + j,
+            end - begin,
+            position,
+            radiusSquared);
+    });
+    return totalForce;
+}
+void ParticleLifeSystem::particlePhysics(size_t begin, size_t end, float deltaTime)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        auto& attraction = particleTypes[particles.typeId[i]].attraction;
+        glm::vec3 position = particles.getPosition(i);
+        glm::vec3 velocity = particles.getVelocity(i);
+        glm::vec3 nextPosition = position;
+
+        // each type pulls on the particle in turn, same as the pairwise loop this replaced
+        for (uint32_t type2 = 0; type2 < particleTypes.size(); type2++)
         {
-            glm::vec3 direction = p1->transform.translation - p2->transform.translation;
-            float distanceSquared = glm::dot(direction, direction);
+            float g = attraction[type2] / -100;
+            glm::vec3 totalForce = typeForce(position, type2) * particles.mass[i];
 
-            if(p1->transform.translation != p2->transform.translation)
-            {
-                float force = distanceSquared < radiusOfAttraction*radiusOfAttraction ? (1.0f / sqrt(distanceSquared) * p1->rigidBody.mass * p2->rigidBody.mass): 0.0f;
-                totalForce += direction * force;
-            }
+            velocity = deltaTime * (velocity + (totalForce * g)) * (1.0f - viscosity);
+            nextPosition += deltaTime * velocity;
         }
 
-        p1->rigidBody.velocity = deltaTime * (p1->rigidBody.velocity + (totalForce * g)) * (1.0f - viscosity);
-        p1->transform.translation += deltaTime * p1->rigidBody.velocity;
+        if(isBounded)
+        {
+            nextPosition = glm::min(glm::max(nextPosition, lowerBound), upperBound);
+        }
+        particles.setVelocity(i, velocity);
+        nextPositions[i] = nextPosition;
     }
+}
+void ParticleLifeSystem::computeParticleLife(VkCommandBuffer commandBuffer, mnlt::ParticleComputeSystem& computeSystem)
+{
+    if (!simulateOnGpu) return;
 
-    if(isBounded)
+    uint32_t typeCount = static_cast<uint32_t>(particleTypes.size());
+    std::vector<float> attraction;
+    std::vector<glm::vec4> colors;
+    attraction.reserve(typeCount * typeCount);
+    for (auto& pt : particleTypes)
     {
-        for(auto& p1 : type1.particles)
-        {
-            p1->transform.translation = glm::min(glm::max(p1->transform.translation, lowerBound), upperBound);
-        }
+        attraction.insert(attraction.end(), pt.attraction.begin(), pt.attraction.end());
+        colors.push_back(glm::vec4(pt.color, 1.f));
     }
+
+    ParticleLifePushConstants push{};
+    push.lowerBound = glm::vec4(lowerBound, radiusOfAttraction);
+    push.upperBound = glm::vec4(upperBound, viscosity);
+    push.deltaTime = gpuDeltaTime;
+    push.particleScale = particleScale;
+    push.particleCount = computeSystem.getParticleCount();
+    push.typeCount = typeCount;
+    push.bounded = isBounded ? 1 : 0;
+
+    // runs every frame, even paused, since the step also writes the instances that get drawn
+    computeSystem.beginDispatches(commandBuffer, attraction, colors);
+    computeSystem.dispatch(commandBuffer, &push);
+    computeSystem.endDispatches(commandBuffer);
 }
+void ParticleLifeSystem::renderParticles(mnlt::FrameInfo& frameInfo, mnlt::ParticleRenderSystem& particleRenderSystem, mnlt::ParticleComputeSystem& computeSystem)
+{
+    if (simulateOnGpu)
+    {
+        particleRenderSystem.renderParticles(frameInfo, *model, computeSystem.getInstanceBuffer(), computeSystem.getParticleCount());
+        return;
+    }
 
-void ParticleLifeSystem::createParticleLifeUI(mnlt::GameObjectManager* particleObjectsManager)
+    typeColors.clear();
+    for (auto& pt : particleTypes)
+    {
+        typeColors.push_back(pt.color);
+    }
+    particleRenderSystem.renderParticles(frameInfo, *model, particles, typeColors, particleScale);
+}
+
+void ParticleLifeSystem::createParticleLifeUI()
 {
     ImGui::Begin("Particle Life");
     ImGui::Checkbox("Bounded", &isBounded);
     ImGui::DragFloat("Radius", &radiusOfAttraction, 0.01f, 0.f, 10.f);
     ImGui::DragFloat("Viscosity", &viscosity, 0.01f, 0.1f, 2.f);
+    if (ImGui::BeginCombo("Force Kernel", mnlt::simdLevelName(simdLevel)))
+    {
+        for (auto level : mnlt::supportedSimdLevels())
+        {
+            if (ImGui::Selectable(mnlt::simdLevelName(level), level == simdLevel))
+                simdLevel = level;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::Checkbox("Simulate on GPU", &gpuRequested);
+    if (simulateOnGpu)
+    {
+        ImGui::Text("Step: on the gpu (%zu particles)", particles.size());
+        if (ImGui::Button("Check a step against the cpu"))
+            gpuCheckRequested = true;
+        if (maxPositionDifference >= 0.f)
+            ImGui::Text("Last check: positions within %g, velocities within %g", maxPositionDifference, maxVelocityDifference);
+    }
+    else
+        ImGui::Text("Step: %.3f ms (%zu particles, %u workers)", stepMilliseconds, particles.size(), jobSystem.getWorkerCount() + 1);
     static int selectedpt;
-    for(auto& pt : particleTypes)
+    for(uint32_t type = 0; type < particleTypes.size(); type++)
     {
+        auto& pt = particleTypes[type];
         std::string str = "Particle Type " + pt.name;
         bool isSelected = (pt.getId() == selectedpt);
 
@@ -141,21 +334,16 @@ void ParticleLifeSystem::createParticleLifeUI(mnlt::GameObjectManager* particleO
                 ImGui::Text("Particle %s Forces:", particleTypes[i].name.c_str());
                 ImGui::DragFloat(atractLabel.c_str(), &pt.attraction.at(i), 0.01f, -1.f, 1.f);
             }
+            // colors are looked up by type when rendering, so only a count change needs a rebuild
             if(ImGui::Button("Update"))
             {
-                if(pt.particles.size() != pt.numOfParticles)
+                if(typeOffsets[type + 1] - typeOffsets[type] != static_cast<uint32_t>(pt.numOfParticles))
                 {
-                    particleObjectsManager->gameObjects.clear();
                     for(auto& paty : particleTypes)
                     {
-                        paty.particles.clear();
                         paty.attraction.clear();
                     }
-                    createParticles(particleObjectsManager);
-                }
-                for(auto &p : pt.particles)
-                {
-                    p->color = pt.color;
+                    createParticles();
                 }
             }
             ImGui::End();
@@ -3,7 +3,12 @@
 #include "mnlt/app.hpp"
 #include "mnlt/game_object.hpp"
 #include "mnlt/model.hpp"
+#include "mnlt/compute_systems/particle_compute_system.hpp"
+#include "mnlt/physics/force_kernels.hpp"
+#include "mnlt/physics/particle_store.hpp"
+#include "mnlt/physics/spatial_grid.hpp"
 #include "mnlt/render_systems/3d_grid_system.hpp"
+#include "mnlt/render_systems/particle_render_system.hpp"
 #include "mnlt/render_systems/point_light_system.hpp"
 #include "mnlt/render_systems/simple_render_system.hpp"
 #include "mnlt/ui.hpp"
@@ -20,7 +25,6 @@ class PartcleType
         std::string name = "Particle " + std::to_string(getId());
         glm::vec3 color;
         int numOfParticles;
-        std::vector<mnlt::GameObject*> particles;
         std::vector<float> attraction;
         int getId() const { return id; }
 
@@ -30,25 +34,77 @@ class PartcleType
         static inline int nextId;
         int id;
 };
+// push constants of shaders/particle_life.comp
+struct ParticleLifePushConstants
+{
+    glm::vec4 lowerBound;  // w is the radius of attraction
+    glm::vec4 upperBound;  // w is the viscosity
+    float deltaTime;
+    float particleScale;
+    uint32_t particleCount;
+    uint32_t typeCount;
+    uint32_t bounded;
+};
 class ParticleLifeSystem
 {
     public:
-        ParticleLifeSystem(std::shared_ptr<mnlt::Model> model, glm::vec3 lowerBound, glm::vec3 upperBound) : model{model}, lowerBound{lowerBound}, upperBound{upperBound} {}
-        void createParticles(mnlt::GameObjectManager* particleObjectsManager);
-        void createParticleLifeUI(mnlt::GameObjectManager* particleObjectsManager);
+        ParticleLifeSystem(mnlt::JobSystem& jobSystem, std::shared_ptr<mnlt::Model> model, glm::vec3 lowerBound, glm::vec3 upperBound)
+         : lowerBound{lowerBound}, upperBound{upperBound}, jobSystem{jobSystem}, model{model} {}
+        void createParticles();
+        void createParticleLifeUI();
+        void renderParticles(mnlt::FrameInfo& frameInfo, mnlt::ParticleRenderSystem& particleRenderSystem, mnlt::ParticleComputeSystem& computeSystem);
         glm::vec3 random3DPosition(glm::vec3 lowerBound, glm::vec3 upperBound);
         float randomFloat(float min, float max);
-        void updateParticleLife(mnlt::Time time);
-        void particleTypePhysics(PartcleType& type1, PartcleType& type2, float deltaTime);
+        // steps the particles on the cpu, or hands the step to computeParticleLife when simulating on the gpu.
+        // moving between the two only happens here, where no command buffer refers to the gpu state
+        void updateParticleLife(mnlt::Time time, mnlt::ParticleComputeSystem& computeSystem);
+        void computeParticleLife(VkCommandBuffer commandBuffer, mnlt::ParticleComputeSystem& computeSystem);
+        // steps the particles in slots [begin, end), safe to run on disjoint ranges in parallel
+        void particlePhysics(size_t begin, size_t end, float deltaTime);
 
         std::vector<PartcleType> particleTypes;
+        // particles are kept sorted by type and then by grid cell,
+        // type t owns the slots [typeOffsets[t], typeOffsets[t + 1])
+        mnlt::ParticleStore particles;
         
     private:
+        void sortParticles();
+        glm::vec3 typeForce(glm::vec3 position, uint32_t type) const;
+        // steps the gpu state on the cpu as well, from the same particles in the same slots, the
+        // dispatch of this frame then runs the same step and finishGpuCheck compares the two
+        void startGpuCheck(mnlt::ParticleComputeSystem& computeSystem, float deltaTime);
+        void finishGpuCheck(mnlt::ParticleComputeSystem& computeSystem);
+
+        // one broadphase grid per particle type, rebuilt at the start of every step
+        std::vector<mnlt::SpatialGrid> typeGrids;
+        std::vector<uint32_t> typeOffsets;
+        std::vector<glm::vec3> typeColors;
+
+        // every particle reads the positions from the start of the step and writes its
+        // result here, which keeps the step independent of the order particles are visited in
+        std::vector<glm::vec3> nextPositions;
+
         bool isBounded = true;
         float viscosity = 0.1f;
         float radiusOfAttraction = 0.5;
+        float particleScale = 0.01f;
+        // switchable at runtime so the simd paths can be compared against the scalar one
+        mnlt::SimdLevel simdLevel = mnlt::bestSimdLevel();
+        float stepMilliseconds = 0.f;
+        // the gpu step is a brute force O(n^2) pass, but it never leaves the gpu, the store is only
+        // written back when switching to the cpu again
+        bool simulateOnGpu = false;
+        bool gpuRequested = false;
+        bool gpuStateStale = false;
+        float gpuDeltaTime = 0.f;
+        bool gpuCheckRequested = false;
+        bool gpuCheckPending = false;
+        // how far the gpu step ended up from the cpu one, negative before the first check
+        float maxPositionDifference = -1.f;
+        float maxVelocityDifference = -1.f;
         glm::vec3 lowerBound;
         glm::vec3 upperBound;
+        mnlt::JobSystem& jobSystem;
         std::shared_ptr<mnlt::Model> model;
 };
 class PartcleLife : public mnlt::App 
@@ -57,11 +113,14 @@ class PartcleLife : public mnlt::App
         void start() override;
         void renderSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
         void update(mnlt::Time time) override;
+        void computeSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
 
     private:
-        ParticleLifeSystem particleLifeSystem{mnlt::Model::createModelFromFile(device, "assets/models/sphere.obj"), {-1.f,-1.f,-1.f}, {1.f,1.f,1.f}};
+        ParticleLifeSystem particleLifeSystem{jobSystem, assets.getCache().getModel("assets/models/sphere.obj"), {-1.f,-1.f,-1.f}, {1.f,1.f,1.f}};
 
-        mnlt::SimpleRenderSystem simpleRenderSystem{device};
+        mnlt::SimpleRenderSystem simpleRenderSystem{device, textureTable};
+        mnlt::ParticleRenderSystem particleRenderSystem{device};
+        mnlt::ParticleComputeSystem particleLifeCompute{device, *globalPool, "shaders/particle_life.comp.spv", sizeof(ParticleLifePushConstants)};
         mnlt::PointLightSystem pointLightSystem{device};
         mnlt::GridSystem gridSystem{device};
         mnlt::UI ui{window, device};
@@ -12,12 +12,13 @@ class TestApp : public mnlt::App
     public:
         void start() override;
         void renderSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
+        void computeSystems(VkCommandBuffer commandBuffer, mnlt::FrameInfo frameInfo) override;
         void update(mnlt::Time time) override;
 
     private:
         void loadGameObjects();
 
-        mnlt::SimpleRenderSystem simpleRenderSystem{device};
+        mnlt::SimpleRenderSystem simpleRenderSystem{device, textureTable};
         mnlt::PointLightSystem pointLightSystem{device};
         mnlt::GridSystem gridSystem{device};
         mnlt::UI ui{window, device};
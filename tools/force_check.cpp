@@ -0,0 +1,204 @@
+#include "mnlt/physics/force_kernels.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks that every simd level of the force kernels returns the same bits as the scalar path, then
+// times each of them on an all pairs loop.
+//
+//   force_check [body count]
+//
+// The body count of the timings defaults to 4096. Exits with a failure when any level differs.
+namespace
+{
+    constexpr float RADIUS_SQUARED = 0.25f;
+    constexpr float STRENGTH = 0.5f;
+    constexpr float MIN_DISTANCE_SQUARED = 0.01f;
+
+    struct Bodies
+    {
+        std::vector<float> positionX, positionY, positionZ, mass;
+        std::vector<float> accelerationX, accelerationY, accelerationZ;
+
+        size_t size() const { return mass.size(); }
+    };
+
+    // some bodies share the query point and some sit closer than the minimum distance, so every
+    // branch of the masks gets taken
+    Bodies randomBodies(std::mt19937 &random, size_t count, glm::vec3 query)
+    {
+        std::uniform_real_distribution<float> position{-1.f, 1.f};
+        std::uniform_real_distribution<float> mass{0.1f, 10.f};
+        std::uniform_real_distribution<float> acceleration{-1.f, 1.f};
+        std::uniform_int_distribution<int> kind{0, 9};
+
+        Bodies bodies{};
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec3 p{position(random), position(random), position(random)};
+            int k = kind(random);
+            if (k == 0) p = query;
+            if (k == 1) p = query + glm::vec3{0.01f, 0.f, 0.02f};
+            bodies.positionX.push_back(p.x);
+            bodies.positionY.push_back(p.y);
+            bodies.positionZ.push_back(p.z);
+            bodies.mass.push_back(mass(random));
+            bodies.accelerationX.push_back(acceleration(random));
+            bodies.accelerationY.push_back(acceleration(random));
+            bodies.accelerationZ.push_back(acceleration(random));
+        }
+        return bodies;
+    }
+
+    bool sameBits(glm::vec3 a, glm::vec3 b)
+    {
+        return std::memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    bool sameBits(const std::vector<float> &a, const std::vector<float> &b)
+    {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), sizeof(float) * a.size()) == 0);
+    }
+
+    bool checkLevel(const Bodies &bodies, glm::vec3 query, mnlt::SimdLevel level)
+    {
+        const auto &scalar = mnlt::getForceKernels(mnlt::SimdLevel::Scalar);
+        const auto &kernels = mnlt::getForceKernels(level);
+        size_t count = bodies.size();
+        const char *name = mnlt::simdLevelName(level);
+        bool passed = true;
+
+        glm::vec3 expected = scalar.particleForce(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query, RADIUS_SQUARED);
+        glm::vec3 result = kernels.particleForce(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query, RADIUS_SQUARED);
+        if (!sameBits(expected, result))
+        {
+            std::cerr << name << ": particleForce over " << count << " bodies differs from the scalar path" << std::endl;
+            passed = false;
+        }
+
+        expected = scalar.gravityAcceleration(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query,
+            STRENGTH, MIN_DISTANCE_SQUARED);
+        result = kernels.gravityAcceleration(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query,
+            STRENGTH, MIN_DISTANCE_SQUARED);
+        if (!sameBits(expected, result))
+        {
+            std::cerr << name << ": gravityAcceleration over " << count << " bodies differs from the scalar path" << std::endl;
+            passed = false;
+        }
+
+        // gravityPairs also writes the reactions, which have to match as well
+        Bodies expectedBodies = bodies;
+        Bodies resultBodies = bodies;
+        expected = scalar.gravityPairs(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query,
+            2.f, STRENGTH, MIN_DISTANCE_SQUARED,
+            expectedBodies.accelerationX.data(), expectedBodies.accelerationY.data(), expectedBodies.accelerationZ.data());
+        result = kernels.gravityPairs(
+            bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), count, query,
+            2.f, STRENGTH, MIN_DISTANCE_SQUARED,
+            resultBodies.accelerationX.data(), resultBodies.accelerationY.data(), resultBodies.accelerationZ.data());
+        if (!sameBits(expected, result)
+            || !sameBits(expectedBodies.accelerationX, resultBodies.accelerationX)
+            || !sameBits(expectedBodies.accelerationY, resultBodies.accelerationY)
+            || !sameBits(expectedBodies.accelerationZ, resultBodies.accelerationZ))
+        {
+            std::cerr << name << ": gravityPairs over " << count << " bodies differs from the scalar path" << std::endl;
+            passed = false;
+        }
+        return passed;
+    }
+
+    template <typename F>
+    double milliseconds(F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [body count]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t bodyCount = argc == 2 ? std::stoul(argv[1]) : 4096;
+
+    // every tail length on its own and after full blocks of 8
+    std::mt19937 random{1234};
+    std::uniform_real_distribution<float> position{-1.f, 1.f};
+    bool passed = true;
+    for (size_t count = 0; count <= 67; count++)
+    {
+        glm::vec3 query{position(random), position(random), position(random)};
+        Bodies bodies = randomBodies(random, count, query);
+        for (mnlt::SimdLevel level : mnlt::supportedSimdLevels())
+        {
+            passed = checkLevel(bodies, query, level) && passed;
+        }
+    }
+    std::cout << "force kernels match the scalar path on every level: " << (passed ? "yes" : "no") << std::endl;
+
+    // the loops the particle life and gravity steps run, every body against all of them
+    Bodies bodies = randomBodies(random, bodyCount, glm::vec3{0.f});
+    double pairs = static_cast<double>(bodyCount) * static_cast<double>(bodyCount);
+    for (mnlt::SimdLevel level : mnlt::supportedSimdLevels())
+    {
+        const auto &kernels = mnlt::getForceKernels(level);
+        glm::vec3 total{0.f};
+        double particleForce = milliseconds([&]
+        {
+            for (size_t i = 0; i < bodyCount; i++)
+            {
+                glm::vec3 query{bodies.positionX[i], bodies.positionY[i], bodies.positionZ[i]};
+                total += kernels.particleForce(
+                    bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(),
+                    bodyCount, query, RADIUS_SQUARED);
+            }
+        });
+        double gravityAcceleration = milliseconds([&]
+        {
+            for (size_t i = 0; i < bodyCount; i++)
+            {
+                glm::vec3 query{bodies.positionX[i], bodies.positionY[i], bodies.positionZ[i]};
+                total += kernels.gravityAcceleration(
+                    bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(),
+                    bodyCount, query, STRENGTH, MIN_DISTANCE_SQUARED);
+            }
+        });
+        // every pair once, so half the pairs of the other two
+        Bodies reactions = bodies;
+        double gravityPairs = milliseconds([&]
+        {
+            for (size_t i = 0; i < bodyCount; i++)
+            {
+                glm::vec3 query{bodies.positionX[i], bodies.positionY[i], bodies.positionZ[i]};
+                size_t j = i + 1;
+                total += kernels.gravityPairs(
+                    bodies.positionX.data() + j, bodies.positionY.data() + j, bodies.positionZ.data() + j, bodies.mass.data() + j,
+                    bodyCount - j, query, bodies.mass[i], STRENGTH, MIN_DISTANCE_SQUARED,
+                    reactions.accelerationX.data() + j, reactions.accelerationY.data() + j, reactions.accelerationZ.data() + j);
+            }
+        });
+
+        // printing the sums keeps the loops from being optimized away
+        std::cout << mnlt::simdLevelName(level) << ", " << bodyCount << " bodies: particleForce " << particleForce << " ms ("
+                  << pairs / particleForce / 1e3 << " M pairs/s), gravityAcceleration " << gravityAcceleration << " ms ("
+                  << pairs / gravityAcceleration / 1e3 << " M pairs/s), gravityPairs " << gravityPairs << " ms ("
+                  << pairs * 0.5 / gravityPairs / 1e3 << " M pairs/s), sum " << total.x + total.y + total.z << std::endl;
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,205 @@
+#include "mnlt/physics/barnes_hut.hpp"
+#include "mnlt/physics/force_kernels.hpp"
+#include "mnlt/physics/integrator.hpp"
+#include "mnlt/physics/particle_store.hpp"
+
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks the gravity solvers and integrators the gravity app runs, then times the solvers.
+//
+//   gravity_check [body count]
+//
+// - Barnes-Hut with theta = 0 has to give the direct sum back up to summation order, and theta = 0.5
+//   has to stay close to it.
+// - Every integrator steps a sun with planets on circular orbits and has to keep its energy.
+// - Velocity verlet may only evaluate the forces once per step.
+//
+// The body count of the timings defaults to 8192. Exits with a failure when any check fails.
+namespace
+{
+    constexpr float STRENGTH = 1.f;
+    // same cutoff GravityPhysicsSystem uses
+    constexpr float MIN_DISTANCE_SQUARED = 0.1f;
+
+    // rms of the error relative to the rms acceleration, like the gravity app's diagnostics
+    constexpr double EXACT_TOLERANCE = 1e-5;
+    constexpr double APPROXIMATE_THETA = 0.5;
+    constexpr double APPROXIMATE_TOLERANCE = 1e-2;
+
+    // relative energy change over ORBIT_STEPS steps of ORBIT_DELTA_TIME, a few inner orbits
+    constexpr int ORBIT_STEPS = 2000;
+    constexpr float ORBIT_DELTA_TIME = 0.005f;
+    constexpr double EULER_DRIFT_TOLERANCE = 1e-3;
+    constexpr double VERLET_DRIFT_TOLERANCE = 1e-5;
+    constexpr double RUNGE_KUTTA_DRIFT_TOLERANCE = 1e-5;
+
+    mnlt::ParticleStore randomCluster(std::mt19937 &random, size_t count)
+    {
+        std::uniform_real_distribution<float> position{-10.f, 10.f};
+        std::uniform_real_distribution<float> mass{0.5f, 2.f};
+        mnlt::ParticleStore bodies{};
+        bodies.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            bodies.addParticle({position(random), position(random), position(random)}, mass(random), 0);
+        }
+        return bodies;
+    }
+
+    // a heavy sun with light planets on circular orbits, far enough apart to never reach the cutoff
+    mnlt::ParticleStore solarSystem()
+    {
+        constexpr float SUN_MASS = 1000.f;
+        mnlt::ParticleStore bodies{};
+        bodies.addParticle({0.f, 0.f, 0.f}, SUN_MASS, 0);
+        for (int planet = 0; planet < 8; planet++)
+        {
+            float radius = 5.f + 5.f * static_cast<float>(planet);
+            float angle = 0.7f * static_cast<float>(planet);
+            float speed = std::sqrt(STRENGTH * SUN_MASS / radius);
+            uint32_t body = bodies.addParticle({radius * std::cos(angle), 0.f, radius * std::sin(angle)}, 1e-3f, 0);
+            bodies.setVelocity(body, speed * glm::vec3{-std::sin(angle), 0.f, std::cos(angle)});
+        }
+        return bodies;
+    }
+
+    void directSum(const mnlt::ParticleStore &bodies, std::vector<glm::vec3> &result)
+    {
+        const auto &kernels = mnlt::getForceKernels();
+        result.resize(bodies.size());
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            result[i] = kernels.gravityAcceleration(
+                bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(),
+                bodies.size(), bodies.getPosition(i), STRENGTH, MIN_DISTANCE_SQUARED);
+        }
+    }
+
+    void barnesHut(mnlt::BarnesHutTree &tree, float theta, const mnlt::ParticleStore &bodies, std::vector<glm::vec3> &result)
+    {
+        const auto &kernels = mnlt::getForceKernels();
+        result.resize(bodies.size());
+        tree.build(bodies.positionX.data(), bodies.positionY.data(), bodies.positionZ.data(), bodies.mass.data(), bodies.size());
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            result[i] = tree.acceleration(bodies.getPosition(i), theta, STRENGTH, MIN_DISTANCE_SQUARED, kernels);
+        }
+    }
+
+    double relativeError(const std::vector<glm::vec3> &result, const std::vector<glm::vec3> &reference)
+    {
+        double errorSquared = 0.0;
+        double referenceSquared = 0.0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            glm::dvec3 error = glm::dvec3{result[i]} - glm::dvec3{reference[i]};
+            errorSquared += glm::dot(error, error);
+            referenceSquared += glm::dot(glm::dvec3{reference[i]}, glm::dvec3{reference[i]});
+        }
+        return referenceSquared > 0.0 ? std::sqrt(errorSquared / referenceSquared) : 0.0;
+    }
+
+    // kinetic plus potential energy in double, pairs inside the cutoff don't pull on each other
+    double totalEnergy(const mnlt::ParticleStore &bodies)
+    {
+        double energy = 0.0;
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            glm::dvec3 velocity{bodies.getVelocity(i)};
+            energy += 0.5 * bodies.mass[i] * glm::dot(velocity, velocity);
+            for (size_t j = i + 1; j < bodies.size(); j++)
+            {
+                glm::dvec3 offset = glm::dvec3{bodies.getPosition(j)} - glm::dvec3{bodies.getPosition(i)};
+                double distanceSquared = glm::dot(offset, offset);
+                if (distanceSquared < MIN_DISTANCE_SQUARED) continue;
+                energy -= STRENGTH * static_cast<double>(bodies.mass[i]) * bodies.mass[j] / std::sqrt(distanceSquared);
+            }
+        }
+        return energy;
+    }
+
+    bool checkSolver(const char *name, double error, double tolerance)
+    {
+        bool passed = error <= tolerance;
+        std::cout << name << ": relative error " << error << ", at most " << tolerance << (passed ? "" : ", FAILED") << std::endl;
+        return passed;
+    }
+
+    bool checkIntegrator(mnlt::IntegratorType type, double tolerance, int evaluationsPerStep)
+    {
+        mnlt::ParticleStore bodies = solarSystem();
+        auto integrator = mnlt::Integrator::create(type);
+        int evaluations = 0;
+        auto computeAccelerations = [&](const mnlt::ParticleStore &state, std::vector<glm::vec3> &result)
+        {
+            evaluations++;
+            directSum(state, result);
+        };
+
+        double initialEnergy = totalEnergy(bodies);
+        for (int step = 0; step < ORBIT_STEPS; step++)
+        {
+            integrator->step(bodies, ORBIT_DELTA_TIME, computeAccelerations);
+        }
+        double drift = std::abs((totalEnergy(bodies) - initialEnergy) / initialEnergy);
+
+        // verlet evaluates the start of its first step once and reuses the end of every step after
+        int expectedEvaluations = ORBIT_STEPS * evaluationsPerStep + (type == mnlt::IntegratorType::VelocityVerlet ? 1 : 0);
+        bool passed = drift <= tolerance && evaluations == expectedEvaluations;
+        std::cout << mnlt::Integrator::getName(type) << ", " << ORBIT_STEPS << " steps: energy drift " << drift << ", at most "
+                  << tolerance << ", " << evaluations << " force evaluations" << (passed ? "" : ", FAILED") << std::endl;
+        return passed;
+    }
+
+    template <typename F>
+    double milliseconds(F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [body count]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t bodyCount = argc == 2 ? std::stoul(argv[1]) : 8192;
+
+    std::mt19937 random{1234};
+    mnlt::BarnesHutTree tree{};
+    std::vector<glm::vec3> reference;
+    std::vector<glm::vec3> result;
+    bool passed = true;
+
+    mnlt::ParticleStore cluster = randomCluster(random, 2000);
+    directSum(cluster, reference);
+    barnesHut(tree, 0.f, cluster, result);
+    passed = checkSolver("Barnes-Hut, theta 0", relativeError(result, reference), EXACT_TOLERANCE) && passed;
+    barnesHut(tree, static_cast<float>(APPROXIMATE_THETA), cluster, result);
+    passed = checkSolver("Barnes-Hut, theta 0.5", relativeError(result, reference), APPROXIMATE_TOLERANCE) && passed;
+
+    passed = checkIntegrator(mnlt::IntegratorType::SemiImplicitEuler, EULER_DRIFT_TOLERANCE, 1) && passed;
+    passed = checkIntegrator(mnlt::IntegratorType::VelocityVerlet, VERLET_DRIFT_TOLERANCE, 1) && passed;
+    passed = checkIntegrator(mnlt::IntegratorType::RungeKutta4, RUNGE_KUTTA_DRIFT_TOLERANCE, 4) && passed;
+    std::cout << "gravity solvers and integrators within their tolerances: " << (passed ? "yes" : "no") << std::endl;
+
+    // one thread each, the gravity app splits both over the job system
+    cluster = randomCluster(random, bodyCount);
+    double direct = milliseconds([&] { directSum(cluster, reference); });
+    double approximate = milliseconds([&] { barnesHut(tree, static_cast<float>(APPROXIMATE_THETA), cluster, result); });
+    std::cout << bodyCount << " bodies: direct sum " << direct << " ms, Barnes-Hut theta 0.5 " << approximate << " ms ("
+              << tree.getNodeCount() << " nodes), relative error " << relativeError(result, reference) << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
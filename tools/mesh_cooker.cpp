@@ -0,0 +1,68 @@
+#include "mnlt/job_system.hpp"
+#include "mnlt/mesh_file.hpp"
+#include "mnlt/mesh_optimizer.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts obj files into cooked .mesh files, see mnlt/mesh_file.hpp.
+//
+//   mesh_cooker <input.obj> [output.mesh]
+//
+// The output defaults to the input with a .mesh extension, which is where
+// Model::createModelFromFile looks for it.
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <input.obj> [output.mesh]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string input = argv[1];
+    std::string output = argc == 3 ? argv[2] : mnlt::MeshFile::getCookedPath(input);
+
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        mnlt::Model::BuilderData builderData{};
+        mnlt::JobSystem jobSystem{};
+        builderData.loadModel(input, &jobSystem);
+        float missRatio = mnlt::averageCacheMissRatio(builderData.indices, builderData.vertices.size());
+        builderData.generateLods();
+        builderData.optimize();
+        const auto &fullDetail = builderData.lods[0];
+        std::vector<uint32_t> fullDetailIndices(builderData.indices.begin(), builderData.indices.begin() + fullDetail.indexCount);
+        float optimizedMissRatio = mnlt::averageCacheMissRatio(fullDetailIndices, builderData.vertices.size());
+        mnlt::MeshFile::write(output, builderData);
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        size_t vertexCount = builderData.vertices.size();
+        size_t indexCount = fullDetail.indexCount;
+        size_t size = vertexCount * sizeof(mnlt::Model::Vertex) + indexCount * sizeof(uint32_t);
+        size_t packedSize = vertexCount * sizeof(mnlt::Model::PackedVertex) + builderData.indices.size() * mnlt::Model::getIndexSize(static_cast<uint32_t>(vertexCount));
+        std::cout << input << " -> " << output << ": " << vertexCount << " vertices, " << indexCount / 3 << " triangles, "
+                  << "acmr " << missRatio << " -> " << optimizedMissRatio << ", "
+                  << size / 1024 << " KiB -> " << packedSize / 1024 << " KiB with lods in " << elapsed << " ms" << std::endl;
+        float radius = builderData.computeBoundingSphere().radius;
+        for (size_t i = 1; i < builderData.lods.size(); i++)
+        {
+            const auto &lod = builderData.lods[i];
+            std::cout << "  lod " << i << ": " << lod.indexCount / 3 << " triangles, error " << lod.error
+                      << " of radius " << radius << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
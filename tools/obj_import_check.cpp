@@ -0,0 +1,205 @@
+#include "mnlt/job_system.hpp"
+#include "mnlt/model.hpp"
+#include "mnlt/utils.hpp"
+
+// libs
+#include <tiny_obj_loader.h>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Checks ObjImporter against the tinyobjloader loader it replaced, then times both.
+//
+//   obj_import_check <file.obj>...
+//
+// Every corner of every triangle has to get the same vertex from both, up to the last bits of the
+// float parsing. Normals are only compared where the file has them, the old loader left the others
+// zero and the importer computes them. Each file is imported on the calling thread and on a job
+// system. Exits with a failure when any file differs.
+namespace
+{
+    struct VertexHash
+    {
+        size_t operator()(const mnlt::Model::Vertex &vertex) const
+        {
+            size_t seed = 0;
+            mnlt::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+            return seed;
+        }
+    };
+
+    struct OldModel
+    {
+        std::vector<mnlt::Model::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        // per corner, whether the file gave it a normal
+        std::vector<bool> hasNormal;
+    };
+
+    // the loader Model used before ObjImporter
+    OldModel loadWithTinyObj(const std::string &filepath)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+        {
+            throw std::runtime_error(warn + err);
+        }
+
+        OldModel model{};
+        std::unordered_map<mnlt::Model::Vertex, uint32_t, VertexHash> uniqueVertices{};
+        for (const auto &shape : shapes)
+        {
+            for (const auto &index : shape.mesh.indices)
+            {
+                mnlt::Model::Vertex vertex{};
+                if (index.vertex_index >= 0)
+                {
+                    vertex.position = {
+                        attrib.vertices[3 * index.vertex_index + 0],
+                        attrib.vertices[3 * index.vertex_index + 1],
+                        attrib.vertices[3 * index.vertex_index + 2],
+                    };
+                    vertex.color = {
+                        attrib.colors[3 * index.vertex_index + 0],
+                        attrib.colors[3 * index.vertex_index + 1],
+                        attrib.colors[3 * index.vertex_index + 2],
+                    };
+                }
+                if (index.normal_index >= 0)
+                {
+                    vertex.normal = {
+                        attrib.normals[3 * index.normal_index + 0],
+                        attrib.normals[3 * index.normal_index + 1],
+                        attrib.normals[3 * index.normal_index + 2],
+                    };
+                }
+                if (index.texcoord_index >= 0)
+                {
+                    vertex.uv = {
+                        attrib.texcoords[2 * index.texcoord_index + 0],
+                        attrib.texcoords[2 * index.texcoord_index + 1],
+                    };
+                }
+                vertex.layerIndex = 0;
+
+                auto it = uniqueVertices.find(vertex);
+                if (it == uniqueVertices.end())
+                {
+                    it = uniqueVertices.emplace(vertex, static_cast<uint32_t>(model.vertices.size())).first;
+                    model.vertices.push_back(vertex);
+                }
+                model.indices.push_back(it->second);
+                model.hasNormal.push_back(index.normal_index >= 0);
+            }
+        }
+        return model;
+    }
+
+    // the importer's float parser may round the last bit differently from strtod
+    bool close(float a, float b)
+    {
+        return std::abs(a - b) <= 1e-6f * std::max(1.f, std::abs(a));
+    }
+
+    bool close(glm::vec3 a, glm::vec3 b)
+    {
+        return close(a.x, b.x) && close(a.y, b.y) && close(a.z, b.z);
+    }
+
+    size_t countMismatchedCorners(const OldModel &expected, const mnlt::Model::BuilderData &result)
+    {
+        size_t mismatched = 0;
+        for (size_t corner = 0; corner < expected.indices.size(); corner++)
+        {
+            const auto &a = expected.vertices[expected.indices[corner]];
+            const auto &b = result.vertices[result.indices[corner]];
+            bool same = close(a.position, b.position) && close(a.color, b.color)
+                && close(a.uv.x, b.uv.x) && close(a.uv.y, b.uv.y)
+                && (!expected.hasNormal[corner] || close(a.normal, b.normal));
+            if (!same) mismatched++;
+        }
+        return mismatched;
+    }
+
+    template <typename F>
+    double milliseconds(F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool checkFile(const std::string &filepath, mnlt::JobSystem &jobSystem)
+    {
+        OldModel expected{};
+        mnlt::Model::BuilderData singleThreaded{};
+        mnlt::Model::BuilderData parallel{};
+        double oldTime = milliseconds([&] { expected = loadWithTinyObj(filepath); });
+        double singleThreadedTime = milliseconds([&] { singleThreaded.loadModel(filepath); });
+        double parallelTime = milliseconds([&] { parallel.loadModel(filepath, &jobSystem); });
+
+        bool passed = true;
+        for (const auto *result : {&singleThreaded, &parallel})
+        {
+            if (result->indices.size() != expected.indices.size())
+            {
+                std::cerr << filepath << ": " << result->indices.size() << " corners instead of " << expected.indices.size() << std::endl;
+                passed = false;
+                continue;
+            }
+            size_t mismatched = countMismatchedCorners(expected, *result);
+            if (mismatched > 0)
+            {
+                std::cerr << filepath << ": " << mismatched << " corners differ from tinyobjloader" << std::endl;
+                passed = false;
+            }
+        }
+
+        std::cout << filepath << ": " << expected.indices.size() / 3 << " triangles, " << expected.vertices.size()
+                  << " vertices before, " << parallel.vertices.size() << " now, tinyobjloader " << oldTime
+                  << " ms, importer " << singleThreadedTime << " ms on one thread, " << parallelTime << " ms on "
+                  << jobSystem.getWorkerCount() + 1 << " threads" << (passed ? "" : ", FAILED") << std::endl;
+        return passed;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <file.obj>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    mnlt::JobSystem jobSystem{};
+    bool passed = true;
+    for (int i = 1; i < argc; i++)
+    {
+        try
+        {
+            passed = checkFile(argv[i], jobSystem) && passed;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << argv[i] << ": " << e.what() << std::endl;
+            passed = false;
+        }
+    }
+    std::cout << "obj importer matches tinyobjloader on every file: " << (passed ? "yes" : "no") << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,178 @@
+#include "mnlt/transform_hierarchy.hpp"
+#include "mnlt/transform_kernels.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks that every simd level of composeTransforms writes the same bits as TransformComponent::mat4
+// and normalMatrix, then times it and TransformHierarchy::update on a flat scene.
+//
+//   transform_check [object count]
+//
+// The object count of the timings defaults to 100000. Exits with a failure when any level differs.
+namespace
+{
+    // the transform arrays composeTransforms reads, kept next to the components they came from
+    struct Transforms
+    {
+        std::vector<mnlt::TransformComponent> components;
+        std::vector<float> values[10];
+
+        mnlt::TransformArrays arrays() const
+        {
+            return {
+                values[0].data(), values[1].data(), values[2].data(),
+                values[3].data(), values[4].data(), values[5].data(), values[6].data(),
+                values[7].data(), values[8].data(), values[9].data()};
+        }
+    };
+
+    mnlt::TransformComponent randomTransform(std::mt19937 &random)
+    {
+        std::uniform_real_distribution<float> position{-100.f, 100.f};
+        std::uniform_real_distribution<float> angle{-3.f, 3.f};
+        std::uniform_real_distribution<float> scale{0.05f, 4.f};
+        std::bernoulli_distribution mirrored{0.1};
+
+        mnlt::TransformComponent transform{};
+        transform.translation = {position(random), position(random), position(random)};
+        transform.scale = {scale(random), scale(random), scale(random)};
+        if (mirrored(random)) transform.scale.y = -transform.scale.y;
+        transform.setEulerAngles({angle(random), angle(random), angle(random)});
+        return transform;
+    }
+
+    Transforms randomTransforms(std::mt19937 &random, size_t count)
+    {
+        Transforms transforms{};
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto &t = transforms.components.emplace_back(randomTransform(random));
+            const float values[10] = {
+                t.translation.x, t.translation.y, t.translation.z,
+                t.rotation.x, t.rotation.y, t.rotation.z, t.rotation.w,
+                t.scale.x, t.scale.y, t.scale.z};
+            for (size_t array = 0; array < 10; array++)
+            {
+                transforms.values[array].push_back(values[array]);
+            }
+        }
+        return transforms;
+    }
+
+    // written with padding between the matrices, which has to stay untouched
+    bool checkLevel(const Transforms &transforms, mnlt::SimdLevel level)
+    {
+        constexpr size_t PADDING = 32;
+        constexpr unsigned char CANARY = 0x5a;
+        constexpr size_t stride = sizeof(mnlt::TransformMatrices) + PADDING;
+        size_t count = transforms.components.size();
+
+        std::vector<unsigned char> output(count * stride, CANARY);
+        mnlt::composeTransforms(transforms.arrays(), count, output.data(), stride, level);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto &transform = transforms.components[i];
+            mnlt::TransformMatrices expected{transform.mat4(), glm::mat4{transform.normalMatrix()}};
+            const unsigned char *written = output.data() + i * stride;
+            if (std::memcmp(written, &expected, sizeof(expected)) != 0)
+            {
+                std::cerr << mnlt::simdLevelName(level) << ": transform " << i << " of " << count << " differs from mat4 and normalMatrix" << std::endl;
+                return false;
+            }
+            for (size_t byte = sizeof(expected); byte < stride; byte++)
+            {
+                if (written[byte] != CANARY)
+                {
+                    std::cerr << mnlt::simdLevelName(level) << ": transform " << i << " of " << count << " wrote past its matrices" << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <typename F>
+    double averageMilliseconds(int repeats, F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+        {
+            f();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [object count]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t objectCount = argc == 2 ? std::stoul(argv[1]) : 100000;
+
+    // every tail length on its own and after full blocks of 8
+    std::mt19937 random{1234};
+    bool passed = true;
+    for (size_t count = 0; count <= 67; count++)
+    {
+        Transforms transforms = randomTransforms(random, count);
+        for (mnlt::SimdLevel level : mnlt::supportedSimdLevels())
+        {
+            passed = checkLevel(transforms, level) && passed;
+        }
+    }
+    std::cout << "composeTransforms matches mat4 and normalMatrix on every level: " << (passed ? "yes" : "no") << std::endl;
+
+    constexpr int REPEATS = 20;
+    Transforms transforms = randomTransforms(random, objectCount);
+    std::vector<mnlt::TransformMatrices> matrices(objectCount);
+    double bytes = static_cast<double>(objectCount * sizeof(mnlt::TransformMatrices));
+    for (mnlt::SimdLevel level : mnlt::supportedSimdLevels())
+    {
+        double milliseconds = averageMilliseconds(REPEATS, [&]
+        {
+            mnlt::composeTransforms(transforms.arrays(), objectCount, matrices.data(), sizeof(mnlt::TransformMatrices), level);
+        });
+        std::cout << "composeTransforms " << mnlt::simdLevelName(level) << ", " << objectCount << " objects: "
+                  << milliseconds << " ms, " << bytes / milliseconds / 1e6 << " GB/s written" << std::endl;
+    }
+
+    // a flat scene where everything moves every update, then one where nothing does
+    mnlt::JobSystem jobSystem{};
+    mnlt::TransformHierarchy hierarchy{jobSystem};
+    mnlt::Registry registry{};
+    for (const auto &component : transforms.components)
+    {
+        mnlt::Entity entity = registry.create();
+        registry.add<mnlt::TransformComponent>(entity, component);
+        registry.add<mnlt::WorldTransformComponent>(entity);
+    }
+    hierarchy.update(registry);
+
+    auto &components = registry.pool<mnlt::TransformComponent>();
+    float offset = 0.f;
+    double moving = averageMilliseconds(REPEATS, [&]
+    {
+        offset += 1.f;
+        for (size_t i = 0; i < components.size(); i++)
+        {
+            components.data()[i].translation.x += offset;
+        }
+        hierarchy.update(registry);
+    });
+    size_t changed = hierarchy.getChangedEntities().size();
+    double still = averageMilliseconds(REPEATS, [&] { hierarchy.update(registry); });
+    std::cout << "TransformHierarchy::update, " << objectCount << " objects: " << moving << " ms with " << changed
+              << " changed, " << still << " ms with " << hierarchy.getChangedEntities().size() << " changed" << std::endl;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}